@@ -5,5 +5,8 @@
 # Build the documentation.
 option(BUILD_DOCS "Build the documentation." OFF)
 
+# Build the benchmark suite.
+option(BUILD_BENCHMARKS "Build the benchmark suite." OFF)
+
 # Build and run unit-tests.
 option(BUILD_TESTING "Build the testing tree." OFF)
@@ -7,6 +7,10 @@
 
 # Create a new named CMake target. Use this function to create an application.
 function(com_executable targetName)
+    set(optionKeywords
+        CONSOLE                     # Build a command-line tool rather than an application bundle.
+    )
+
     set(multiValueKeywords
         SOURCES                     # List of source files.
         TS_FILES                    # List of Qt Linguist files.
@@ -25,7 +29,12 @@ function(com_executable targetName)
     endif()
 
     # Define the target.
-    qt_add_executable(${targetName} MACOSX_BUNDLE WIN32 ${args_SOURCES})
+    if(args_CONSOLE)
+        qt_add_executable(${targetName} ${args_SOURCES})
+    else()
+        qt_add_executable(${targetName} MACOSX_BUNDLE WIN32 ${args_SOURCES})
+    endif(args_CONSOLE)
+
     _set_target_defaults(${targetName})
 
     # See https://cmake.org/cmake/help/latest/prop_tgt/MACOSX_BUNDLE_INFO_PLIST.html
@@ -105,6 +105,34 @@
         <source>FileMenuSaveAsTooltip</source>
         <translation>Save changes to the active document as a new file.</translation>
     </message>
+    <message>
+        <source>SculptMenu</source>
+        <translation>Sculpt</translation>
+    </message>
+    <message>
+        <source>SculptMenuSubdivide</source>
+        <translation>Subdivide</translation>
+    </message>
+    <message>
+        <source>SculptMenuSubdivideTooltip</source>
+        <translation>Add a multiresolution level above the highest, and sculpt on it.</translation>
+    </message>
+    <message>
+        <source>SculptMenuLevelUp</source>
+        <translation>Level Up</translation>
+    </message>
+    <message>
+        <source>SculptMenuLevelUpTooltip</source>
+        <translation>Sculpt on the next multiresolution level up.</translation>
+    </message>
+    <message>
+        <source>SculptMenuLevelDown</source>
+        <translation>Level Down</translation>
+    </message>
+    <message>
+        <source>SculptMenuLevelDownTooltip</source>
+        <translation>Sculpt on the next multiresolution level down.</translation>
+    </message>
 </context>
 <context>
     <name>PropertiesPanel</name>
@@ -128,7 +156,7 @@
     </message>
     <message>
         <source>primitivePolygonCountTooltip</source>
-        <translation>The minimum number of polygons to use when making a primitive.</translation>
+        <translation>The minimum number of polygons to use when making a primitive. Spheres round it up to the next count that their grid allows.</translation>
     </message>
     <message>
         <source>primitiveRadiusLabel</source>
@@ -146,6 +174,70 @@
         <source>cursorVertexCountTooltip</source>
         <translation>The number of vertices in the cursor.</translation>
     </message>
+    <message>
+        <source>brushRadiusLabel</source>
+        <translation>Brush Radius</translation>
+    </message>
+    <message>
+        <source>brushRadiusTooltip</source>
+        <translation>The radius of the sculpting brush.</translation>
+    </message>
+    <message>
+        <source>brushStrengthLabel</source>
+        <translation>Brush Strength</translation>
+    </message>
+    <message>
+        <source>brushStrengthTooltip</source>
+        <translation>The displacement applied by each sample of a brush stroke.</translation>
+    </message>
+    <message>
+        <source>framesInFlightLabel</source>
+        <translation>Frames in Flight</translation>
+    </message>
+    <message>
+        <source>framesInFlightTooltip</source>
+        <translation>The number of frames that may be rendering at once. Higher values improve throughput at the cost of latency.</translation>
+    </message>
+    <message>
+        <source>compressDocumentsLabel</source>
+        <translation>Compress Documents</translation>
+    </message>
+    <message>
+        <source>compressDocumentsTooltip</source>
+        <translation>Compress documents when saving them. Files are smaller, but take longer to save and open.</translation>
+    </message>
+    <message>
+        <source>brushFootprintSizeLabel</source>
+        <translation>Brush Footprint Size</translation>
+    </message>
+    <message>
+        <source>brushFootprintSizeTooltip</source>
+        <translation>The width and height, in pixels, of the region under the mouse whose surface is averaged to orient the brush.</translation>
+    </message>
+    <message>
+        <source>dynamicTopologyLabel</source>
+        <translation>Dynamic Topology</translation>
+    </message>
+    <message>
+        <source>dynamicTopologyTooltip</source>
+        <translation>Subdivide and simplify the mesh under the brush as you sculpt, so that detail is only added where it is needed.</translation>
+    </message>
+    <message>
+        <source>dynamicTopologyDetailLabel</source>
+        <translation>Dynamic Topology Detail</translation>
+    </message>
+    <message>
+        <source>dynamicTopologyDetailTooltip</source>
+        <translation>The length of the edges that dynamic topology creates under the brush. Smaller values add more detail.</translation>
+    </message>
+    <message>
+        <source>multiresNavigationLevelsLabel</source>
+        <translation>Multires Navigation Levels</translation>
+    </message>
+    <message>
+        <source>multiresNavigationLevelsTooltip</source>
+        <translation>The number of subdivision levels to drop while orbiting, dollying or trucking, so that the viewport stays responsive on dense sculpts.</translation>
+    </message>
 </context>
 <context>
     <name>com::scene::Document</name>
@@ -180,7 +272,7 @@
     </message>
     <message>
         <source>FileFilter</source>
-        <translation>Sculpt3D Files (*.scuplt3d);;All Files (*.*)</translation>
+        <translation>Sculpt3D Files (*.s3d);;All Files (*.*)</translation>
     </message>
     <message>
         <source>SaveScene</source>
@@ -194,6 +286,22 @@
         <source>SettingsPanel</source>
         <translation>Settings</translation>
     </message>
+    <message>
+        <source>SavingDocument</source>
+        <translation>Saving... %1%</translation>
+    </message>
+    <message>
+        <source>DocumentSaved</source>
+        <translation>Document saved.</translation>
+    </message>
+    <message>
+        <source>DocumentSaveFailed</source>
+        <translation>The document could not be saved.</translation>
+    </message>
+    <message>
+        <source>MultiresLevel</source>
+        <translation>Sculpting on level %1 of %2.</translation>
+    </message>
 </context>
 <context>
     <name>com::ui::SettingsPanel</name>
@@ -26,7 +26,55 @@ namespace com::base
                                                        "cursorVertexCount",
                                                        QT_TRANSLATE_NOOP("com::base::Preferences", "cursorVertexCountLabel"),
                                                        QT_TRANSLATE_NOOP("com::base::Preferences", "cursorVertexCountTooltip"),
-                                                       1'000 } };
+                                                       1'000 },
+
+                                                     { // BrushRadius
+                                                       "brushRadius",
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "brushRadiusLabel"),
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "brushRadiusTooltip"),
+                                                       0.1f },
+
+                                                     { // BrushStrength
+                                                       "brushStrength",
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "brushStrengthLabel"),
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "brushStrengthTooltip"),
+                                                       0.005f },
+
+                                                     { // FramesInFlight
+                                                       "framesInFlight",
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "framesInFlightLabel"),
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "framesInFlightTooltip"),
+                                                       2 },
+
+                                                     { // CompressDocuments
+                                                       "compressDocuments",
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "compressDocumentsLabel"),
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "compressDocumentsTooltip"),
+                                                       false },
+
+                                                     { // BrushFootprintSize
+                                                       "brushFootprintSize",
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "brushFootprintSizeLabel"),
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "brushFootprintSizeTooltip"),
+                                                       32 },
+
+                                                     { // DynamicTopology
+                                                       "dynamicTopology",
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "dynamicTopologyLabel"),
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "dynamicTopologyTooltip"),
+                                                       false },
+
+                                                     { // DynamicTopologyDetail
+                                                       "dynamicTopologyDetail",
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "dynamicTopologyDetailLabel"),
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "dynamicTopologyDetailTooltip"),
+                                                       0.02f },
+
+                                                     { // MultiresNavigationLevels
+                                                       "multiresNavigationLevels",
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "multiresNavigationLevelsLabel"),
+                                                       QT_TRANSLATE_NOOP("com::base::Preferences", "multiresNavigationLevelsTooltip"),
+                                                       2 } };
 
     Preferences::Preferences(QObject* parent) : QObject(parent)
     {
@@ -15,6 +15,14 @@ namespace com::base
         MinimumPrimitivePolygonCount, ///< The minimum number of polygons to use when creating a primitive.
         PrimitiveRadius,              ///< The radius of new primitives.
         CursorVertexCount,            ///< The number of vertices in the cursor.
+        BrushRadius,                  ///< The radius of the brush.
+        BrushStrength,                ///< The displacement applied by each brush sample.
+        FramesInFlight,               ///< The number of frames the CPU may record ahead of the GPU.
+        CompressDocuments,            ///< Whether documents are compressed when saved.
+        BrushFootprintSize,           ///< The width and height of the region under the mouse that orients the brush, in pixels.
+        DynamicTopology,              ///< Whether strokes adapt the mesh's triangles to the detail size.
+        DynamicTopologyDetail,        ///< The edge length that dynamic topology adapts towards.
+        MultiresNavigationLevels,     ///< The number of multiresolution levels dropped while the camera is moving.
     };
 
     /// The definition of a single preference.
@@ -0,0 +1,89 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "bench/benchmark.hxx"
+
+#include <QDebug>
+#include <QJsonArray>
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+namespace com::bench
+{
+    [[nodiscard]] static auto median(std::vector<double> samples)
+    {
+        std::ranges::sort(samples);
+
+        auto const middle = samples.size() / 2;
+        return (samples.size() % 2) ? samples[middle] : 0.5 * (samples[middle - 1] + samples[middle]);
+    }
+
+    Suite::Suite(uint32_t const iterations) : m_iterations(std::max(iterations, 1u))
+    {
+    }
+
+    void Suite::run(std::string const& name, uint64_t const size, std::function<void()> const& function, uint32_t const iterations)
+    {
+        run(name, size, [] {}, function, iterations);
+    }
+
+    void Suite::run(std::string const&           name,
+                    uint64_t const               size,
+                    std::function<void()> const& setup,
+                    std::function<void()> const& function,
+                    uint32_t const               iterations)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        Result result = { name, size, {} };
+
+        // The first call pays for lazily created state, e.g., pipelines and grids, so it is not timed.
+        setup();
+        function();
+
+        for (auto i = 0u, count = iterations ? iterations : m_iterations; i < count; ++i)
+        {
+            setup();
+
+            auto const start = Clock::now();
+            function();
+            auto const end = Clock::now();
+
+            result.samples.emplace_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        qInfo("%s [%llu]: %.3f ms", name.c_str(), static_cast<unsigned long long>(size), median(result.samples));
+
+        m_results.emplace_back(std::move(result));
+    }
+
+    auto Suite::toJson(QJsonObject const& environment) const -> QJsonObject
+    {
+        QJsonArray results;
+
+        for (auto const& result : m_results)
+        {
+            auto const [min, max] = std::ranges::minmax(result.samples);
+            auto const mean       = std::accumulate(result.samples.begin(), result.samples.end(), 0.0) / static_cast<double>(result.samples.size());
+
+            QJsonObject entry;
+            entry["name"]       = QString::fromStdString(result.name);
+            entry["size"]       = static_cast<qint64>(result.size);
+            entry["iterations"] = static_cast<qint64>(result.samples.size());
+            entry["min_ms"]     = min;
+            entry["median_ms"]  = median(result.samples);
+            entry["mean_ms"]    = mean;
+            entry["max_ms"]     = max;
+
+            results.append(entry);
+        }
+
+        QJsonObject root;
+        root["environment"] = environment;
+        root["results"]     = results;
+
+        return root;
+    }
+} // namespace com::bench
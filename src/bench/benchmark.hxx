@@ -0,0 +1,58 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include <QJsonObject>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace com::bench
+{
+    /// The timings of a benchmark.
+    struct Result final
+    {
+        std::string         name;     ///< The name of the benchmark.
+        uint64_t            size = 0; ///< The problem size, e.g., the number of polygons.
+        std::vector<double> samples;  ///< The duration of each iteration, in milliseconds.
+    };
+
+    /// Runs a set of benchmarks and collects their timings.
+    class Suite final
+    {
+    public:
+        /// Constructor.
+        /// \param iterations The default number of timed iterations of each benchmark.
+        explicit Suite(uint32_t const iterations);
+
+        /// Run a benchmark. The function is called once to warm up, and then once per timed iteration.
+        /// \param name The name of the benchmark.
+        /// \param size The problem size.
+        /// \param function The function to time.
+        /// \param iterations The number of timed iterations, or zero for the suite's default.
+        void run(std::string const& name, uint64_t const size, std::function<void()> const& function, uint32_t const iterations = 0);
+
+        /// Run a benchmark with an untimed setup before each iteration.
+        /// \param name The name of the benchmark.
+        /// \param size The problem size.
+        /// \param setup The function to call before each iteration, which is not timed.
+        /// \param function The function to time.
+        /// \param iterations The number of timed iterations, or zero for the suite's default.
+        void run(std::string const&           name,
+                 uint64_t const               size,
+                 std::function<void()> const& setup,
+                 std::function<void()> const& function,
+                 uint32_t const               iterations = 0);
+
+        /// Convert the results to JSON.
+        /// \param environment A description of the machine and build, e.g., the device and version.
+        /// \return A valid JSON object.
+        [[nodiscard]] auto toJson(QJsonObject const& environment) const -> QJsonObject;
+
+    private:
+        uint32_t            m_iterations = 0;
+        std::vector<Result> m_results;
+    };
+} // namespace com::bench
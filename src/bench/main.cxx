@@ -0,0 +1,420 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "app/version.hxx" // Generated.
+#include "bench/benchmark.hxx"
+#include "rhi/context.hxx"
+#include "rhi/mesh-optimiser.hxx"
+#include "rhi/per-frame-data.hxx"
+#include "rhi/primitive-generator.hxx"
+#include "rhi/primitive.hxx"
+#include "scene/brush-engine.hxx"
+#include "scene/bvh.hxx"
+#include "scene/offscreen-view.hxx"
+#include "scene/picker.hxx"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <cmath>
+#include <cstdlib>
+#include <optional>
+
+using namespace com;
+
+/// The default number of timed iterations of each benchmark.
+static constexpr uint32_t s_iterations = 10;
+
+/// The number of timed iterations of the largest problem sizes, which may take seconds each.
+static constexpr uint32_t s_largeIterations = 3;
+
+/// The problem size above which s_largeIterations is used.
+static constexpr uint64_t s_largeSize = 1'000'000;
+
+/// The extent of the offscreen view.
+static constexpr vk::Extent2D s_extent = { 1280, 720 };
+
+/// The number of brush samples in each benchmarked stroke.
+static constexpr uint32_t s_strokeSamples = 8;
+
+/// The number of rays cast at a BVH in each timed iteration.
+static constexpr uint32_t s_bvhRays = 1000;
+
+[[nodiscard]] static auto iterationsFor(uint64_t const size)
+{
+    return size > s_largeSize ? s_largeIterations : 0u;
+}
+
+[[nodiscard]] static auto makeContext()
+{
+    rhi::RhiDescription description = { .name = "com.bench", .version = app::Version::asInteger() };
+
+    description.instanceLayers = {
+#if !defined(NDEBUG)
+        "VK_LAYER_KHRONOS_validation"
+#endif // #if !defined(NDEBUG)
+    };
+
+    description.instanceExtensions = {
+#if !defined(NDEBUG)
+        VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
+#endif // #if !defined(NDEBUG)
+
+#if defined(VK_ENABLE_BETA_EXTENSIONS)
+        VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME,
+#endif // #if defined(VK_ENABLE_BETA_EXTENSIONS)
+    };
+
+    // No window, so no surface or swap chain; any device will do, including lavapipe.
+    description.deviceExtensions = {
+#if defined(VK_ENABLE_BETA_EXTENSIONS)
+        VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME,
+#endif // #if defined(VK_ENABLE_BETA_EXTENSIONS)
+
+        VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+        VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME,
+    };
+
+    // The features that drawing and the brush rely upon, as for the viewport.
+    description.deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+    description.deviceFeatures.multiDrawIndirect         = VK_TRUE;
+    description.deviceFeatures.shaderInt64               = VK_TRUE;
+
+    return std::make_unique<rhi::Context>(description);
+}
+
+/// Make a flat grid of vertices, as streams that are uploaded without any further generation cost.
+[[nodiscard]] static auto makeGrid(rhi::Context* context, uint32_t const vertexCount) -> rhi::MeshStreams
+{
+    auto const side = std::max(2u, static_cast<uint32_t>(std::sqrt(static_cast<double>(vertexCount))));
+
+    rhi::MeshStreams streams(context, side * side, 6 * (side - 1) * (side - 1));
+    auto const       points  = streams.positions();
+    auto const       indices = streams.indices();
+
+    for (auto y = 0u; y < side; ++y)
+    {
+        for (auto x = 0u; x < side; ++x)
+            points[y * side + x] = glm::vec3(2.0f * x / (side - 1) - 1.0f, 2.0f * y / (side - 1) - 1.0f, 0.0f);
+    }
+
+    for (auto y = 0u, k = 0u; y + 1 < side; ++y)
+    {
+        for (auto x = 0u; x + 1 < side; ++x)
+        {
+            auto const i = y * side + x;
+            for (auto const index : { i, i + 1, i + side, i + 1, i + side + 1, i + side })
+                indices[k++] = index;
+        }
+    }
+
+    std::ranges::fill(streams.colours(), 0xffffffffu);
+    streams.bounds().extend(glm::vec3(-1.0f, -1.0f, 0.0f));
+    streams.bounds().extend(glm::vec3(1.0f, 1.0f, 0.0f));
+
+    return streams;
+}
+
+static void benchmarkPrimitives(rhi::Context* context, bench::Suite& suite)
+{
+    for (uint64_t polygons : { 10'000ull, 100'000ull, 1'000'000ull, 10'000'000ull })
+    {
+        suite.run(
+            "rhi.makeSphere",
+            polygons,
+            [&]
+            {
+                auto mesh = rhi::makeSphere(context, glm::vec3(0.0f), 1.0f, static_cast<uint32_t>(polygons));
+                context->stagingRing()->submit();
+                context->waitForIdle();
+            },
+            iterationsFor(polygons));
+    }
+
+    // The context keeps the generator, so only the dispatch and the allocation of the mesh are measured.
+    auto* generator = context->primitiveGenerator();
+
+    for (uint64_t polygons : { 10'000ull, 100'000ull, 1'000'000ull, 10'000'000ull })
+    {
+        suite.run(
+            "rhi.PrimitiveGenerator.sphere",
+            polygons,
+            [&] { auto mesh = generator->generate(rhi::PrimitiveKind::eSphere, glm::vec3(0.0f), 1.0f, static_cast<uint32_t>(polygons)); },
+            iterationsFor(polygons));
+    }
+}
+
+static void benchmarkMeshes(rhi::Context* context, bench::Suite& suite)
+{
+    for (uint32_t vertices : { 10'000u, 100'000u, 1'000'000u, 10'000'000u })
+    {
+        std::optional<rhi::MeshStreams> streams;
+
+        // The grid is generated before each iteration, as a mesh consumes its streams.
+        suite.run(
+            "rhi.Mesh.upload",
+            vertices,
+            [&] { streams.emplace(makeGrid(context, vertices)); },
+            [&]
+            {
+                auto mesh = std::make_unique<rhi::Mesh>(context, std::move(*streams));
+                context->stagingRing()->submit();
+                context->waitForIdle();
+            },
+            iterationsFor(vertices));
+    }
+
+    for (uint32_t vertices : { 10'000u, 100'000u, 1'000'000u, 10'000'000u })
+    {
+        auto const             grid = makeGrid(context, vertices);
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t>  indices;
+        std::vector<uint32_t>  colours;
+
+        // The streams are copied before each iteration, as they are optimised in place.
+        suite.run(
+            "rhi.optimiseMesh",
+            vertices,
+            [&]
+            {
+                positions.assign(grid.positions().begin(), grid.positions().end());
+                indices.assign(grid.indices().begin(), grid.indices().end());
+                colours.assign(grid.colours().begin(), grid.colours().end());
+            },
+            [&] { rhi::optimiseMesh(indices, positions, colours); },
+            iterationsFor(vertices));
+    }
+}
+
+static void benchmarkBuffers(rhi::Context* context, bench::Suite& suite)
+{
+    for (vk::DeviceSize size : { 64ull << 10, 1ull << 20, 16ull << 20, 64ull << 20 })
+    {
+        auto const  data = std::vector<uint8_t>(size, 0xa5);
+        rhi::Buffer buffer(context, size, vk::BufferUsageFlagBits::eStorageBuffer);
+
+        suite.run("rhi.Buffer.upload", size, [&] { buffer.upload(data.data(), data.size()); });
+    }
+}
+
+static void benchmarkHitTest(rhi::Context* context, bench::Suite& suite)
+{
+    scene::OffscreenView view(context, s_extent);
+    scene::Document      document(context, s_extent);
+
+    auto* camera = view.camera();
+    camera->fitToDocument(&document);
+
+    // The time from requesting a hit to reading it back on the CPU, including the frame that renders it. The mouse moves by
+    // a pixel each time, as a query at an unchanged point is skipped.
+    auto step = 0;
+    suite.run("rhi.HitQueries",
+              0,
+              [&]
+              {
+                  auto* frameData = context->frameData();
+
+                  camera->track(QPoint(s_extent.width / 2 + (step++ & 1), s_extent.height / 2));
+                  document.requestHitUpdate();
+                  view.render(&document);
+                  context->waitForFences(frameData->fence());
+
+                  // Nothing is recorded here, as no request is outstanding; the completed one is delivered.
+                  document.updateHitTestQuery(camera, view.target()->rect());
+                  Q_UNUSED(document.hit());
+              });
+
+    // A headless stroke across the middle of the view, with the cursor placed by picking rather than by the hit-test pass. Each
+    // point refits the hierarchies to the edits of the one before: the CPU tree reads the edited vertices back, while the device
+    // tree, which samples the brush's footprint, is refit in place.
+    std::vector<QPoint> points;
+    for (auto i = 0u; i < s_strokeSamples; ++i)
+        points.emplace_back(static_cast<int32_t>(s_extent.width / 2 - 4 * s_strokeSamples + 8 * i), static_cast<int32_t>(s_extent.height / 2));
+
+    suite.run("scene.OffscreenView.stroke",
+              0,
+              [&]
+              {
+                  auto const hits = view.stroke(&document, points);
+                  context->waitForIdle();
+                  Q_UNUSED(hits);
+              });
+}
+
+static void benchmarkBrush(rhi::Context* context, bench::Suite& suite)
+{
+    for (uint64_t vertices : { 100'000ull, 1'000'000ull, 10'000'000ull })
+    {
+        // An icosphere has about half as many vertices as it has polygons.
+        std::vector<std::unique_ptr<scene::Model>> models;
+        models.emplace_back(std::make_unique<scene::Model>(rhi::makeSphere(context, glm::vec3(0.0f), 1.0f, static_cast<uint32_t>(2 * vertices))));
+
+        BrushUniform brush = {};
+        brush.n            = glm::vec3(0.0f, 0.0f, 1.0f);
+        brush.r            = 0.1f;
+        brush.r_sqrd       = brush.r * brush.r;
+        brush.scale        = 0.01f;
+        brush.offset       = 1.0f;
+
+        std::vector<BrushUniform> samples;
+        for (auto i = 0u; i < s_strokeSamples; ++i)
+        {
+            brush.p = glm::normalize(glm::vec3(0.01f * i, 0.0f, 1.0f));
+            samples.emplace_back(brush);
+        }
+
+        // One engine serves both modes, as the grids it builds for the culled mode are owned by the model.
+        scene::BrushEngine engine(context);
+        rhi::CommandPool   commandPool(context->device(), context->queueIndex(rhi::QueueIndex::eGraphics));
+
+        // Nothing renders the edits, so an empty graphics submission consumes the semaphore that each stroke signals.
+        auto const consume = [&]
+        {
+            auto const waits = engine.takeWaitSemaphores();
+            if (waits.empty())
+                return;
+
+            auto const& device = context->device()->logicalDevice();
+            auto const  fence  = device.createFence(vk::FenceCreateInfo());
+
+            commandPool.reset();
+            commandPool.commandBuffer().begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+            commandPool.commandBuffer().end();
+
+            context->queue(rhi::QueueIndex::eGraphics)->submit(commandPool.commandBuffer(), vk::Semaphore(), fence, waits);
+            context->waitForFences(fence);
+            device.destroyFence(fence);
+        };
+
+        for (auto const mode : { scene::BrushEngine::Mode::eCulled, scene::BrushEngine::Mode::eFull })
+        {
+            engine.setMode(mode);
+
+            auto const name = mode == scene::BrushEngine::Mode::eCulled ? "scene.BrushEngine.stroke.culled" : "scene.BrushEngine.stroke.full";
+
+            suite.run(
+                name,
+                vertices,
+                consume,
+                [&]
+                {
+                    engine.stroke(models, samples);
+                    engine.wait();
+                },
+                iterationsFor(vertices));
+
+            consume();
+            context->waitForIdle();
+        }
+    }
+}
+
+static void benchmarkBvh(rhi::Context* context, bench::Suite& suite)
+{
+    // The rays fan out from above the grid, so that successive rays land in different leaves.
+    std::vector<scene::Ray> rays;
+    for (auto i = 0u; i < s_bvhRays; ++i)
+    {
+        auto const angle  = 2.39996f * static_cast<float>(i);
+        auto const radius = std::sqrt(static_cast<float>(i) / s_bvhRays);
+        auto const target = glm::vec3(radius * std::cos(angle), radius * std::sin(angle), 0.0f);
+
+        rays.push_back(scene::Ray{ glm::vec3(0.0f, 0.0f, 2.0f), target - glm::vec3(0.0f, 0.0f, 2.0f) });
+    }
+
+    scene::Picker picker(context);
+
+    for (uint32_t vertices : { 500'000u, 5'000'000u })
+    {
+        // The grid's streams stay in host memory until the mesh is made, so the tree is built from them directly.
+        auto       streams   = makeGrid(context, vertices);
+        auto const positions = std::span<glm::vec3 const>(streams.positions());
+        auto const indices   = std::span<uint32_t const>(streams.indices());
+        auto const triangles = indices.size() / 3;
+
+        std::optional<scene::Bvh> bvh;
+        suite.run("scene.Bvh.build", triangles, [&] { bvh.emplace(positions, indices); }, iterationsFor(triangles));
+
+        uint32_t hits = 0;
+        suite.run("scene.Bvh.intersect",
+                  triangles,
+                  [&]
+                  {
+                      for (auto const& ray : rays)
+                          hits += bvh->intersect(ray).has_value();
+                  });
+
+        std::vector<std::unique_ptr<scene::Model>> models;
+        models.emplace_back(std::make_unique<scene::Model>(std::make_unique<rhi::Mesh>(context, std::move(streams))));
+        models.front()->setDeviceBvh(std::make_unique<scene::DeviceBvh>(context, models.front()->mesh(), *bvh));
+
+        // Each iteration casts the rays in one dispatch and waits for the results.
+        suite.run("scene.Picker.pick",
+                  triangles,
+                  [&]
+                  {
+                      for (auto const& hit : picker.pick(models, rays))
+                          hits += hit.has_value();
+                  });
+
+        static_cast<void>(hits);
+        context->waitForIdle();
+    }
+}
+
+auto main(int32_t argc, char** argv) -> int32_t
+{
+    QCoreApplication application(argc, argv);
+    application.setApplicationName("com.bench");
+    application.setApplicationVersion(QString::fromStdString(app::Version::asString()));
+    application.setOrganizationName("jamie.kenyon");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the mesh, upload, hit-test, brush and picking hot paths.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOption({ { "o", "output" }, "Write the results to <file>, rather than to the standard output.", "file" });
+    parser.addOption({ { "i", "iterations" }, "The number of timed iterations of each benchmark.", "count", QString::number(s_iterations) });
+    parser.process(application);
+
+    auto context = makeContext();
+    auto suite   = bench::Suite(parser.value("iterations").toUInt());
+
+    benchmarkPrimitives(context.get(), suite);
+    benchmarkMeshes(context.get(), suite);
+    benchmarkBuffers(context.get(), suite);
+    benchmarkHitTest(context.get(), suite);
+    benchmarkBrush(context.get(), suite);
+    benchmarkBvh(context.get(), suite);
+
+    auto const properties = context->device()->physicalDevice().getProperties();
+
+    QJsonObject environment;
+    environment["version"] = QString::fromStdString(app::Version::asString());
+    environment["device"]  = QString::fromUtf8(properties.deviceName.data());
+    environment["driver"]  = static_cast<qint64>(properties.driverVersion);
+
+    auto const json = QJsonDocument(suite.toJson(environment)).toJson();
+
+    context->onTerminating();
+    context.reset();
+
+    if (parser.isSet("output"))
+    {
+        QFile file(parser.value("output"));
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size())
+            return EXIT_FAILURE;
+    }
+    else
+    {
+        QFile file;
+        if (!file.open(stdout, QIODevice::WriteOnly))
+            return EXIT_FAILURE;
+
+        file.write(json);
+    }
+
+    return EXIT_SUCCESS;
+}
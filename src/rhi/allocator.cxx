@@ -0,0 +1,239 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "rhi/allocator.hxx"
+#include "rhi/utilities.hxx"
+
+#include <bit>
+
+namespace com::rhi
+{
+    /// The smallest range, in bytes.
+    static constexpr vk::DeviceSize s_minSize = 256;
+
+    /// The number of orders in a block, i.e., a block is s_minSize << s_maxOrder bytes.
+    static constexpr uint32_t s_maxOrder = 18;
+
+    /// The size of a block, in bytes.
+    static constexpr vk::DeviceSize s_blockSize = s_minSize << s_maxOrder;
+
+    /// A block of device memory managed as a buddy system.
+    struct AllocationBlock final
+    {
+        vk::DeviceMemory                                     memory;              ///< The memory object.
+        uint8_t*                                             data      = nullptr; ///< The host address, if mapped.
+        uint32_t                                             pool      = 0;       ///< The owning pool.
+        vk::DeviceSize                                       usedBytes = 0;       ///< The bytes in use.
+        std::array<std::set<vk::DeviceSize>, s_maxOrder + 1> freeLists;           ///< The offsets of the free ranges of each order.
+    };
+
+    [[nodiscard]] static auto orderOf(vk::DeviceSize const size)
+    {
+        return static_cast<uint32_t>(std::countr_zero(std::bit_ceil(std::max(size, s_minSize)) / s_minSize));
+    }
+
+    [[nodiscard]] static auto allocateFlags(AllocationKind const kind)
+    {
+        // Any buffer may be read through its device address, e.g., by vertex pulling, which requires the flag on its memory.
+        return vk::MemoryAllocateFlagsInfo(kind == AllocationKind::eLinear ? vk::MemoryAllocateFlagBits::eDeviceAddress : vk::MemoryAllocateFlags());
+    }
+
+    [[nodiscard]] static auto poolIndex(uint32_t const memoryTypeIndex, AllocationKind const kind)
+    {
+        return 2 * memoryTypeIndex + static_cast<uint32_t>(kind);
+    }
+
+    Allocator::Allocator(vk::Device const& device, vk::PhysicalDevice const& physicalDevice)
+        : m_device(device), m_memoryProperties(physicalDevice.getMemoryProperties()),
+          m_nonCoherentAtomSize(physicalDevice.getProperties().limits.nonCoherentAtomSize)
+    {
+        m_pools.resize(2 * m_memoryProperties.memoryTypeCount);
+    }
+
+    Allocator::~Allocator()
+    {
+        for (auto& pool : m_pools)
+        {
+            for (auto const& block : pool)
+                destroyBlock(block.get());
+        }
+
+        for (auto const& memory : m_dedicated)
+            m_device.freeMemory(memory);
+    }
+
+    auto Allocator::allocate(vk::MemoryRequirements const& requirements, vk::MemoryPropertyFlags const propertyFlags, AllocationKind const kind) -> Allocation
+    {
+        auto const memoryTypeIndex = findMemoryType(m_memoryProperties, requirements.memoryTypeBits, propertyFlags);
+
+        std::scoped_lock lock(m_mutex);
+
+        // A buddy range is aligned to its size, so alignment is satisfied by rounding the size up.
+        auto const size = std::bit_ceil(std::max({ requirements.size, requirements.alignment, s_minSize }));
+        if (size > s_blockSize / 2)
+            return allocateDedicated(requirements.size, memoryTypeIndex, kind);
+
+        auto const order = orderOf(size);
+        auto&      pool  = m_pools[poolIndex(memoryTypeIndex, kind)];
+
+        // Find the block with the smallest free range that fits.
+        AllocationBlock* block     = nullptr;
+        auto             fromOrder = s_maxOrder + 1;
+        for (auto const& candidate : pool)
+        {
+            for (auto o = order; o < fromOrder; ++o)
+            {
+                if (!candidate->freeLists[o].empty())
+                {
+                    block     = candidate.get();
+                    fromOrder = o;
+                    break;
+                }
+            }
+        }
+
+        if (!block)
+        {
+            pool.emplace_back(createBlock(memoryTypeIndex, kind));
+            block       = pool.back().get();
+            block->pool = poolIndex(memoryTypeIndex, kind);
+            fromOrder   = s_maxOrder;
+        }
+
+        auto const offset = *block->freeLists[fromOrder].begin();
+        block->freeLists[fromOrder].erase(block->freeLists[fromOrder].begin());
+
+        // Split the range, returning the upper halves to the free lists.
+        for (auto o = fromOrder; o > order; --o)
+            block->freeLists[o - 1].emplace(offset + (s_minSize << (o - 1)));
+
+        block->usedBytes += size;
+        ++m_allocationCount;
+
+        auto const data = block->data ? block->data + offset : nullptr;
+
+        return { block->memory, offset, size, data, block, m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags };
+    }
+
+    void Allocator::free(Allocation const& allocation)
+    {
+        if (!allocation.memory)
+            return;
+
+        std::scoped_lock lock(m_mutex);
+
+        --m_allocationCount;
+
+        if (!allocation.block)
+        {
+            m_device.freeMemory(allocation.memory);
+            m_dedicated.erase(allocation.memory);
+            m_dedicatedBytes -= allocation.size;
+            return;
+        }
+
+        auto* block  = allocation.block;
+        auto  offset = allocation.offset;
+        auto  order  = orderOf(allocation.size);
+
+        block->usedBytes -= allocation.size;
+
+        // Merge with the buddy for as long as it is free.
+        for (; order < s_maxOrder; ++order)
+        {
+            auto const buddy = offset ^ (s_minSize << order);
+            auto const it    = block->freeLists[order].find(buddy);
+            if (it == block->freeLists[order].end())
+                break;
+
+            block->freeLists[order].erase(it);
+            offset = std::min(offset, buddy);
+        }
+
+        block->freeLists[order].emplace(offset);
+
+        // Keep a single empty block per pool, so that resources which are recreated often, e.g., on resize, do not
+        // return to the device.
+        if (block->usedBytes == 0)
+        {
+            auto&      pool       = m_pools[block->pool];
+            auto const emptyCount = std::ranges::count_if(pool, [](auto const& b) { return b->usedBytes == 0; });
+            if (emptyCount > 1)
+            {
+                destroyBlock(block);
+                std::erase_if(pool, [block](auto const& b) { return b.get() == block; });
+            }
+        }
+    }
+
+    auto Allocator::statistics() const -> AllocatorStatistics
+    {
+        std::scoped_lock lock(m_mutex);
+
+        AllocatorStatistics stats;
+        vk::DeviceSize      freeBytes    = 0;
+        vk::DeviceSize      largestRange = 0;
+
+        for (auto const& pool : m_pools)
+        {
+            for (auto const& block : pool)
+            {
+                stats.reservedBytes += s_blockSize;
+                stats.usedBytes     += block->usedBytes;
+                ++stats.blockCount;
+
+                for (auto order = 0u; order <= s_maxOrder; ++order)
+                {
+                    if (!block->freeLists[order].empty())
+                        largestRange = std::max(largestRange, s_minSize << order);
+                }
+
+                freeBytes += s_blockSize - block->usedBytes;
+            }
+        }
+
+        stats.reservedBytes   += m_dedicatedBytes;
+        stats.usedBytes       += m_dedicatedBytes;
+        stats.allocationCount  = m_allocationCount;
+        stats.dedicatedCount   = static_cast<uint32_t>(m_dedicated.size());
+        stats.fragmentation    = freeBytes > 0 ? 1.0f - static_cast<float>(largestRange) / static_cast<float>(freeBytes) : 0.0f;
+
+        return stats;
+    }
+
+    auto Allocator::allocateDedicated(vk::DeviceSize const size, uint32_t const memoryTypeIndex, AllocationKind const kind) -> Allocation
+    {
+        auto const flagsInfo = allocateFlags(kind);
+        auto const memory    = m_device.allocateMemory(vk::MemoryAllocateInfo(size, memoryTypeIndex, &flagsInfo));
+        void*      data      = nullptr;
+
+        if (m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+            data = m_device.mapMemory(memory, 0, VK_WHOLE_SIZE);
+
+        m_dedicated.emplace(memory);
+        m_dedicatedBytes += size;
+        ++m_allocationCount;
+
+        return { memory, 0, size, data, nullptr, m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags };
+    }
+
+    auto Allocator::createBlock(uint32_t const memoryTypeIndex, AllocationKind const kind) -> std::unique_ptr<AllocationBlock>
+    {
+        auto const flagsInfo = allocateFlags(kind);
+        auto       block     = std::make_unique<AllocationBlock>();
+        block->memory        = m_device.allocateMemory(vk::MemoryAllocateInfo(s_blockSize, memoryTypeIndex, &flagsInfo));
+        block->freeLists[s_maxOrder].emplace(0);
+
+        if (m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+            block->data = static_cast<uint8_t*>(m_device.mapMemory(block->memory, 0, VK_WHOLE_SIZE));
+
+        return block;
+    }
+
+    void Allocator::destroyBlock(AllocationBlock const* block)
+    {
+        // Freeing memory implicitly unmaps it.
+        m_device.freeMemory(block->memory);
+    }
+} // namespace com::rhi
@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <mutex>
+#include <set>
+
+namespace com::rhi
+{
+    /// A block of device memory that allocations are carved from.
+    struct AllocationBlock;
+
+    /// A range of device memory.
+    struct Allocation final
+    {
+        vk::DeviceMemory        memory;           ///< The memory object.
+        vk::DeviceSize          offset = 0;       ///< The offset into the memory object, in bytes.
+        vk::DeviceSize          size   = 0;       ///< The size of the range, in bytes.
+        void*                   data   = nullptr; ///< The host address of the range if the memory is host-visible; nullptr otherwise.
+        AllocationBlock*        block  = nullptr; ///< The block that owns the range; nullptr for dedicated allocations.
+        vk::MemoryPropertyFlags propertyFlags;    ///< The properties of the memory type.
+    };
+
+    /// Specifies the tiling of the resource that memory is allocated for.
+    enum class AllocationKind
+    {
+        eLinear,  ///< Buffers.
+        eOptimal, ///< Optimally tiled images.
+    };
+
+    /// Usage statistics of an allocator.
+    struct AllocatorStatistics final
+    {
+        vk::DeviceSize reservedBytes   = 0;    ///< The bytes allocated from the device.
+        vk::DeviceSize usedBytes       = 0;    ///< The bytes in use by resources, including alignment padding.
+        uint32_t       allocationCount = 0;    ///< The number of live allocations.
+        uint32_t       blockCount      = 0;    ///< The number of blocks.
+        uint32_t       dedicatedCount  = 0;    ///< The number of dedicated allocations.
+        float          fragmentation   = 0.0f; ///< One minus the ratio of the largest free range to the free bytes in the blocks.
+    };
+
+    /// Sub-allocates device memory from large blocks, so that resources do not each need a device allocation.
+    ///
+    /// Each block is managed as a buddy system, so every range is aligned to its power-of-two size. Blocks are kept per
+    /// memory type and per tiling, which means linear and optimal resources never share a block and the
+    /// bufferImageGranularity does not need to be considered. Resources larger than half a block are given a dedicated
+    /// allocation. Host-visible blocks are mapped for their whole lifetime, and linear memory is allocated so that buffers
+    /// bound to it can be addressed from shaders.
+    class Allocator final
+    {
+    public:
+        /// Constructor.
+        /// \param device The logical device.
+        /// \param physicalDevice The physical device.
+        explicit Allocator(vk::Device const& device, vk::PhysicalDevice const& physicalDevice);
+
+        /// Destructor.
+        ~Allocator();
+
+        /// Allocate memory.
+        /// \param requirements The memory requirements of the resource.
+        /// \param propertyFlags The required memory properties.
+        /// \param kind The tiling of the resource.
+        /// \return A valid allocation.
+        [[nodiscard]] auto allocate(vk::MemoryRequirements const& requirements, vk::MemoryPropertyFlags const propertyFlags, AllocationKind const kind)
+            -> Allocation;
+
+        /// Free memory.
+        /// \param allocation The allocation to free.
+        void free(Allocation const& allocation);
+
+        /// Get the granularity of flushes and invalidations of memory that is not host-coherent.
+        /// \return A valid size, in bytes.
+        [[nodiscard]] auto nonCoherentAtomSize() const
+        {
+            return m_nonCoherentAtomSize;
+        }
+
+        /// Query the usage statistics.
+        /// \return The statistics.
+        [[nodiscard]] auto statistics() const -> AllocatorStatistics;
+
+    private:
+        [[nodiscard]] auto allocateDedicated(vk::DeviceSize const size, uint32_t const memoryTypeIndex, AllocationKind const kind) -> Allocation;
+        [[nodiscard]] auto createBlock(uint32_t const memoryTypeIndex, AllocationKind const kind) -> std::unique_ptr<AllocationBlock>;
+        void               destroyBlock(AllocationBlock const* block);
+
+    private:
+        vk::Device                                                 m_device;
+        vk::PhysicalDeviceMemoryProperties                         m_memoryProperties;
+        vk::DeviceSize                                             m_nonCoherentAtomSize;
+        std::vector<std::vector<std::unique_ptr<AllocationBlock>>> m_pools;
+        std::set<vk::DeviceMemory>                                 m_dedicated;
+        vk::DeviceSize                                             m_dedicatedBytes  = 0;
+        uint32_t                                                   m_allocationCount = 0;
+        mutable std::mutex                                         m_mutex;
+    };
+} // namespace com::rhi
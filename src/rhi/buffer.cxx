@@ -8,46 +8,73 @@
 
 namespace com::rhi
 {
-    Buffer::Buffer(Context* context, vk::DeviceSize const size, vk::BufferUsageFlags const usageFlags, vk::MemoryPropertyFlags const propertyFlags)
+    Buffer::Buffer(Context*                      context,
+                   vk::DeviceSize const          size,
+                   vk::BufferUsageFlags const    usageFlags,
+                   vk::MemoryPropertyFlags const propertyFlags,
+                   std::vector<uint32_t> const&  queueIndices)
         : m_context(context), m_size(size)
     {
-        auto const& device         = m_context->device()->logicalDevice();
-        auto const& physicalDevice = m_context->device()->physicalDevice();
-        m_buffer                   = device.createBuffer(vk::BufferCreateInfo({}, size, usageFlags));
+        auto const& device      = m_context->device()->logicalDevice();
+        auto const  sharingMode = queueIndices.size() > 1 ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive;
+        m_buffer                = device.createBuffer(vk::BufferCreateInfo({}, size, usageFlags, sharingMode, queueIndices));
 
         auto const memoryRequirements = device.getBufferMemoryRequirements(m_buffer);
-        auto const memoryTypeIndex    = findMemoryType(physicalDevice.getMemoryProperties(), memoryRequirements.memoryTypeBits, propertyFlags);
+        m_allocation                  = m_context->device()->allocator()->allocate(memoryRequirements, propertyFlags, AllocationKind::eLinear);
 
-        m_deviceMemory = device.allocateMemory(vk::MemoryAllocateInfo(memoryRequirements.size, memoryTypeIndex));
-        device.bindBufferMemory(m_buffer, m_deviceMemory, 0);
+        device.bindBufferMemory(m_buffer, m_allocation.memory, m_allocation.offset);
     }
 
     Buffer::~Buffer()
     {
         auto const& device = m_context->device()->logicalDevice();
         device.destroyBuffer(m_buffer);
-        device.freeMemory(m_deviceMemory);
+        m_context->device()->allocator()->free(m_allocation);
     }
 
-    auto Buffer::map() -> void*
+    auto Buffer::deviceAddress() const -> vk::DeviceAddress
     {
-        auto const& device = m_context->device()->logicalDevice();
-        return device.mapMemory(m_deviceMemory, 0, m_size);
+        return m_context->device()->logicalDevice().getBufferAddress(vk::BufferDeviceAddressInfo(m_buffer));
     }
 
-    void Buffer::unmap()
+    void Buffer::flush(vk::DeviceSize const offset, vk::DeviceSize const size) const
     {
-        auto const& device = m_context->device()->logicalDevice();
-        device.unmapMemory(m_deviceMemory);
+        if (isHostVisible() && !isHostCoherent())
+            m_context->device()->logicalDevice().flushMappedMemoryRanges(mappedRange(offset, size));
+    }
+
+    void Buffer::invalidate(vk::DeviceSize const offset, vk::DeviceSize const size) const
+    {
+        if (isHostVisible() && !isHostCoherent())
+            m_context->device()->logicalDevice().invalidateMappedMemoryRanges(mappedRange(offset, size));
+    }
+
+    void Buffer::upload(void const* data, size_t const size, vk::DeviceSize const offset)
+    {
+        if (!isHostVisible())
+        {
+            m_context->stagingRing()->copy(this, data, size, offset);
+            return;
+        }
+
+        std::memcpy(static_cast<uint8_t*>(m_allocation.data) + offset, data, size);
+
+        flush(offset, size);
     }
 
-    void Buffer::upload(void const* data, size_t const size)
+    auto Buffer::mappedRange(vk::DeviceSize const offset, vk::DeviceSize const size) const -> vk::MappedMemoryRange
     {
-        auto const& device     = m_context->device()->logicalDevice();
-        auto*       deviceData = static_cast<uint8_t*>(device.mapMemory(m_deviceMemory, 0, size));
+        // Ranges must be aligned to the atom size; a sub-allocated range is aligned to its power-of-two size, which is
+        // at least the atom size, so widening the range never leaves the allocation.
+        auto const atom  = m_context->device()->allocator()->nonCoherentAtomSize();
+        auto const last  = size == VK_WHOLE_SIZE ? m_size : std::min(m_size, offset + size);
+        auto const begin = (m_allocation.offset + offset) / atom * atom;
+        auto const end   = (m_allocation.offset + last + atom - 1) / atom * atom;
 
-        std::memcpy(deviceData, data, size);
+        // A dedicated allocation may not be a multiple of the atom size, in which case it is flushed to its end.
+        if (end > m_allocation.offset + m_allocation.size)
+            return vk::MappedMemoryRange(m_allocation.memory, begin, VK_WHOLE_SIZE);
 
-        device.unmapMemory(m_deviceMemory);
+        return vk::MappedMemoryRange(m_allocation.memory, begin, end - begin);
     }
 } // namespace com::rhi
@@ -4,8 +4,12 @@
 
 #pragma once
 
+#include "rhi/allocator.hxx"
+
 #include <vulkan/vulkan.hpp>
 
+#include <span>
+
 namespace com::rhi
 {
     /// Helper struct for building buffers.
@@ -24,10 +28,12 @@ namespace com::rhi
         /// \param size The size of the buffer, in bytes.
         /// \param usageFlags The usage of the buffer.
         /// \param propertyFlags The property flags.
+        /// \param queueIndices The queue families that access the buffer concurrently; empty for exclusive access.
         explicit Buffer(class Context*                context,
                         vk::DeviceSize const          size,
                         vk::BufferUsageFlags const    usageFlags,
-                        vk::MemoryPropertyFlags const propertyFlags = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+                        vk::MemoryPropertyFlags const propertyFlags = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                        std::vector<uint32_t> const&  queueIndices  = {});
 
         /// Destructor.
         ~Buffer();
@@ -46,16 +52,84 @@ namespace com::rhi
             return m_numElements;
         }
 
-        /// Map the memory.
-        [[nodiscard]] auto map() -> void*;
+        /// Set the number of elements in the buffer, e.g., after it has been filled by a copy.
+        /// \param count A valid integer.
+        void setCount(uint32_t const count)
+        {
+            m_numElements = count;
+        }
+
+        /// Get the host address of the buffer's memory, which stays mapped for the lifetime of the buffer.
+        /// \return A valid pointer if the memory is host-visible; nullptr otherwise.
+        [[nodiscard]] auto data() const -> void*
+        {
+            return m_allocation.data;
+        }
 
-        /// Ummap the memory.
-        void unmap();
+        /// Get the device address of the buffer, which shaders may read through. The buffer must have been created with
+        /// eShaderDeviceAddress usage.
+        /// \return A valid address.
+        [[nodiscard]] auto deviceAddress() const -> vk::DeviceAddress;
 
-        /// Upload the contents of the buffer to the GPU.
+        /// Make host writes to a range of the buffer visible to the device. This is only required for memory that is
+        /// not host-coherent.
+        /// \param offset The offset of the range, in bytes.
+        /// \param size The size of the range, in bytes.
+        void flush(vk::DeviceSize const offset = 0, vk::DeviceSize const size = VK_WHOLE_SIZE) const;
+
+        /// Make device writes to a range of the buffer visible to the host. This is only required for memory that is
+        /// not host-coherent.
+        /// \param offset The offset of the range, in bytes.
+        /// \param size The size of the range, in bytes.
+        void invalidate(vk::DeviceSize const offset = 0, vk::DeviceSize const size = VK_WHOLE_SIZE) const;
+
+        /// Determines if the buffer's memory is host-coherent.
+        /// \return true if the memory is host-coherent; false otherwise.
+        [[nodiscard]] auto isHostCoherent() const -> bool
+        {
+            return static_cast<bool>(m_allocation.propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent);
+        }
+
+        /// Determines if the buffer's memory is host-visible.
+        /// \return true if the memory is host-visible; false otherwise.
+        [[nodiscard]] auto isHostVisible() const -> bool
+        {
+            return static_cast<bool>(m_allocation.propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible);
+        }
+
+        /// Get the size of the buffer.
+        /// \return The size, in bytes.
+        [[nodiscard]] auto size() const
+        {
+            return m_size;
+        }
+
+        /// Upload data to a range of the buffer.
+        ///
+        /// Device-local buffers are written via the context's staging ring, so the data is only visible to work that
+        /// waits upon the ring.
         /// \param data The data.
         /// \param size The size of the data, in bytes.
-        void upload(void const* data, size_t const size);
+        /// \param offset The offset into the buffer, in bytes.
+        void upload(void const* data, size_t const size, vk::DeviceSize const offset = 0);
+
+        /// Upload data to a range of the buffer, leaving the rest untouched.
+        /// \param offset The offset into the buffer, in bytes.
+        /// \param data The data.
+        template <typename T, size_t N>
+        void upload(vk::DeviceSize const offset, std::span<T, N> const data)
+        {
+            upload(data.data(), data.size_bytes(), offset);
+        }
+
+        /// Upload the contents of the buffer to the GPU.
+        /// \param data The data.
+        template <typename T, size_t N>
+        void upload(std::span<T, N> const data)
+        {
+            upload(data.data(), data.size_bytes());
+            m_numElements = static_cast<uint32_t>(data.size());
+        }
 
         /// Upload the contents of the buffer to the GPU.
         /// \param data The data.
@@ -76,10 +150,13 @@ namespace com::rhi
         }
 
     private:
-        vk::Buffer       m_buffer;
-        class Context*   m_context = nullptr;
-        vk::DeviceMemory m_deviceMemory;
-        uint32_t         m_numElements = 0;
-        vk::DeviceSize   m_size;
+        [[nodiscard]] auto mappedRange(vk::DeviceSize const offset, vk::DeviceSize const size) const -> vk::MappedMemoryRange;
+
+    private:
+        vk::Buffer     m_buffer;
+        class Context* m_context = nullptr;
+        Allocation     m_allocation;
+        uint32_t       m_numElements = 0;
+        vk::DeviceSize m_size;
     };
 } // namespace com::rhi
@@ -4,12 +4,16 @@
 
 #include "rhi/context.hxx"
 #include "rhi/per-frame-data.hxx"
+#include "rhi/primitive-generator.hxx"
 #include "rhi/utilities.hxx"
 
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
 
 namespace com::rhi
 {
+    /// The size of the staging ring, in bytes.
+    static constexpr vk::DeviceSize s_stagingRingCapacity = 64 * 1024 * 1024;
+
     [[nodiscard]] static auto filterLayers(vk::ArrayProxy<std::string const> const& required) -> std::vector<char const*>
     {
         auto const               available = vk::enumerateInstanceLayerProperties();
@@ -75,18 +79,27 @@ namespace com::rhi
         VULKAN_HPP_DEFAULT_DISPATCHER.init(m_instance);
 
         createDebugUtility();
-        createSurface(description.windowConnection, description.windowHandle);
+
+        // Without a window there is nothing to present to, so rendering goes to offscreen targets instead.
+        if (description.windowHandle)
+            createSurface(description.windowConnection, description.windowHandle);
 
         m_physicalDevice     = PhysicalDevice::pick(this, m_surface, description);
         m_computeQueueIndex  = m_physicalDevice->findQueueIndex(vk::QueueFlagBits::eCompute, nullptr);
         m_graphicsQueueIndex = m_physicalDevice->findQueueIndex(vk::QueueFlagBits::eGraphics, nullptr);
-        m_presentQueueIndex  = m_physicalDevice->findQueueIndex(vk::QueueFlagBits::eGraphics, &m_surface);
+        m_presentQueueIndex  = m_physicalDevice->findQueueIndex(vk::QueueFlagBits::eGraphics, m_surface ? &m_surface : nullptr);
         m_transferQueueIndex = m_physicalDevice->findQueueIndex(vk::QueueFlagBits::eTransfer, nullptr);
 
-        m_device           = std::make_unique<Device>(this, m_physicalDevice.get(), description);
-        m_depthFormat      = getDepthFormat(*m_physicalDevice, vk::ImageTiling::eOptimal);
-        auto const formats = m_physicalDevice->surfaceFormats(m_surface);
-        m_colorFormat      = ((formats.size() == 1) && (formats[0].format == vk::Format::eUndefined)) ? vk::Format::eB8G8R8A8Unorm : formats[0].format;
+        m_device      = std::make_unique<Device>(this, m_physicalDevice.get(), description);
+        m_depthFormat = getDepthFormat(*m_physicalDevice, vk::ImageTiling::eOptimal);
+        m_colorFormat = vk::Format::eB8G8R8A8Unorm;
+
+        if (m_surface)
+        {
+            auto const formats = m_physicalDevice->surfaceFormats(m_surface);
+            if ((formats.size() != 1) || (formats[0].format != vk::Format::eUndefined))
+                m_colorFormat = formats[0].format;
+        }
 
         VULKAN_HPP_DEFAULT_DISPATCHER.init(m_device->logicalDevice());
 
@@ -96,10 +109,19 @@ namespace com::rhi
         m_transferQueue = std::make_unique<Queue>(m_device.get(), m_transferQueueIndex);
 
         m_pipelineCache = m_device->logicalDevice().createPipelineCache(vk::PipelineCacheCreateInfo());
+        m_stagingRing   = std::make_unique<StagingRing>(this, s_stagingRingCapacity);
+
+        auto const typeInfo = vk::SemaphoreTypeCreateInfo(vk::SemaphoreType::eTimeline, m_frameValue);
+        m_frameTimeline     = m_device->logicalDevice().createSemaphore(vk::SemaphoreCreateInfo({}, &typeInfo));
     }
 
     Context::~Context()
     {
+        m_primitiveGenerator.reset();
+        m_stagingRing.reset();
+
+        m_device->logicalDevice().destroySemaphore(m_frameTimeline);
+
         m_device.reset();
         m_instance.destroySurfaceKHR(m_surface);
         m_debugUtil.reset();
@@ -108,24 +130,46 @@ namespace com::rhi
 
     void Context::allocatePerFrameData(uint32_t const count)
     {
-        if (m_perFrameData.empty())
-        {
-            auto const qi = queueIndex(QueueIndex::eGraphics);
+        if (m_perFrameData.size() == count)
+            return;
 
-            for (auto index = 0u; index < count; ++index)
-                m_perFrameData.emplace_back(std::make_unique<FrameData>(this, qi));
+        if (!m_perFrameData.empty())
+        {
+            waitForIdle();
+            m_perFrameData.clear();
+            m_currentFrameIndex = 0;
         }
+
+        auto const qi = queueIndex(QueueIndex::eGraphics);
+
+        for (auto index = 0u; index < count; ++index)
+            m_perFrameData.emplace_back(std::make_unique<FrameData>(this, qi));
+    }
+
+    auto Context::completedFrameValue() const -> uint64_t
+    {
+        return m_device->logicalDevice().getSemaphoreCounterValue(m_frameTimeline);
     }
 
     void Context::onTerminating()
     {
         auto const& d = device()->logicalDevice();
 
+        m_primitiveGenerator.reset();
         d.destroyPipelineCache(m_pipelineCache);
 
+        m_stagingRing.reset();
         m_perFrameData.clear();
     }
 
+    auto Context::primitiveGenerator() -> PrimitiveGenerator*
+    {
+        if (!m_primitiveGenerator)
+            m_primitiveGenerator = std::make_unique<PrimitiveGenerator>(this);
+
+        return m_primitiveGenerator.get();
+    }
+
     auto Context::queueIndices() const -> std::set<uint32_t>
     {
         std::set<uint32_t> queueIndicesSet;
@@ -153,6 +197,12 @@ namespace com::rhi
         d.waitIdle();
     }
 
+    void Context::waitForSemaphore(vk::Semaphore const& semaphore, uint64_t const value, uint64_t const timeout)
+    {
+        while (vk::Result::eTimeout == m_device->logicalDevice().waitSemaphores(vk::SemaphoreWaitInfo({}, semaphore, value), timeout))
+            /* noop*/;
+    }
+
     void Context::createDebugUtility()
     {
 #if !defined(NDEBUG)
@@ -8,11 +8,15 @@
 #include "rhi/description.hxx"
 #include "rhi/device.hxx"
 #include "rhi/queue.hxx"
+#include "rhi/staging-ring.hxx"
 
 #include <set>
 
 namespace com::rhi
 {
+    // Forward declaration.
+    class PrimitiveGenerator;
+
     /// An instance of Vulkan.
     class Context final
     {
@@ -30,7 +34,8 @@ namespace com::rhi
             m_currentFrameIndex = (m_currentFrameIndex + 1) % m_perFrameData.size();
         }
 
-        /// Allocate the per-frame data.
+        /// Allocate the per-frame data, replacing any that has a different number of entries. The device is waited upon
+        /// before the entries are replaced, as frames in flight may still be using them.
         /// \param count The number of entries to allocate.
         void allocatePerFrameData(uint32_t const count);
 
@@ -55,6 +60,41 @@ namespace com::rhi
             return m_device.get();
         }
 
+        /// Get the value of the last frame that has completed on the device, without waiting.
+        /// \return A value of the frame timeline.
+        [[nodiscard]] auto completedFrameValue() const -> uint64_t;
+
+        /// Get the semaphore that work must wait upon before writing resources that submitted frames may still read.
+        /// \param stage The first stage that writes.
+        /// \return A semaphore that is signaled once every submitted frame has completed.
+        [[nodiscard]] auto frameCompleteWait(vk::PipelineStageFlags const stage) const -> WaitSemaphore
+        {
+            return { m_frameTimeline, stage, m_frameValue };
+        }
+
+        /// Get the semaphore that work must wait upon before writing resources that a particular frame may still read.
+        /// \param stage The first stage that writes.
+        /// \param value The value of the frame, which is limited to the frames that have been submitted.
+        /// \return A semaphore that is signaled once the frame has completed.
+        [[nodiscard]] auto frameWait(vk::PipelineStageFlags const stage, uint64_t const value) const -> WaitSemaphore
+        {
+            return { m_frameTimeline, stage, std::min(value, m_frameValue) };
+        }
+
+        /// Get the number of frames that may be in flight.
+        /// \return A valid integer.
+        [[nodiscard]] auto frameCount() const
+        {
+            return static_cast<uint32_t>(m_perFrameData.size());
+        }
+
+        /// Get the index of the current per-frame data.
+        /// \return A valid integer.
+        [[nodiscard]] auto frameIndex() const
+        {
+            return m_currentFrameIndex;
+        }
+
         /// Get the current per-frame data.
         /// \return A valid pointer.
         [[nodiscard]] auto frameData() const
@@ -62,6 +102,14 @@ namespace com::rhi
             return m_perFrameData[m_currentFrameIndex].get();
         }
 
+        /// Get the per-frame data of a frame slot.
+        /// \param index The index of the slot.
+        /// \return A valid pointer.
+        [[nodiscard]] auto frameData(uint32_t const index) const
+        {
+            return m_perFrameData[index].get();
+        }
+
         /// Accessor.
         /// \return The instance.
         [[nodiscard]] auto handle() const
@@ -69,9 +117,30 @@ namespace com::rhi
             return m_instance;
         }
 
+        /// Determines if the context renders without a window, e.g., for benchmarks and batch jobs.
+        /// \return true if there is no presentation surface; false otherwise.
+        [[nodiscard]] auto isHeadless() const
+        {
+            return !m_surface;
+        }
+
         /// React to the application terminating.
         void onTerminating();
 
+        /// Get the semaphore that the next frame's submission signals.
+        /// \return A timeline semaphore and the value to signal.
+        [[nodiscard]] auto nextFrameSignal() -> SignalSemaphore
+        {
+            return { m_frameTimeline, ++m_frameValue };
+        }
+
+        /// Get the value that the frame being recorded will signal upon completion, e.g., to tag work that it carries.
+        /// \return A value of the frame timeline.
+        [[nodiscard]] auto pendingFrameValue() const
+        {
+            return m_frameValue + 1;
+        }
+
         /// Accessor.
         /// \return A valid Vulkan object.
         [[nodiscard]] auto pipelineCache() const
@@ -79,6 +148,11 @@ namespace com::rhi
             return m_pipelineCache;
         }
 
+        /// Get the generator that makes primitives on the device, which is created when first needed and then kept, so that
+        /// its pipeline is only built once.
+        /// \return A valid pointer.
+        [[nodiscard]] auto primitiveGenerator() -> PrimitiveGenerator*;
+
         /// Accessor.
         /// \return The graphics queue.
         [[nodiscard]] auto queue(QueueIndex const type) const
@@ -118,7 +192,14 @@ namespace com::rhi
         [[nodiscard]] auto queueIndices() const -> std::set<uint32_t>;
 
         /// Accessor.
-        /// \return The presentation surface.
+        /// \return The staging ring used to upload to device-local buffers.
+        [[nodiscard]] auto stagingRing() const
+        {
+            return m_stagingRing.get();
+        }
+
+        /// Accessor.
+        /// \return The presentation surface, which is null for a headless context.
         [[nodiscard]] auto surface() const
         {
             return m_surface;
@@ -135,30 +216,40 @@ namespace com::rhi
         /// Wait for the device to become idle.
         void waitForIdle();
 
+        /// Wait for a timeline semaphore to reach a value.
+        /// \param semaphore The semaphore to wait on.
+        /// \param value The value to wait for.
+        /// \param timeout A timeout value.
+        void waitForSemaphore(vk::Semaphore const& semaphore, uint64_t const value, uint64_t const timeout = std::numeric_limits<uint64_t>::max());
+
     private:
         void createDebugUtility();
         void createSurface(void const* connection, void const* display);
 
     private:
-        vk::Instance                    m_instance;
-        std::unique_ptr<DebugUtil>      m_debugUtil;
-        vk::SurfaceKHR                  m_surface;
-        std::unique_ptr<PhysicalDevice> m_physicalDevice;
-        vk::Format                      m_colorFormat;
-        vk::Format                      m_depthFormat;
-        uint32_t                        m_computeQueueIndex  = 0;
-        uint32_t                        m_graphicsQueueIndex = 0;
-        uint32_t                        m_presentQueueIndex  = 0;
-        uint32_t                        m_transferQueueIndex = 0;
-        std::unique_ptr<Device>         m_device;
-        std::unique_ptr<Queue>          m_computeQueue;
-        std::unique_ptr<Queue>          m_graphicsQueue;
-        std::unique_ptr<Queue>          m_presentQueue;
-        std::unique_ptr<Queue>          m_transferQueue;
-        vk::PipelineCache               m_pipelineCache;
+        vk::Instance                        m_instance;
+        std::unique_ptr<DebugUtil>          m_debugUtil;
+        vk::SurfaceKHR                      m_surface;
+        std::unique_ptr<PhysicalDevice>     m_physicalDevice;
+        vk::Format                          m_colorFormat;
+        vk::Format                          m_depthFormat;
+        uint32_t                            m_computeQueueIndex  = 0;
+        uint32_t                            m_graphicsQueueIndex = 0;
+        uint32_t                            m_presentQueueIndex  = 0;
+        uint32_t                            m_transferQueueIndex = 0;
+        std::unique_ptr<Device>             m_device;
+        std::unique_ptr<Queue>              m_computeQueue;
+        std::unique_ptr<Queue>              m_graphicsQueue;
+        std::unique_ptr<Queue>              m_presentQueue;
+        std::unique_ptr<Queue>              m_transferQueue;
+        vk::PipelineCache                   m_pipelineCache;
+        std::unique_ptr<StagingRing>        m_stagingRing;
+        std::unique_ptr<PrimitiveGenerator> m_primitiveGenerator;
 
         std::vector<std::unique_ptr<FrameData>> m_perFrameData;
         uint32_t                                m_currentFrameIndex = 0;
+        vk::Semaphore                           m_frameTimeline;
+        uint64_t                                m_frameValue = 0;
     };
 
 } // namespace com::rhi
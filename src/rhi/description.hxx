@@ -20,7 +20,15 @@ namespace com::rhi
         std::vector<std::string>   deviceLayers;               ///< Required layers.
         std::vector<std::string>   deviceExtensions;           ///< Required extensions.
         vk::PhysicalDeviceFeatures deviceFeatures;             ///< Device features.
-        void const*                windowHandle     = nullptr; ///< A handle to the underlying window.
+        void const*                windowHandle     = nullptr; ///< A handle to the underlying window, or nullptr for a headless context.
         void const*                windowConnection = nullptr; ///< The X connection of the application, for use with XCB.
+
+        /// Vulkan 1.2 device features, which the renderer relies upon whatever the application.
+        vk::PhysicalDeviceVulkan12Features deviceFeatures12 = vk::PhysicalDeviceVulkan12Features()
+                                                                  .setDrawIndirectCount(true)
+                                                                  .setHostQueryReset(true)
+                                                                  .setScalarBlockLayout(true)
+                                                                  .setTimelineSemaphore(true)
+                                                                  .setBufferDeviceAddress(true);
     };
 } // namespace com::rhi
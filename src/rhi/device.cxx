@@ -26,14 +26,16 @@ namespace com::rhi
         auto deviceFeatures           = description.deviceFeatures;
         auto dynamicRenderingFeatures = vk::PhysicalDeviceDynamicRenderingFeatures(true);
         auto featureSynchronization2  = vk::PhysicalDeviceSynchronization2Features(true, &dynamicRenderingFeatures);
-        auto queryResetFeatures       = vk::PhysicalDeviceHostQueryResetFeatures(true, &featureSynchronization2);
+        auto vulkan12Features         = vk::PhysicalDeviceVulkan12Features(description.deviceFeatures12).setPNext(&featureSynchronization2);
 
-        auto const info = vk::DeviceCreateInfo({}, queueCreateInfos, layers, extensions, &deviceFeatures, &queryResetFeatures);
+        auto const info = vk::DeviceCreateInfo({}, queueCreateInfos, layers, extensions, &deviceFeatures, &vulkan12Features);
         m_device        = static_cast<vk::PhysicalDevice>(*m_physicalDevice).createDevice(info);
+        m_allocator     = std::make_unique<Allocator>(m_device, *m_physicalDevice);
     }
 
     Device::~Device()
     {
+        m_allocator.reset();
         m_device.destroy();
     }
 
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "rhi/allocator.hxx"
 #include "rhi/description.hxx"
 #include "rhi/physical-device.hxx"
 
@@ -22,6 +23,13 @@ namespace com::rhi
         /// Destructor.
         ~Device();
 
+        /// Accessor.
+        /// \return The memory allocator.
+        [[nodiscard]] auto allocator() const
+        {
+            return m_allocator.get();
+        }
+
         /// Create a semaphore.
         /// \return A valid Vuulkan object.
         [[nodiscard]] auto createSemaphore() const -> vk::Semaphore
@@ -50,9 +58,10 @@ namespace com::rhi
         }
 
     private:
-        class Context const*  m_context        = nullptr;
-        PhysicalDevice const* m_physicalDevice = nullptr;
-        vk::Device            m_device;
+        class Context const*       m_context        = nullptr;
+        PhysicalDevice const*      m_physicalDevice = nullptr;
+        vk::Device                 m_device;
+        std::unique_ptr<Allocator> m_allocator;
     };
 
     /// Find the memory type index.
@@ -3,9 +3,15 @@
 //
 
 #include "rhi/hit-testing.hxx"
+#include "rhi/context.hxx"
+#include "rhi/pipeline.hxx"
+#include "rhi/utilities.hxx"
 
 namespace com::rhi
 {
+    /// The offset of the footprint in a readback, after the pixel's depth and normal.
+    static constexpr vk::DeviceSize s_footprintOffset = 8 * sizeof(float);
+
     [[nodiscard]] static auto sign(float x)
     {
         return (x < 0.0f) ? -1.0f : 1.0f;
@@ -32,10 +38,11 @@ namespace com::rhi
 
     auto createMouseHit(uint32_t const x, uint32_t const y, uint32_t const w, uint32_t const h, Buffer* buffer) -> std::unique_ptr<MouseHit>
     {
-        uint8_t const* ptr    = static_cast<uint8_t const*>(buffer->map());
+        buffer->invalidate(0, sizeof(float) + sizeof(uint32_t));
+
+        uint8_t const* ptr    = static_cast<uint8_t const*>(buffer->data());
         float          sz     = *reinterpret_cast<float const*>(ptr);
         uint32_t       normal = *reinterpret_cast<uint32_t const*>(ptr + sizeof(float));
-        buffer->unmap();
 
         if (sz > 0.0)
         {
@@ -47,4 +54,138 @@ namespace com::rhi
 
         return {};
     }
+
+    HitQueries::HitQueries(Context* context, Callback callback) : m_context(context), m_callback(std::move(callback))
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        // The tile and the readback are addressed directly, so the pipeline has no descriptor sets.
+        auto const pushConstants = vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(FootprintUniform));
+        m_pipelineLayout         = device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, {}, pushConstants));
+
+        m_shader   = createShader(device, "footprint.comp");
+        m_pipeline = createComputePipeline(m_context, m_shader, m_pipelineLayout);
+    }
+
+    HitQueries::~HitQueries()
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        device.destroyPipeline(m_pipeline);
+        device.destroyShaderModule(m_shader);
+        device.destroyPipelineLayout(m_pipelineLayout);
+    }
+
+    void HitQueries::poll()
+    {
+        auto const completed = m_context->completedFrameValue();
+        Slot*      newest    = nullptr;
+
+        for (auto& slot : m_slots)
+        {
+            if (!slot.isPending || slot.value > completed)
+                continue;
+
+            // Requests complete in the order that they were made, so any but the newest are stale.
+            slot.isPending = false;
+            if (!newest || slot.serial > newest->serial)
+                newest = &slot;
+        }
+
+        if (!newest)
+            return;
+
+        auto hit = createMouseHit(newest->x, newest->y, newest->extent.width, newest->extent.height, newest->buffer.get());
+        if (!hit)
+        {
+            m_callback(std::nullopt);
+            return;
+        }
+
+        // The hit is unprojected with the camera that it was rendered with, so it stays exact if the camera has since moved.
+        auto const world = newest->unproject * glm::vec4(hit->point, 1.0f);
+        hit->point       = glm::vec3(world) / world.w;
+
+        newest->buffer->invalidate(s_footprintOffset, sizeof(FootprintResult));
+
+        auto const* footprint      = reinterpret_cast<FootprintResult const*>(static_cast<uint8_t const*>(newest->buffer->data()) + s_footprintOffset);
+        hit->footprint.normal     = footprint->normal;
+        hit->footprint.centre     = footprint->centre;
+        hit->footprint.plane      = footprint->plane;
+        hit->footprint.depthRange = glm::vec2(footprint->min_depth, footprint->max_depth);
+        hit->footprint.pixelCount = footprint->count;
+
+        m_callback(*hit);
+    }
+
+    void HitQueries::request(uint32_t const           x,
+                             uint32_t const           y,
+                             vk::Extent2D const&      extent,
+                             glm::mat4 const&         unproject,
+                             vk::Rect2D const&        tile,
+                             float const              radius,
+                             Image const*             depth,
+                             Image const*             normal,
+                             vk::CommandBuffer const& commandBuffer)
+    {
+        // The footprint reduction reads the tile and writes its result through their device addresses.
+        auto const usage = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+
+        // A readback is added whenever every other one is in flight, so there are never more than the frames in flight.
+        auto slot = std::ranges::find_if(m_slots, [](auto const& slot) { return !slot.isPending; });
+        if (slot == m_slots.end())
+        {
+            m_slots.emplace_back().buffer = std::make_unique<Buffer>(m_context, s_footprintOffset + sizeof(FootprintResult), usage);
+            slot                          = std::prev(m_slots.end());
+        }
+
+        // The tile's depths are followed by its normals, each four bytes per pixel.
+        auto const pixelCount = static_cast<vk::DeviceSize>(tile.extent.width) * tile.extent.height;
+        if (!slot->pixels || slot->pixels->size() < 2 * sizeof(uint32_t) * pixelCount)
+            slot->pixels = std::make_unique<Buffer>(m_context, 2 * sizeof(uint32_t) * pixelCount, usage, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+        slot->unproject = unproject;
+        slot->x         = x;
+        slot->y         = y;
+        slot->extent    = extent;
+        slot->value     = m_context->pendingFrameValue();
+        slot->serial    = ++m_serial;
+        slot->isPending = true;
+
+        auto const centreX = x - tile.offset.x;
+        auto const centreY = y - tile.offset.y;
+        auto const rect    = vk::Rect2D({ 0, 0 }, tile.extent);
+
+        depth->copyPixel(centreX, centreY, 0, commandBuffer, slot->buffer.get());
+        normal->copyPixel(centreX, centreY, 4, commandBuffer, slot->buffer.get());
+        depth->copyRect(rect, 0, commandBuffer, slot->pixels.get());
+        normal->copyRect(rect, sizeof(uint32_t) * pixelCount, commandBuffer, slot->pixels.get());
+
+        auto const copyBarrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eTransfer,
+                                                    vk::AccessFlagBits2::eTransferWrite,
+                                                    vk::PipelineStageFlagBits2::eComputeShader,
+                                                    vk::AccessFlagBits2::eShaderStorageRead);
+        commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, copyBarrier, {}, {}));
+
+        FootprintUniform constants = {};
+        constants.unproject        = unproject;
+        constants.pixels           = slot->pixels->deviceAddress();
+        constants.result           = slot->buffer->deviceAddress() + s_footprintOffset;
+        constants.origin           = glm::uvec2(tile.offset.x, tile.offset.y);
+        constants.tile             = glm::uvec2(tile.extent.width, tile.extent.height);
+        constants.extent           = glm::uvec2(extent.width, extent.height);
+        constants.centre           = glm::uvec2(centreX, centreY);
+        constants.radius           = radius;
+
+        // A single workgroup reduces the whole tile.
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+        commandBuffer.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(FootprintUniform), &constants);
+        commandBuffer.dispatch(1, 1, 1);
+
+        auto const barrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eTransfer | vk::PipelineStageFlagBits2::eComputeShader,
+                                                vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eShaderStorageWrite,
+                                                vk::PipelineStageFlagBits2::eHost,
+                                                vk::AccessFlagBits2::eHostRead);
+        commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, barrier, {}, {}));
+    }
 } // namespace com::rhi
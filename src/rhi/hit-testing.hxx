@@ -5,16 +5,33 @@
 #pragma once
 
 #include "rhi/buffer.hxx"
+#include "rhi/image.hxx"
+#include "rhi/shaders/uniforms.hxx"
+#include "rhi/shaders/footprint.hxx"
 
+#include <algorithm>
+#include <functional>
 #include <glm/glm.hpp>
+#include <optional>
 
 namespace com::rhi
 {
+    /// The surface around a mouse hit, averaged over the hit-test tile.
+    struct Footprint
+    {
+        glm::vec3 normal;         ///< The averaged world-space unit normal.
+        glm::vec3 centre;         ///< The world-space centroid.
+        glm::vec4 plane;          ///< The plane through the centroid that faces along the normal, as the normal and its distance.
+        glm::vec2 depthRange;     ///< The smallest and largest depths, in normalised device coordinates.
+        uint32_t  pixelCount = 0; ///< The number of pixels that were averaged, or zero if there was nothing to average.
+    };
+
     /// Represents a mouse hit.
     struct MouseHit
     {
-        glm::vec3 point;  ///< The world-space position.
-        glm::vec3 normal; ///< The normal.
+        glm::vec3 point;     ///< The world-space position.
+        glm::vec3 normal;    ///< The normal.
+        Footprint footprint; ///< The surface around the hit, if it has been reduced.
     };
 
     /// Create a mouse-hit from a buffer.
@@ -23,6 +40,81 @@ namespace com::rhi
     /// \param w The viewport width.
     /// \param h The viewport height.
     /// \param buffer.
-    /// \return A valid object on success; nothing otherwise.
+    /// \return A valid object, whose point is in normalised device coordinates, on success; nothing otherwise.
     [[nodiscard]] auto createMouseHit(uint32_t const x, uint32_t const y, uint32_t const w, uint32_t const h, Buffer* buffer) -> std::unique_ptr<MouseHit>;
+
+    /// Reads hits back from the hit-test images without stalling. Alongside the pixel under the mouse, the whole tile is reduced
+    /// on the device into a footprint, so that brushes can be oriented to the surface around the hit rather than one pixel.
+    /// Each request is tagged with the value that its frame will
+    /// signal on the context's frame timeline, and is resolved by poll() once that frame has completed on the device; hits
+    /// therefore arrive one or more frames after they are requested. Only the newest completed request is delivered, as any
+    /// older ones have been superseded.
+    class HitQueries final
+    {
+    public:
+        /// Receives the result of a request: the hit, in world-space, if a model was under the point; nothing otherwise.
+        using Callback = std::function<void(std::optional<MouseHit> const& hit)>;
+
+        /// Constructor.
+        /// \param context The RHI context.
+        /// \param callback The function that receives results.
+        explicit HitQueries(class Context* context, Callback callback);
+
+        /// Destructor.
+        ~HitQueries();
+
+        /// Determines if any request is yet to be delivered.
+        /// \return true if a request is in flight; false otherwise.
+        [[nodiscard]] auto isPending() const
+        {
+            return std::ranges::any_of(m_slots, [](auto const& slot) { return slot.isPending; });
+        }
+
+        /// Deliver the newest request whose frame has completed, if any; this never waits.
+        void poll();
+
+        /// Record the read back of a pixel of the hit-test images, which must be transfer sources, and the reduction of the
+        /// images into a footprint.
+        /// \param x The horizontal offset of the pixel in the viewport.
+        /// \param y The vertical offset of the pixel in the viewport.
+        /// \param extent The extent of the viewport.
+        /// \param unproject The inverse view-projection that the images were rendered with.
+        /// \param tile The rect of the viewport that the images cover.
+        /// \param radius The world-space radius around the hit to average the footprint over, or zero for the whole tile.
+        /// \param depth The hit-test depth image.
+        /// \param normal The hit-test normal image.
+        /// \param commandBuffer The frame's command buffer.
+        void request(uint32_t const           x,
+                     uint32_t const           y,
+                     vk::Extent2D const&      extent,
+                     glm::mat4 const&         unproject,
+                     vk::Rect2D const&        tile,
+                     float const              radius,
+                     Image const*             depth,
+                     Image const*             normal,
+                     vk::CommandBuffer const& commandBuffer);
+
+    private:
+        /// A readback and the request that it carries.
+        struct Slot final
+        {
+            std::unique_ptr<Buffer> buffer;            ///< The pixel's depth and normal, followed by the footprint.
+            std::unique_ptr<Buffer> pixels;            ///< The tile's depths and normals, which the footprint is reduced from.
+            glm::mat4               unproject;         ///< The inverse view-projection of the request.
+            uint32_t                x         = 0;     ///< The horizontal offset of the pixel.
+            uint32_t                y         = 0;     ///< The vertical offset of the pixel.
+            vk::Extent2D            extent;            ///< The extent of the viewport.
+            uint64_t                value     = 0;     ///< The frame timeline value at which the readback is complete.
+            uint64_t                serial    = 0;     ///< The order in which the request was made.
+            bool                    isPending = false; ///< Whether the request is yet to be resolved.
+        };
+
+        class Context*     m_context = nullptr;
+        Callback           m_callback;
+        std::vector<Slot>  m_slots;
+        uint64_t           m_serial = 0;
+        vk::PipelineLayout m_pipelineLayout;
+        vk::ShaderModule   m_shader;
+        vk::Pipeline       m_pipeline;
+    };
 } // namespace com::rhi
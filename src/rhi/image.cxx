@@ -170,7 +170,7 @@ namespace com::rhi
     }
 
     Image::Image(Device const* device, vk::Extent2D const& extent, vk::Format format, vk::ImageUsageFlags const usage)
-        : m_device(device->logicalDevice()), m_isManaged(true), m_format(format), m_currentUsage(Usage::eUndefined)
+        : m_device(device->logicalDevice()), m_allocator(device->allocator()), m_isManaged(true), m_format(format), m_currentUsage(Usage::eUndefined)
     {
         vk::ImageCreateInfo info({},
                                  vk::ImageType::e2D,
@@ -188,11 +188,8 @@ namespace com::rhi
 
         m_image = m_device.createImage(info);
 
-        auto const memReqs = getMemoryRequirements();
-        auto const index = findMemoryTypeIndex(device->physicalDevice().getMemoryProperties(), memReqs.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
-
-        m_memory = m_device.allocateMemory(vk::MemoryAllocateInfo(memReqs.size, *index));
-        m_device.bindImageMemory(m_image, m_memory, 0);
+        m_allocation = m_allocator->allocate(getMemoryRequirements(), vk::MemoryPropertyFlagBits::eDeviceLocal, AllocationKind::eOptimal);
+        m_device.bindImageMemory(m_image, m_allocation.memory, m_allocation.offset);
 
         m_aspect            = isDepthFormat(m_format) ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor;
         auto const subRange = vk::ImageSubresourceRange(m_aspect, 0, 1, 0, 1);
@@ -214,7 +211,7 @@ namespace com::rhi
         if (m_isManaged)
         {
             m_device.destroyImage(m_image);
-            m_device.freeMemory(m_memory);
+            m_allocator->free(m_allocation);
         }
     }
 
@@ -237,6 +234,16 @@ namespace com::rhi
         commandBuffer.copyImageToBuffer(m_image, layout(), destination->buffer(), region);
     }
 
+    void Image::copyRect(vk::Rect2D const& rect, vk::DeviceSize const& offset, vk::CommandBuffer const& commandBuffer, class Buffer* destination) const
+    {
+        auto const imageSubresource = vk::ImageSubresourceLayers(m_aspect, 0, 0, 1);
+        auto const imageOffset      = vk::Offset3D(rect.offset.x, rect.offset.y, 0);
+        auto const imageExtent      = vk::Extent3D(rect.extent, 1);
+        auto const region           = vk::BufferImageCopy(offset, {}, {}, imageSubresource, imageOffset, imageExtent);
+
+        commandBuffer.copyImageToBuffer(m_image, layout(), destination->buffer(), region);
+    }
+
     auto Image::layout() const -> vk::ImageLayout
     {
         return usageToLayout(m_currentUsage, m_aspect);
@@ -53,6 +53,13 @@ namespace com::rhi
         /// \param destination The target memory.
         void copyPixel(uint32_t const x, uint32_t const y, vk::DeviceSize const& offset, vk::CommandBuffer const& commandBuffer, class Buffer* destination) const;
 
+        /// Copy a rectangle of pixels, tightly packed.
+        /// \param rect The rectangle to copy.
+        /// \param offset The offset into the target buffer.
+        /// \param commandBuffer The command buffer.
+        /// \param destination The target memory.
+        void copyRect(vk::Rect2D const& rect, vk::DeviceSize const& offset, vk::CommandBuffer const& commandBuffer, class Buffer* destination) const;
+
         /// Accessor.
         /// \return The image view.
         [[nodiscard]] auto imageView() const
@@ -80,14 +87,15 @@ namespace com::rhi
         [[nodiscard]] auto getMemoryRequirements() const -> vk::MemoryRequirements;
 
     protected:
-        vk::Device           m_device;            ///< The Vulkan device.
-        bool                 m_isManaged = false; ///< Determines if the resources should be freed upon destruction.
-        vk::Image            m_image;             ///< The image.
-        vk::Format           m_format;            ///< The format.
-        vk::ImageAspectFlags m_aspect;            ///< The aspect.
-        Usage                m_currentUsage;      ///< The current usage.
-        vk::ImageView        m_view;              ///< The view.
-        vk::DeviceMemory     m_memory;            ///< The memory backing the buffer.s
+        vk::Device           m_device;              ///< The Vulkan device.
+        Allocator*           m_allocator = nullptr; ///< The memory allocator.
+        bool                 m_isManaged = false;   ///< Determines if the resources should be freed upon destruction.
+        vk::Image            m_image;               ///< The image.
+        vk::Format           m_format;              ///< The format.
+        vk::ImageAspectFlags m_aspect;              ///< The aspect.
+        Usage                m_currentUsage;        ///< The current usage.
+        vk::ImageView        m_view;                ///< The view.
+        Allocation           m_allocation;          ///< The memory backing the image.
     };
 
 } // namespace com::rhi
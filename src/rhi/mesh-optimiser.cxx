@@ -0,0 +1,340 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "rhi/mesh-optimiser.hxx"
+#include "base/message.hxx"
+#include "rhi/parallel.hxx"
+
+#include <glm/common.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+namespace com::rhi
+{
+    /// The size of the cache that meshes are optimised for; most hardware keeps at least this many vertices.
+    static constexpr uint32_t s_cacheSize = 16;
+
+    /// The number of triangles in each run that is reordered on its own thread. Runs are large enough that the few cache
+    /// misses at their seams are lost in the noise.
+    static constexpr uint32_t s_runTriangleCount = 1 << 16;
+
+    /// The number of cells along each axis of the grid that large meshes are bucketed by before they are split into runs.
+    static constexpr uint32_t s_cellsPerAxis = 32;
+
+    /// The largest range of vertex indices, relative to a run's index count, that is renumbered through a table.
+    static constexpr uint32_t s_renumberTableRatio = 16;
+
+    /// Marks a missing vertex.
+    static constexpr uint32_t s_none = std::numeric_limits<uint32_t>::max();
+
+    /// Reorder the triangles of an index list whose vertices are numbered from zero.
+    /// \param indices The indices, which are reordered in place.
+    /// \param vertexCount The number of vertices.
+    /// \param cacheSize The number of vertices that the cache holds.
+    static void tipsify(std::span<uint32_t> const indices, uint32_t const vertexCount, uint32_t const cacheSize)
+    {
+        auto const triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+        // The triangles that use each vertex, as runs of one array. A degenerate triangle is listed once per corner.
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (auto const index : indices)
+            ++offsets[index + 1];
+
+        for (auto vertex = 0u; vertex < vertexCount; ++vertex)
+            offsets[vertex + 1] += offsets[vertex];
+
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+            adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+        // The number of triangles still to be emitted that use each vertex, and when each vertex last entered the cache.
+        std::vector<uint32_t> live(vertexCount);
+        for (auto vertex = 0u; vertex < vertexCount; ++vertex)
+            live[vertex] = offsets[vertex + 1] - offsets[vertex];
+
+        std::vector<uint32_t> cachedAt(vertexCount, 0);
+        std::vector<bool>     isEmitted(triangleCount, false);
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+
+        auto time = cacheSize + 1;
+        auto scan = 0u;
+
+        // When the fan has nowhere to go, restart from the most recently used vertex that still has triangles, and failing
+        // that from the next such vertex in input order.
+        auto const skipDeadEnd = [&]()
+        {
+            while (!deadEnds.empty())
+            {
+                auto const vertex = deadEnds.back();
+                deadEnds.pop_back();
+
+                if (live[vertex] > 0)
+                    return vertex;
+            }
+
+            for (; scan < vertexCount; ++scan)
+            {
+                if (live[scan] > 0)
+                    return scan;
+            }
+
+            return s_none;
+        };
+
+        // Prefer the candidate that entered the cache earliest, as long as fanning around it will not push it out.
+        auto const nextVertex = [&]()
+        {
+            auto best         = s_none;
+            auto bestPriority = 0u;
+
+            for (auto const vertex : candidates)
+            {
+                if (live[vertex] == 0)
+                    continue;
+
+                auto const age      = time - cachedAt[vertex];
+                auto const priority = age + 2 * live[vertex] <= cacheSize ? age : 0u;
+                if (best == s_none || priority > bestPriority)
+                {
+                    best         = vertex;
+                    bestPriority = priority;
+                }
+            }
+
+            return best != s_none ? best : skipDeadEnd();
+        };
+
+        for (auto fan = skipDeadEnd(); fan != s_none; fan = nextVertex())
+        {
+            candidates.clear();
+
+            for (auto k = offsets[fan]; k < offsets[fan + 1]; ++k)
+            {
+                auto const triangle = adjacency[k];
+                if (isEmitted[triangle])
+                    continue;
+
+                isEmitted[triangle] = true;
+
+                for (auto corner = 0u; corner < 3; ++corner)
+                {
+                    auto const vertex = indices[3 * triangle + corner];
+
+                    output.emplace_back(vertex);
+                    deadEnds.emplace_back(vertex);
+                    candidates.emplace_back(vertex);
+                    --live[vertex];
+
+                    if (time - cachedAt[vertex] > cacheSize)
+                        cachedAt[vertex] = time++;
+                }
+            }
+        }
+
+        std::ranges::copy(output, indices.begin());
+    }
+
+    /// Renumber the vertices of a run of triangles from zero.
+    /// \param indices The run's indices.
+    /// \param local Receives the renumbered indices.
+    /// \return The original index of each renumbered vertex.
+    [[nodiscard]] static auto renumber(std::span<uint32_t const> const indices, std::span<uint32_t> const local) -> std::vector<uint32_t>
+    {
+        std::vector<uint32_t> vertices;
+        auto const [smallest, largest] = std::ranges::minmax(indices);
+
+        // Runs usually use a narrow range of the vertices, which a table can map directly; otherwise they are sorted.
+        if (largest - smallest < s_renumberTableRatio * indices.size())
+        {
+            std::vector<uint32_t> table(largest - smallest + 1, s_none);
+            for (size_t i = 0; i < indices.size(); ++i)
+            {
+                auto& slot = table[indices[i] - smallest];
+                if (slot == s_none)
+                {
+                    slot = static_cast<uint32_t>(vertices.size());
+                    vertices.emplace_back(indices[i]);
+                }
+
+                local[i] = slot;
+            }
+
+            return vertices;
+        }
+
+        vertices.assign(indices.begin(), indices.end());
+        std::ranges::sort(vertices);
+        vertices.erase(std::ranges::unique(vertices).begin(), vertices.end());
+
+        for (size_t i = 0; i < indices.size(); ++i)
+            local[i] = static_cast<uint32_t>(std::ranges::lower_bound(vertices, indices[i]) - vertices.begin());
+
+        return vertices;
+    }
+
+    auto analyseVertexCache(std::span<uint32_t const> const indices, uint32_t const vertexCount, uint32_t const cacheSize)
+    -> VertexCacheStatistics
+    {
+        if (indices.empty())
+            return {};
+
+        // A vertex is in the cache if no more than cacheSize vertices have entered since it did.
+        std::vector<uint32_t> cachedAt(vertexCount, 0);
+        std::vector<bool>     isUsed(vertexCount, false);
+
+        auto time      = cacheSize + 1;
+        auto usedCount = 0u;
+
+        for (auto const index : indices)
+        {
+            if (time - cachedAt[index] > cacheSize)
+                cachedAt[index] = time++;
+
+            if (!isUsed[index])
+            {
+                isUsed[index] = true;
+                ++usedCount;
+            }
+        }
+
+        auto const misses = static_cast<float>(time - cacheSize - 1);
+        return { misses / static_cast<float>(indices.size() / 3), misses / static_cast<float>(usedCount) };
+    }
+
+    void optimiseVertexCache(std::span<uint32_t> const indices, std::span<glm::vec3 const> const positions, uint32_t const cacheSize)
+    {
+        auto const vertexCount   = static_cast<uint32_t>(positions.size());
+        auto const triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        if (triangleCount <= s_runTriangleCount)
+        {
+            tipsify(indices, vertexCount, cacheSize);
+            return;
+        }
+
+        // The triangles are first bucketed by the cell of a coarse grid that their first corner is in, with the cells in
+        // Morton order, so that every run is a compact patch of the surface whatever order the triangles arrived in.
+        glm::vec3 lo(std::numeric_limits<float>::max());
+        glm::vec3 hi(std::numeric_limits<float>::lowest());
+        for (auto const& position : positions)
+        {
+            lo = glm::min(lo, position);
+            hi = glm::max(hi, position);
+        }
+
+        auto const scale = static_cast<float>(s_cellsPerAxis) / glm::max(hi - lo, glm::vec3(std::numeric_limits<float>::min()));
+        auto const cell  = [&](glm::vec3 const& position)
+        {
+            auto const c = glm::min(glm::uvec3((position - lo) * scale), glm::uvec3(s_cellsPerAxis - 1));
+
+            auto code = 0u;
+            for (auto bit = 0u; (1u << bit) < s_cellsPerAxis; ++bit)
+                code |= (((c.x >> bit) & 1) << (3 * bit)) | (((c.y >> bit) & 1) << (3 * bit + 1)) | (((c.z >> bit) & 1) << (3 * bit + 2));
+
+            return code;
+        };
+
+        std::vector<uint32_t> cells(triangleCount);
+        parallelFor(triangleCount, [&](uint32_t const triangle) { cells[triangle] = cell(positions[indices[3 * triangle]]); });
+
+        std::vector<uint32_t> offsets(s_cellsPerAxis * s_cellsPerAxis * s_cellsPerAxis + 1, 0);
+        for (auto const code : cells)
+            ++offsets[code + 1];
+
+        for (size_t code = 1; code < offsets.size(); ++code)
+            offsets[code] += offsets[code - 1];
+
+        std::vector<uint32_t> bucketed(indices.size());
+        for (auto triangle = 0u; triangle < triangleCount; ++triangle)
+        {
+            auto const slot = offsets[cells[triangle]]++;
+            std::copy_n(indices.begin() + 3 * triangle, 3, bucketed.begin() + 3 * slot);
+        }
+
+        std::ranges::copy(bucketed, indices.begin());
+
+        // Each run renumbers its own vertices from zero, so that its tables are sized by the run rather than the mesh.
+        auto const runCount = (triangleCount + s_runTriangleCount - 1) / s_runTriangleCount;
+
+        parallelFor(runCount,
+                    [&](uint32_t const run)
+                    {
+                        auto const first     = 3 * run * s_runTriangleCount;
+                        auto const count     = 3 * std::min(s_runTriangleCount, triangleCount - run * s_runTriangleCount);
+                        auto const triangles = indices.subspan(first, count);
+
+                        std::vector<uint32_t> local(count);
+                        auto const            vertices = renumber(triangles, local);
+
+                        tipsify(local, static_cast<uint32_t>(vertices.size()), cacheSize);
+
+                        for (auto i = 0u; i < count; ++i)
+                            triangles[i] = vertices[local[i]];
+                    });
+    }
+
+    void optimiseVertexFetch(std::span<uint32_t> const indices, std::span<glm::vec3> const positions, std::span<uint32_t> const colours)
+    {
+        auto const vertexCount = static_cast<uint32_t>(positions.size());
+
+        // The new number of each vertex is the order of its first use.
+        std::vector<uint32_t> remap(vertexCount, s_none);
+        auto                  next = 0u;
+
+        for (auto const index : indices)
+        {
+            if (remap[index] == s_none)
+                remap[index] = next++;
+        }
+
+        for (auto& vertex : remap)
+        {
+            if (vertex == s_none)
+                vertex = next++;
+        }
+
+        std::vector<glm::vec3> reorderedPositions(vertexCount);
+        std::vector<uint32_t>  reorderedColours(vertexCount);
+
+        parallelFor(vertexCount,
+                    [&](uint32_t const vertex)
+                    {
+                        reorderedPositions[remap[vertex]] = positions[vertex];
+                        reorderedColours[remap[vertex]]   = colours[vertex];
+                    });
+
+        parallelFor(static_cast<uint32_t>(indices.size()), [&](uint32_t const i) { indices[i] = remap[indices[i]]; });
+
+        std::ranges::copy(reorderedPositions, positions.begin());
+        std::ranges::copy(reorderedColours, colours.begin());
+    }
+
+    auto optimiseMesh(std::span<uint32_t> const indices, std::span<glm::vec3> const positions, std::span<uint32_t> const colours) -> MeshOptimisation
+    {
+        auto const vertexCount = static_cast<uint32_t>(positions.size());
+
+        MeshOptimisation result;
+        result.before = analyseVertexCache(indices, vertexCount, s_cacheSize);
+
+        optimiseVertexCache(indices, positions, s_cacheSize);
+        optimiseVertexFetch(indices, positions, colours);
+
+        result.after = analyseVertexCache(indices, vertexCount, s_cacheSize);
+
+        std::ostringstream message;
+        message << std::fixed << std::setprecision(3) << "Optimised a mesh of " << indices.size() / 3 << " triangles: ACMR "
+                << result.before.acmr << " -> " << result.after.acmr << ", ATVR " << result.before.atvr << " -> " << result.after.atvr << ".";
+        base::outputDebug(message.str());
+
+        return result;
+    }
+} // namespace com::rhi
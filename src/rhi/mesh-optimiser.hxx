@@ -0,0 +1,56 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <span>
+
+namespace com::rhi
+{
+    /// Describes how well an index order uses a FIFO post-transform vertex cache.
+    struct VertexCacheStatistics final
+    {
+        float acmr = 0.0f; ///< The average cache miss ratio, i.e., vertices transformed per triangle; 3 is the worst.
+        float atvr = 0.0f; ///< The average transformed vertex ratio, i.e., vertices transformed per vertex used; 1 is ideal.
+    };
+
+    /// The statistics of a mesh either side of optimisation.
+    struct MeshOptimisation final
+    {
+        VertexCacheStatistics before; ///< The statistics of the original order.
+        VertexCacheStatistics after;  ///< The statistics of the optimised order.
+    };
+
+    /// Simulate a FIFO vertex cache over a triangle list.
+    /// \param indices Indices into the vertices, three per triangle.
+    /// \param vertexCount The number of vertices.
+    /// \param cacheSize The number of vertices that the cache holds.
+    /// \return The statistics.
+    [[nodiscard]] auto analyseVertexCache(std::span<uint32_t const> const indices, uint32_t const vertexCount, uint32_t const cacheSize)
+    -> VertexCacheStatistics;
+
+    /// Reorder triangles so that consecutive triangles share vertices that are still in the post-transform cache, with
+    /// Sander et al.'s Tipsify. Large meshes are bucketed into compact patches, which are split into runs of triangles that
+    /// are reordered in parallel.
+    /// \param indices Indices into the vertices, three per triangle, which are reordered in place.
+    /// \param positions The vertex positions.
+    /// \param cacheSize The number of vertices that the cache holds.
+    void optimiseVertexCache(std::span<uint32_t> const indices, std::span<glm::vec3 const> const positions, uint32_t const cacheSize);
+
+    /// Renumber the vertices in the order that the triangles first use them, so that vertex fetches walk memory forwards.
+    /// Vertices that no triangle uses are moved to the end.
+    /// \param indices Indices into the vertices, three per triangle, which are remapped in place.
+    /// \param positions The vertex positions, which are reordered in place.
+    /// \param colours The colour of each vertex, which are reordered in place.
+    void optimiseVertexFetch(std::span<uint32_t> const indices, std::span<glm::vec3> const positions, std::span<uint32_t> const colours);
+
+    /// Optimise a mesh for the vertex cache and then for vertex fetch, and report the statistics as a debug message.
+    /// \param indices Indices into the vertices, three per triangle.
+    /// \param positions The vertex positions.
+    /// \param colours The colour of each vertex.
+    /// \return The statistics before and after.
+    auto optimiseMesh(std::span<uint32_t> const indices, std::span<glm::vec3> const positions, std::span<uint32_t> const colours) -> MeshOptimisation;
+} // namespace com::rhi
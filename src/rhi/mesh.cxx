@@ -3,56 +3,159 @@
 //
 
 #include "rhi/mesh.hxx"
+#include "rhi/context.hxx"
 #include "rhi/utilities.hxx"
 
 namespace com::rhi
 {
-    Mesh::Mesh(Context* context, MeshDescription const* description) : m_context(context)
+    MeshStreams::MeshStreams(Context* context, uint32_t const vertexCount, uint32_t const indexCount)
+        : m_vertexCount(vertexCount), m_indexCount(indexCount)
     {
-        auto const        numVertices = description->points.size();
-        auto const        numPolygons = description->indices.size() / 3;
-        BufferDescription desc;
+        auto const usage = vk::BufferUsageFlagBits::eTransferSrc;
 
-        // Index buffer.
-        desc.flags = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc;
-        desc.size  = sizeof(glm::uvec3) * numPolygons;
-        if (m_buffers[BufferTypeIndex] = std::make_unique<Buffer>(m_context, desc.size, desc.flags); m_buffers[BufferTypeIndex])
+        m_positions = std::make_unique<Buffer>(context, sizeof(glm::vec3) * vertexCount, usage);
+        m_indices   = std::make_unique<Buffer>(context, sizeof(uint32_t) * indexCount, usage);
+        m_colours   = std::make_unique<Buffer>(context, sizeof(uint32_t) * vertexCount, usage);
+    }
+
+    Mesh::Mesh(Context* context, MeshStreams streams) : m_context(context), m_bounds(streams.m_bounds), m_vertexCount(streams.m_vertexCount)
+    {
+        createBuffers(streams.m_vertexCount, streams.m_indexCount);
+
+        auto* stagingRing = m_context->stagingRing();
+
+        // The copies run on the device, so the streams never pass through host memory again. Both vertex buffers start
+        // from the same positions.
+        std::array<std::pair<BufferType, Buffer const*>, BufferTypeCount> const copies = { { { BufferTypeIndex, streams.m_indices.get() },
+                                                                                             { BufferTypeBaseVertex, streams.m_positions.get() },
+                                                                                             { BufferTypeEditVertex, streams.m_positions.get() },
+                                                                                             { BufferTypeColour, streams.m_colours.get() } } };
+
+        for (auto const& [type, source] : copies)
         {
-            m_buffers[BufferTypeIndex]->upload(description->indices);
+            source->flush();
+            stagingRing->copy(m_buffers[type].get(), source, source->size(), 0);
         }
 
-        // Base vertices buffer.
-        auto const transferFlags = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc;
-        desc.flags               = vk::BufferUsageFlagBits::eVertexBuffer | transferFlags | vk::BufferUsageFlagBits::eStorageBuffer;
-        desc.size                = sizeof(glm::vec3) * numVertices;
-        if (m_buffers[BufferTypeBaseVertex] = std::make_unique<Buffer>(m_context, desc.size, desc.flags); m_buffers[BufferTypeBaseVertex])
-        {
-            m_buffers[BufferTypeBaseVertex]->upload(description->points);
+        m_buffers[BufferTypeIndex]->setCount(streams.m_indexCount);
+        m_buffers[BufferTypeBaseVertex]->setCount(streams.m_vertexCount);
+        m_buffers[BufferTypeEditVertex]->setCount(streams.m_vertexCount);
+        m_buffers[BufferTypeColour]->setCount(streams.m_vertexCount);
 
-            for (auto const& point : description->points)
-                m_bounds.extend(point);
+        stagingRing->retire(std::move(streams.m_positions));
+        stagingRing->retire(std::move(streams.m_indices));
+        stagingRing->retire(std::move(streams.m_colours));
+    }
 
-            // Edit vertices buffer.
-            if (m_buffers[BufferTypeEditVertex] = std::make_unique<Buffer>(m_context, desc.size, desc.flags); m_buffers[BufferTypeEditVertex])
-            {
-                m_buffers[BufferTypeEditVertex]->upload(description->points);
-            }
-        }
+    Mesh::Mesh(Context*                         context,
+               std::span<glm::vec3 const> const positions,
+               std::span<uint32_t const> const  indices,
+               std::span<uint32_t const> const  colours,
+               AABB const&                      bounds)
+        : m_context(context), m_bounds(bounds), m_vertexCount(static_cast<uint32_t>(positions.size()))
+    {
+        createBuffers(static_cast<uint32_t>(positions.size()), static_cast<uint32_t>(indices.size()));
 
-        // Colour buffer.
-        desc.size = sizeof(uint32_t) * numVertices;
-        if (m_buffers[BufferTypeColour] = std::make_unique<Buffer>(m_context, desc.size, desc.flags); m_buffers[BufferTypeColour])
+        m_buffers[BufferTypeIndex]->upload(indices);
+        m_buffers[BufferTypeBaseVertex]->upload(positions);
+        m_buffers[BufferTypeEditVertex]->upload(positions);
+        m_buffers[BufferTypeColour]->upload(colours);
+    }
+
+    Mesh::Mesh(Context* context, uint32_t const vertexCount, uint32_t const indexCount, AABB const& bounds)
+        : m_context(context), m_bounds(bounds), m_vertexCount(vertexCount)
+    {
+        createBuffers(vertexCount, indexCount);
+
+        m_buffers[BufferTypeIndex]->setCount(indexCount);
+        m_buffers[BufferTypeBaseVertex]->setCount(vertexCount);
+        m_buffers[BufferTypeEditVertex]->setCount(vertexCount);
+        m_buffers[BufferTypeColour]->setCount(vertexCount);
+    }
+
+    void Mesh::reserve(uint32_t const vertexCapacity, uint32_t const indexCapacity)
+    {
+        if (vertexCapacity <= this->vertexCapacity() && indexCapacity <= this->indexCapacity())
+            return;
+
+        // The contents in use are copied on the device, by the ring, before the previous buffers are released.
+        std::array<vk::DeviceSize, BufferTypeCount> usedSizes;
+        for (auto type = 0u; type < BufferTypeCount; ++type)
+            usedSizes[type] = usedSize(static_cast<BufferType>(type));
+
+        auto*      stagingRing = m_context->stagingRing();
+        auto const indexCount  = m_buffers[BufferTypeIndex]->count();
+        auto const vertices    = std::max(vertexCapacity, this->vertexCapacity());
+        auto const indices     = std::max(indexCapacity, this->indexCapacity());
+        auto       previous    = std::exchange(m_buffers, {});
+
+        createBuffers(vertices, indices);
+
+        for (auto type = 0u; type < BufferTypeCount; ++type)
         {
-            std::vector<uint32_t> colours(numVertices);
-            std::ranges::fill(colours, makeColour(0xFF, 0, 0, 0xFF));
+            if (usedSizes[type] > 0)
+                stagingRing->copy(m_buffers[type].get(), previous[type].get(), usedSizes[type], 0);
 
-            m_buffers[BufferTypeColour]->upload(colours);
+            stagingRing->retire(std::move(previous[type]));
         }
+
+        // The ring orders later uploads into the new buffers after the copies, and releases the previous buffers once they have
+        // completed, so nothing waits here.
+        setCounts(m_vertexCount, indexCount);
+    }
+
+    void Mesh::setCounts(uint32_t const vertexCount, uint32_t const indexCount)
+    {
+        m_vertexCount = vertexCount;
+
+        m_buffers[BufferTypeIndex]->setCount(indexCount);
+        m_buffers[BufferTypeBaseVertex]->setCount(vertexCount);
+        m_buffers[BufferTypeEditVertex]->setCount(vertexCount);
+        m_buffers[BufferTypeColour]->setCount(vertexCount);
+    }
+
+    auto Mesh::usedSize(BufferType const type) const -> vk::DeviceSize
+    {
+        return stride(type) * m_buffers[type]->count();
+    }
+
+    void Mesh::createBuffers(uint32_t const vertexCount, uint32_t const indexCount)
+    {
+        BufferDescription desc;
+
+        // The buffers live in device-local memory and are filled by the transfer queue; the edit and colour buffers are
+        // then written by the compute queue and everything is read by the graphics queue.
+        auto const            deviceFlags = vk::MemoryPropertyFlagBits::eDeviceLocal;
+        std::set<uint32_t>    queueSet    = { m_context->queueIndex(QueueIndex::eGraphics),
+                                              m_context->queueIndex(QueueIndex::eCompute),
+                                              m_context->queueIndex(QueueIndex::eTransfer) };
+        std::vector<uint32_t> sharedQueues;
+        if (queueSet.size() > 1)
+            sharedQueues.assign(queueSet.begin(), queueSet.end());
+
+        // Index buffer.
+        // Every stream is also writable through its device address, so that primitives can be generated on the device.
+        auto const transferFlags        = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc;
+        auto const shaderFlags          = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+        desc.flags                      = vk::BufferUsageFlagBits::eIndexBuffer | transferFlags | shaderFlags;
+        desc.size                       = sizeof(uint32_t) * indexCount;
+        m_buffers[BufferTypeIndex]      = std::make_unique<Buffer>(m_context, desc.size, desc.flags, deviceFlags, sharedQueues);
+
+        // Base and edit vertices buffers.
+        // The vertex streams are also read through their device addresses when the document is drawn indirectly.
+        desc.flags                      = vk::BufferUsageFlagBits::eVertexBuffer | transferFlags | shaderFlags;
+        desc.size                       = sizeof(glm::vec3) * vertexCount;
+        m_buffers[BufferTypeBaseVertex] = std::make_unique<Buffer>(m_context, desc.size, desc.flags, deviceFlags, sharedQueues);
+        m_buffers[BufferTypeEditVertex] = std::make_unique<Buffer>(m_context, desc.size, desc.flags, deviceFlags, sharedQueues);
+
+        // Colour buffer.
+        desc.size                   = sizeof(uint32_t) * vertexCount;
+        m_buffers[BufferTypeColour] = std::make_unique<Buffer>(m_context, desc.size, desc.flags, deviceFlags, sharedQueues);
     }
 
     void Mesh::render(vk::CommandBuffer const& commandBuffer)
     {
-        commandBuffer.bindVertexBuffers(0, { m_buffers[BufferTypeBaseVertex]->buffer() }, { 0 });
+        commandBuffer.bindVertexBuffers(0, { m_buffers[BufferTypeEditVertex]->buffer() }, { 0 });
         commandBuffer.bindVertexBuffers(1, { m_buffers[BufferTypeColour]->buffer() }, { 0 });
         commandBuffer.bindIndexBuffer(m_buffers[BufferTypeIndex]->buffer(), 0, vk::IndexType::eUint32);
         commandBuffer.drawIndexed(m_buffers[BufferTypeIndex]->count(), 1, 0, 0, 0);
@@ -7,20 +7,59 @@
 #include "rhi/buffer.hxx"
 #include "rhi/utilities.hxx"
 
-#include <unordered_map>
 #include <glm/glm-aabb.hpp>
 #include <glm/glm.hpp>
 
 namespace com::rhi
 {
-    /// Parameters to build a mesh.
-    struct MeshDescription final
+    /// The streams of a mesh that is being generated. The streams are sized up front and live in mapped staging memory, so
+    /// generators write straight into them, and they are copied to the device when a mesh is created from them.
+    class MeshStreams final
     {
-        glm::vec3                              centre;  ///< The centre of the mesh.
-        float                                  radius;  ///< The radius of the mesh.
-        std::vector<glm::vec3>                 points;  ///< The vertex points.
-        std::vector<uint32_t>                  indices; ///< Indices into the points.
-        std::unordered_map<uint64_t, uint32_t> edges;   ///< The edges.
+    public:
+        /// Constructor.
+        /// \param context The RHI context.
+        /// \param vertexCount The number of vertices.
+        /// \param indexCount The number of indices.
+        explicit MeshStreams(Context* context, uint32_t const vertexCount, uint32_t const indexCount);
+
+        /// Accessor.
+        /// \return The bounds of the positions, which the generator must set.
+        [[nodiscard]] auto bounds() -> AABB&
+        {
+            return m_bounds;
+        }
+
+        /// Accessor.
+        /// \return The colour of each vertex.
+        [[nodiscard]] auto colours() const
+        {
+            return std::span(static_cast<uint32_t*>(m_colours->data()), m_vertexCount);
+        }
+
+        /// Accessor.
+        /// \return Indices into the positions.
+        [[nodiscard]] auto indices() const
+        {
+            return std::span(static_cast<uint32_t*>(m_indices->data()), m_indexCount);
+        }
+
+        /// Accessor.
+        /// \return The vertex positions.
+        [[nodiscard]] auto positions() const
+        {
+            return std::span(static_cast<glm::vec3*>(m_positions->data()), m_vertexCount);
+        }
+
+    private:
+        friend class Mesh;
+
+        std::unique_ptr<Buffer> m_positions;
+        std::unique_ptr<Buffer> m_indices;
+        std::unique_ptr<Buffer> m_colours;
+        AABB                    m_bounds;
+        uint32_t                m_vertexCount = 0;
+        uint32_t                m_indexCount  = 0;
     };
 
     /// A drawable mesh object.
@@ -38,10 +77,31 @@ namespace com::rhi
         };
 
     public:
-        /// Constructor.
+        /// Constructor. The streams are copied to the device from their staging memory, which is released once the copies
+        /// have completed.
+        /// \param context The RHI context.
+        /// \param streams The generated streams.
+        explicit Mesh(Context* context, MeshStreams streams);
+
+        /// Constructor. The streams are uploaded as they are, e.g., straight from a mapped file.
         /// \param context The RHI context.
-        /// \param description The description of the mesh.
-        explicit Mesh(Context* context, MeshDescription const* description);
+        /// \param positions The vertex positions.
+        /// \param indices Indices into the positions, three per triangle.
+        /// \param colours The colour of each vertex.
+        /// \param bounds The bounds of the positions.
+        explicit Mesh(Context*                         context,
+                      std::span<glm::vec3 const> const positions,
+                      std::span<uint32_t const> const  indices,
+                      std::span<uint32_t const> const  colours,
+                      AABB const&                      bounds);
+
+        /// Constructor. The buffers are allocated but not filled, so that the device can write them, e.g., when a primitive
+        /// is generated by a compute shader.
+        /// \param context The RHI context.
+        /// \param vertexCount The number of vertices.
+        /// \param indexCount The number of indices.
+        /// \param bounds The bounds of the positions that will be written.
+        explicit Mesh(Context* context, uint32_t const vertexCount, uint32_t const indexCount, AABB const& bounds);
 
         /// Get the bounding box of this mesh.
         /// \return A valid bounding box.
@@ -50,18 +110,77 @@ namespace com::rhi
             return m_bounds;
         }
 
+        /// Accessor.
+        /// \param type The type of buffer.
+        /// \return A valid pointer.
+        [[nodiscard]] auto buffer(BufferType const type) const
+        {
+            return m_buffers[type].get();
+        }
+
+        /// Get the number of indices that the index buffer can hold.
+        /// \return A valid integer.
+        [[nodiscard]] auto indexCapacity() const
+        {
+            return static_cast<uint32_t>(m_buffers[BufferTypeIndex]->size() / sizeof(uint32_t));
+        }
+
         /// Render the mesh.
         /// \param commandBuffer The command buffer to write instructions to.
         void render(vk::CommandBuffer const& commandBuffer);
 
+        /// Grow the buffers so that they can hold at least the given numbers of vertices and indices, keeping their contents.
+        /// The contents are copied on the context's staging ring, which releases the previous buffers once its next submission
+        /// has completed, so that submission must wait for any work that is still using them. Anything that refers to the
+        /// buffers must be rebuilt.
+        /// \param vertexCapacity The number of vertices.
+        /// \param indexCapacity The number of indices.
+        void reserve(uint32_t const vertexCapacity, uint32_t const indexCapacity);
+
+        /// Set the numbers of vertices and indices in use, which must be within the capacity of the buffers.
+        /// \param vertexCount The number of vertices.
+        /// \param indexCount The number of indices.
+        void setCounts(uint32_t const vertexCount, uint32_t const indexCount);
+
+        /// Get the size of each element of a buffer.
+        /// \param type The type of buffer.
+        /// \return A valid size.
+        [[nodiscard]] static auto stride(BufferType const type) -> vk::DeviceSize
+        {
+            return type == BufferTypeIndex || type == BufferTypeColour ? sizeof(uint32_t) : sizeof(glm::vec3);
+        }
+
         /// Update a uniform.
         /// \param matrix The matrix to upload.
         void updateUniform(glm::mat4 const& matrix);
 
+        /// Get the number of bytes of a buffer that are in use, which may be fewer than it holds once it has been reserved.
+        /// \param type The type of buffer.
+        /// \return A valid size.
+        [[nodiscard]] auto usedSize(BufferType const type) const -> vk::DeviceSize;
+
+        /// Get the number of vertices that the vertex buffers can hold.
+        /// \return A valid integer.
+        [[nodiscard]] auto vertexCapacity() const
+        {
+            return static_cast<uint32_t>(m_buffers[BufferTypeEditVertex]->size() / sizeof(glm::vec3));
+        }
+
+        /// Get the number of vertices in the mesh.
+        /// \return A valid integer.
+        [[nodiscard]] auto vertexCount() const
+        {
+            return m_vertexCount;
+        }
+
+    private:
+        void createBuffers(uint32_t const vertexCount, uint32_t const indexCount);
+
     private:
         Context*                                             m_context = nullptr;
         std::array<std::unique_ptr<Buffer>, BufferTypeCount> m_buffers;
         AABB                                                 m_bounds;
+        uint32_t                                             m_vertexCount = 0;
     };
 
 } // namespace com::rhi
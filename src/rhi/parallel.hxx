@@ -0,0 +1,47 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace com::rhi
+{
+    /// Call a function for every index in a range, split into many more chunks than there are worker threads. The threads pull
+    /// chunks from a shared counter until none remain, so a thread that lands on cheap indices takes more chunks rather than
+    /// idling behind one that lands on expensive ones. Each index is visited exactly once, so the results are independent of
+    /// the number of threads.
+    /// \param count The number of indices.
+    /// \param function The function to call with the index.
+    template <typename Function>
+    void parallelFor(uint32_t const count, Function const& function)
+    {
+        constexpr auto chunksPerThread = 8u;
+
+        auto const threadCount = std::clamp(std::thread::hardware_concurrency(), 1u, std::max(count, 1u));
+        auto const chunkCount  = std::min(count, threadCount * chunksPerThread);
+        auto const chunk       = chunkCount == 0 ? 0 : (count + chunkCount - 1) / chunkCount;
+
+        std::atomic_uint32_t next = 0;
+
+        auto const work = [&]
+        {
+            for (auto first = next.fetch_add(chunk, std::memory_order_relaxed); first < count; first = next.fetch_add(chunk, std::memory_order_relaxed))
+            {
+                for (auto i = first, end = std::min(count, first + chunk); i < end; ++i)
+                    function(i);
+            }
+        };
+
+        std::vector<std::jthread> threads;
+        for (auto thread = 1u; thread < threadCount; ++thread)
+            threads.emplace_back(work);
+
+        work();
+    }
+} // namespace com::rhi
@@ -12,8 +12,12 @@ namespace com::rhi
     {
         m_commandPool = std::make_unique<CommandPool>(context->device(), queueIndex);
 
-        m_presentCompleteSemaphore = context->device()->createSemaphore();
-        m_renderCompleteSemaphore  = context->device()->createSemaphore();
+        // A headless frame neither acquires nor presents an image.
+        if (!context->isHeadless())
+        {
+            m_presentCompleteSemaphore = context->device()->createSemaphore();
+            m_renderCompleteSemaphore  = context->device()->createSemaphore();
+        }
 
         m_fence = m_device.createFence(vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled));
 
@@ -22,19 +26,10 @@ namespace com::rhi
 
         bufferDesc.size       = sizeof(CameraUniform);
         m_cameraUniformBuffer = std::make_unique<Buffer>(context, bufferDesc.size, bufferDesc.flags);
-
-        bufferDesc.size      = sizeof(glm::mat4x4);
-        m_modelUniformBuffer = std::make_unique<Buffer>(context, bufferDesc.size, bufferDesc.flags);
-
-        bufferDesc.size  = 8 * sizeof(float);
-        bufferDesc.flags = vk::BufferUsageFlagBits::eTransferDst;
-        m_mouseBuffer    = std::make_unique<Buffer>(context, bufferDesc.size, bufferDesc.flags);
     }
 
     FrameData::~FrameData()
     {
-        m_mouseBuffer.reset();
-        m_modelUniformBuffer.reset();
         m_cameraUniformBuffer.reset();
 
         m_device.destroyFence(m_fence);
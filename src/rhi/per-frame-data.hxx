@@ -57,28 +57,14 @@ namespace com::rhi
         }
 
         /// Accessor.
-        /// \return A valid Vulkan object.
-        [[nodiscard]] auto modelUniformBuffer() const
-        {
-            return m_modelUniformBuffer.get();
-        }
-
-        /// Accessor.
-        /// \return A valid Vulkan object.
-        [[nodiscard]] auto mouseBuffer() const
-        {
-            return m_mouseBuffer.get();
-        }
-
-        /// Accessor.
-        /// \return A valid Vulkan object.
+        /// \return A Vulkan object, which is null for a headless context.
         [[nodiscard]] auto presentCompleteSemaphore() const -> vk::Semaphore const&
         {
             return m_presentCompleteSemaphore;
         }
 
         /// Accessor.
-        /// \return A valid Vulkan object.
+        /// \return A Vulkan object, which is null for a headless context.
         [[nodiscard]] auto renderCompleteSemaphore() const -> vk::Semaphore const&
         {
             return m_renderCompleteSemaphore;
@@ -99,7 +85,5 @@ namespace com::rhi
         vk::Semaphore                m_renderCompleteSemaphore;
         uint32_t                     m_imageIndex = 0;
         std::unique_ptr<Buffer>      m_cameraUniformBuffer;
-        std::unique_ptr<Buffer>      m_modelUniformBuffer;
-        std::unique_ptr<Buffer>      m_mouseBuffer;
     };
 } // namespace com::rhi
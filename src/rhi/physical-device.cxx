@@ -5,6 +5,7 @@
 #include "rhi/physical-device.hxx"
 #include "rhi/context.hxx"
 
+#include <cstddef>
 #include <map>
 
 namespace com::rhi
@@ -16,6 +17,20 @@ namespace com::rhi
         m_memory      = m_device.getMemoryProperties();
         m_properties  = m_device.getProperties();
         m_queueFamily = m_device.getQueueFamilyProperties();
+
+        // The Vulkan 1.2 features can only be queried from a device that implements it.
+        if (m_properties.apiVersion >= VK_API_VERSION_1_2)
+        {
+            auto const chain = m_device.getFeatures2<vk::PhysicalDeviceFeatures2,
+                                                     vk::PhysicalDeviceVulkan12Features,
+                                                     vk::PhysicalDeviceSynchronization2Features,
+                                                     vk::PhysicalDeviceDynamicRenderingFeatures>();
+
+            m_features12          = chain.get<vk::PhysicalDeviceVulkan12Features>();
+            m_features12.pNext    = nullptr;
+            m_hasSynchronization2 = chain.get<vk::PhysicalDeviceSynchronization2Features>().synchronization2 == VK_TRUE;
+            m_hasDynamicRendering = chain.get<vk::PhysicalDeviceDynamicRenderingFeatures>().dynamicRendering == VK_TRUE;
+        }
     }
 
     auto PhysicalDevice::findQueueIndex(vk::QueueFlagBits bit, vk::SurfaceKHR const* surface) -> uint32_t
@@ -60,6 +75,9 @@ namespace com::rhi
             if (!device->supportsFeatures(description.deviceFeatures)) // Check if all required features are supported.
                 continue;
 
+            if (!device->supportsFeatures(description.deviceFeatures12)) // Check if all required Vulkan 1.2 features are supported.
+                continue;
+
             if (!device->supportsExtensions(description.deviceExtensions)) // Check if all required extensions are supported.
                 continue;
 
@@ -89,11 +107,15 @@ namespace com::rhi
                 if (!(properties.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)))
                     continue;
 
-                if (!device->supportsPresentation(queueFamilyIndex, description.windowHandle))
-                    continue;
+                // A headless context has no surface, so any device will do, including software rasterisers such as lavapipe.
+                if (surface)
+                {
+                    if (!device->supportsPresentation(queueFamilyIndex, description.windowHandle))
+                        continue;
 
-                if (!device->supportsSurface(queueFamilyIndex, surface))
-                    continue;
+                    if (!device->supportsSurface(queueFamilyIndex, surface))
+                        continue;
+                }
 
                 rankedDevices.insert(std::make_pair(rank, std::move(device)));
                 break;
@@ -134,6 +156,29 @@ namespace com::rhi
         return true;
     }
 
+    auto PhysicalDevice::supportsFeatures(vk::PhysicalDeviceVulkan12Features const& features) const -> bool
+    {
+        if (!m_hasDynamicRendering || !m_hasSynchronization2)
+            return false;
+
+        // The features follow the structure's type and chain.
+        constexpr auto first = offsetof(VkPhysicalDeviceVulkan12Features, samplerMirrorClampToEdge);
+        constexpr auto count = (sizeof(VkPhysicalDeviceVulkan12Features) - first) / sizeof(VkBool32);
+
+        auto const* required  = reinterpret_cast<VkBool32 const*>(reinterpret_cast<uint8_t const*>(&features) + first);
+        auto const* supported = reinterpret_cast<VkBool32 const*>(reinterpret_cast<uint8_t const*>(&m_features12) + first);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (required[i] == VK_TRUE && supported[i] == VK_FALSE)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
     auto PhysicalDevice::supportsPresentation(uint32_t index, [[maybe_unused]] void const* windowHandle) const -> bool
     {
 #if defined(VK_USE_PLATFORM_WIN32_KHR)
@@ -56,6 +56,12 @@ namespace com::rhi
         /// \return true if this device supports a set of features; false othewise.
         [[nodiscard]] auto supportsFeatures(vk::PhysicalDeviceFeatures const& features) const -> bool;
 
+        /// Determines if this device supports a set of Vulkan 1.2 features, and the dynamic rendering and synchronization2
+        /// features that every device is created with.
+        /// \param features The features to test.
+        /// \return true if this device supports a set of features; false othewise.
+        [[nodiscard]] auto supportsFeatures(vk::PhysicalDeviceVulkan12Features const& features) const -> bool;
+
         /// Determines if this device supports presentation.
         /// \param index The queue family index to test.
         /// \param windowHandle The window handle.
@@ -88,6 +94,9 @@ namespace com::rhi
 
         std::vector<vk::ExtensionProperties>   m_extensions;
         vk::PhysicalDeviceFeatures             m_features;
+        vk::PhysicalDeviceVulkan12Features     m_features12;
+        bool                                   m_hasDynamicRendering = false;
+        bool                                   m_hasSynchronization2 = false;
         vk::PhysicalDeviceMemoryProperties     m_memory;
         vk::PhysicalDeviceProperties           m_properties;
         std::vector<vk::QueueFamilyProperties> m_queueFamily;
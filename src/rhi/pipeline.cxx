@@ -6,6 +6,17 @@
 
 namespace com::rhi
 {
+    [[nodiscard]] auto createComputePipeline(Context const* context, vk::ShaderModule const& computeShader, vk::PipelineLayout const& pipelineLayout)
+    -> vk::Pipeline
+    {
+        auto const stage = vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eCompute, computeShader, "main");
+        auto const info  = vk::ComputePipelineCreateInfo({}, stage, pipelineLayout);
+
+        auto const result = context->device()->logicalDevice().createComputePipeline(context->pipelineCache(), info);
+
+        return result.value;
+    }
+
     [[nodiscard]] auto createGraphicsPipeline(Context const*                         context,
                                               VertexAttributes const&                vertexAttributes,
                                               vk::ShaderModule const&                vertexShader,
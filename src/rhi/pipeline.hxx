@@ -11,6 +11,14 @@ namespace com::rhi
     /// Vertex attributes.
     using VertexAttributes = std::vector<std::pair<vk::Format, size_t>>;
 
+    /// Create a compute pipeline.
+    /// \param context The RHI context.
+    /// \param computeShader The compute shader.
+    /// \param pipelineLayout The pipeline layout.
+    /// \return A valid pipeline on success; nothing otherwise.
+    [[nodiscard]] auto createComputePipeline(Context const* context, vk::ShaderModule const& computeShader, vk::PipelineLayout const& pipelineLayout)
+    -> vk::Pipeline;
+
     /// Create a graphics pipeline.
     /// \param context The RHI context.
     /// \param vertexAttributes The vertex attributes.
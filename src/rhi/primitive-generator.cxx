@@ -0,0 +1,142 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "rhi/primitive-generator.hxx"
+#include "rhi/context.hxx"
+#include "rhi/pipeline.hxx"
+
+#include <algorithm>
+#include <cmath>
+
+namespace com::rhi
+{
+    /// The colour of a generated primitive's vertices, which matches makeSphere.
+    static uint32_t const s_primitiveColour = makeColour(0xFF, 0, 0, 0xFF);
+
+    /// The shape of a primitive's grid.
+    struct PrimitiveGrid final
+    {
+        uint32_t frequency   = 0; ///< The number of segments along each edge of a face.
+        uint32_t faceCount   = 0; ///< The number of faces.
+        uint32_t vertexCount = 0; ///< The number of distinct vertices.
+        uint32_t indexCount  = 0; ///< The number of indices.
+    };
+
+    /// Size a primitive's grid so that it has at least a given number of triangles.
+    /// \param kind The kind of primitive.
+    /// \param minPolygons The minimum amount of polygons.
+    /// \return The grid.
+    [[nodiscard]] static auto makeGrid(PrimitiveKind const kind, uint32_t const minPolygons)
+    {
+        auto const frequencyFor = [=](uint32_t const trianglesPerCell)
+        {
+            return std::max(1u, static_cast<uint32_t>(std::ceil(std::sqrt(minPolygons / static_cast<double>(trianglesPerCell)))));
+        };
+
+        PrimitiveGrid grid;
+
+        switch (kind)
+        {
+            case PrimitiveKind::eSphere:
+                // 8 triangular faces of n^2 triangles, which share their corners and edges; this matches makeSphere.
+                grid.frequency   = frequencyFor(8);
+                grid.faceCount   = 8;
+                grid.vertexCount = 4 * grid.frequency * grid.frequency + 2;
+                grid.indexCount  = 3 * 8 * grid.frequency * grid.frequency;
+                break;
+
+            case PrimitiveKind::eCubeSphere:
+                // 6 square faces of n^2 quads, which share their corners and edges.
+                grid.frequency   = frequencyFor(12);
+                grid.faceCount   = 6;
+                grid.vertexCount = 6 * grid.frequency * grid.frequency + 2;
+                grid.indexCount  = 3 * 12 * grid.frequency * grid.frequency;
+                break;
+
+            case PrimitiveKind::ePlane:
+                grid.frequency   = frequencyFor(2);
+                grid.faceCount   = 1;
+                grid.vertexCount = (grid.frequency + 1) * (grid.frequency + 1);
+                grid.indexCount  = 3 * 2 * grid.frequency * grid.frequency;
+                break;
+        }
+
+        return grid;
+    }
+
+    PrimitiveGenerator::PrimitiveGenerator(Context* context) : m_context(context)
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        m_commandPool = std::make_unique<CommandPool>(m_context->device(), m_context->queueIndex(QueueIndex::eCompute));
+        m_fence       = device.createFence(vk::FenceCreateInfo());
+
+        // The streams are addressed directly, so the pipeline has no descriptor sets.
+        auto const pushConstants = vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(PrimitiveUniform));
+        m_pipelineLayout         = device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, {}, pushConstants));
+
+        m_shader   = createShader(device, "primitive.comp");
+        m_pipeline = createComputePipeline(m_context, m_shader, m_pipelineLayout);
+    }
+
+    PrimitiveGenerator::~PrimitiveGenerator()
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        device.destroyPipeline(m_pipeline);
+        device.destroyShaderModule(m_shader);
+        device.destroyPipelineLayout(m_pipelineLayout);
+        device.destroyFence(m_fence);
+    }
+
+    auto PrimitiveGenerator::generate(PrimitiveKind const kind, glm::vec3 const& centre, float const radius, uint32_t const minPolygons)
+    -> std::unique_ptr<Mesh>
+    {
+        auto const& device = m_context->device()->logicalDevice();
+        auto const  grid   = makeGrid(kind, minPolygons);
+
+        // The bounds are known up front; a plane is flat, and the spheres touch their radius at the octahedron's corners
+        // or, for odd cube-sphere frequencies, fall just inside it.
+        auto const extent = kind == PrimitiveKind::ePlane ? glm::vec3(radius, 0.0f, radius) : glm::vec3(radius);
+        auto       mesh   = std::make_unique<Mesh>(m_context, grid.vertexCount, grid.indexCount, AABB(centre - extent, centre + extent));
+
+        PrimitiveUniform constants = {};
+        constants.centre           = centre;
+        constants.radius           = radius;
+        constants.kind             = static_cast<uint32_t>(kind);
+        constants.frequency        = grid.frequency;
+        constants.colour           = s_primitiveColour;
+        constants.base_positions   = mesh->buffer(Mesh::BufferTypeBaseVertex)->deviceAddress();
+        constants.edit_positions   = mesh->buffer(Mesh::BufferTypeEditVertex)->deviceAddress();
+        constants.colours          = mesh->buffer(Mesh::BufferTypeColour)->deviceAddress();
+        constants.indices          = mesh->buffer(Mesh::BufferTypeIndex)->deviceAddress();
+
+        m_commandPool->reset();
+
+        auto const& commandBuffer = m_commandPool->commandBuffer();
+        commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+        // One invocation per grid point of each face, with the faces stacked in y.
+        auto const points = grid.frequency + 1;
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+        commandBuffer.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PrimitiveUniform), &constants);
+        commandBuffer.dispatch((points + PRIMITIVE_GROUP_SIZE - 1) / PRIMITIVE_GROUP_SIZE,
+                               (grid.faceCount * points + PRIMITIVE_GROUP_SIZE - 1) / PRIMITIVE_GROUP_SIZE,
+                               1);
+
+        commandBuffer.end();
+
+        // The mesh's buffers are shared by every queue, so waiting here is all that is needed before it is drawn or sculpted.
+        m_context->queue(QueueIndex::eCompute)->submit(commandBuffer, vk::Semaphore(), m_fence);
+        m_context->waitForFences(m_fence);
+        device.resetFences(m_fence);
+
+        return mesh;
+    }
+
+    auto generateSphere(Context* context, glm::vec3 const& centre, float const radius, uint32_t const minPolygons) -> std::unique_ptr<Mesh>
+    {
+        return context->primitiveGenerator()->generate(PrimitiveKind::eSphere, centre, radius, minPolygons);
+    }
+} // namespace com::rhi
@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include "rhi/command-pool.hxx"
+#include "rhi/mesh.hxx"
+#include "rhi/shaders/uniforms.hxx"
+#include "rhi/shaders/primitive.hxx"
+
+namespace com::rhi
+{
+    /// Specifies the kind of primitive to generate.
+    enum class PrimitiveKind
+    {
+        eSphere     = PRIMITIVE_KIND_SPHERE,      ///< A sphere subdivided from an octahedron, as made by makeSphere.
+        eCubeSphere = PRIMITIVE_KIND_CUBE_SPHERE, ///< A sphere subdivided from a cube, whose faces are grids of quads.
+        ePlane      = PRIMITIVE_KIND_PLANE        ///< A square plane facing up the y axis.
+    };
+
+    /// Generates primitives on the device with a compute shader. The streams are written straight into the mesh's
+    /// device-local buffers, so nothing is built on, or uploaded from, the host; this is what makes very high polygon
+    /// counts affordable.
+    class PrimitiveGenerator final
+    {
+    public:
+        /// Constructor.
+        /// \param context The RHI context.
+        explicit PrimitiveGenerator(Context* context);
+
+        /// Destructor.
+        ~PrimitiveGenerator();
+
+        /// Generate a primitive. This waits for the device to finish, so the mesh can be used straight away.
+        /// \param kind The kind of primitive.
+        /// \param centre The centre of the primitive.
+        /// \param radius The radius of the primitive, or half the width of a plane.
+        /// \param minPolygons The minimum amount of polygons.
+        /// \return A new mesh.
+        [[nodiscard]] auto generate(PrimitiveKind const kind, glm::vec3 const& centre, float const radius, uint32_t const minPolygons)
+        -> std::unique_ptr<Mesh>;
+
+    private:
+        Context*                     m_context = nullptr;
+        std::unique_ptr<CommandPool> m_commandPool;
+        vk::Fence                    m_fence;
+        vk::PipelineLayout           m_pipelineLayout;
+        vk::ShaderModule             m_shader;
+        vk::Pipeline                 m_pipeline;
+    };
+
+    /// Make a sphere primitive on the device. The result has the same triangles as makeSphere, in the same order, and so the
+    /// same count of 8n^2 triangles; its vertices keep the grid's numbering, as they never reach the host to be renumbered.
+    /// \param context The RHI context.
+    /// \param centre The centre of the sphere.
+    /// \param radius The radius of the sphere.
+    /// \param minPolygons The minimum amount of polygons
+    /// \return A new mesh.
+    [[nodiscard]] auto generateSphere(Context* context, glm::vec3 const& centre, float const radius, uint32_t const minPolygons) -> std::unique_ptr<Mesh>;
+} // namespace com::rhi
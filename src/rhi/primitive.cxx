@@ -3,126 +3,289 @@
 //
 
 #include "rhi/primitive.hxx"
+#include "rhi/mesh-optimiser.hxx"
+#include "rhi/parallel.hxx"
+#include "rhi/shaders/uniforms.hxx"
+#include "rhi/shaders/primitive.hxx"
 
+#include <algorithm>
 #include <numbers>
 
 namespace com::rhi
 {
+    /// The colour of a primitive's vertices.
+    static uint32_t const s_primitiveColour = makeColour(0xFF, 0, 0, 0xFF);
+
     auto makeCursor(Context* context, uint32_t const cursorVertexCount) -> std::unique_ptr<Mesh>
     {
-        auto           meshDescription   = std::make_shared<MeshDescription>();
         uint32_t const cursorCircleCount = cursorVertexCount - 2;
 
+        MeshStreams streams(context, cursorVertexCount, 2 * cursorCircleCount + 2);
+        auto const  points  = streams.positions();
+        auto const  indices = streams.indices();
+
         for (auto i = 0u; i < cursorCircleCount; ++i)
         {
             auto const t      = static_cast<float>(i) / static_cast<float>(cursorCircleCount);
             auto const amount = static_cast<float>(std::numbers::pi) * 2 * t;
 
-            meshDescription->points.emplace_back(std::sin(amount));
-            meshDescription->points.emplace_back(0.0f);
-            meshDescription->points.emplace_back(std::cos(amount));
+            points[i] = glm::vec3(std::sin(amount), 0.0f, std::cos(amount));
         }
 
-        meshDescription->points.emplace_back(0.0f);
-        meshDescription->points.emplace_back(0.0f);
-        meshDescription->points.emplace_back(0.0f);
-
-        meshDescription->points.emplace_back(0.0f);
-        meshDescription->points.emplace_back(0.5f);
-        meshDescription->points.emplace_back(0.0f);
+        points[cursorCircleCount]     = glm::vec3(0.0f, 0.0f, 0.0f);
+        points[cursorCircleCount + 1] = glm::vec3(0.0f, 0.5f, 0.0f);
 
-        int32_t last = cursorCircleCount - 1;
+        uint32_t last = cursorCircleCount - 1;
         for (uint32_t i = 0; i < cursorCircleCount; ++i)
         {
-            meshDescription->indices.emplace_back(last);
-            meshDescription->indices.emplace_back(i);
+            indices[2 * i]     = last;
+            indices[2 * i + 1] = i;
 
             last = i;
         }
 
-        meshDescription->indices.emplace_back(cursorVertexCount - 2);
-        meshDescription->indices.emplace_back(cursorVertexCount - 1);
+        indices[2 * cursorCircleCount]     = cursorVertexCount - 2;
+        indices[2 * cursorCircleCount + 1] = cursorVertexCount - 1;
 
-        return std::make_unique<Mesh>(context, meshDescription.get());
+        std::ranges::fill(streams.colours(), s_primitiveColour);
+        for (auto const& point : points)
+            streams.bounds().extend(point);
+
+        return std::make_unique<Mesh>(context, std::move(streams));
     }
 
-    [[nodiscard]] static auto findOrAddIndex(uint32_t const i0, uint32_t const i1, MeshDescription* meshDescription)
+    /// The directions of the octahedron's corners, from which the sphere is subdivided.
+    static constexpr std::array<glm::vec3, 6> s_octahedronCorners = { glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f),
+                                                                       glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+                                                                       glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+
+    /// The octahedron's faces, as corner indices.
+    static constexpr std::array<std::array<uint32_t, 3>, 8> s_octahedronFaces = { { { 0, 5, 3 },
+                                                                                     { 5, 1, 3 },
+                                                                                     { 1, 4, 3 },
+                                                                                     { 4, 0, 3 },
+                                                                                     { 5, 0, 2 },
+                                                                                     { 1, 5, 2 },
+                                                                                     { 4, 1, 2 },
+                                                                                     { 0, 4, 2 } } };
+
+    /// The octahedron's edges, as corner indices with the lower index first.
+    static constexpr std::array<std::array<uint32_t, 2>, 12> s_octahedronEdges = { { { 0, 2 },
+                                                                                     { 0, 3 },
+                                                                                     { 0, 4 },
+                                                                                     { 0, 5 },
+                                                                                     { 1, 2 },
+                                                                                     { 1, 3 },
+                                                                                     { 1, 4 },
+                                                                                     { 1, 5 },
+                                                                                     { 2, 4 },
+                                                                                     { 2, 5 },
+                                                                                     { 3, 4 },
+                                                                                     { 3, 5 } } };
+
+    /// Addresses the vertices of an octahedron whose faces are each divided into a triangular grid of a given frequency. Every
+    /// vertex has a closed-form index, so that faces share their edge vertices without any lookup:
+    ///
+    /// - The 6 corners come first.
+    /// - Then each of the 12 edges' interior vertices, ordered from the edge's lower corner.
+    /// - Then each of the 8 faces' interior vertices, row by row.
+    class SphereGrid final
     {
-        auto const edge = (static_cast<uint64_t>(std::min(i0, i1)) << 32) | static_cast<uint64_t>(std::max(i0, i1));
+    public:
+        /// Constructor.
+        /// \param frequency The number of segments along each edge of a face.
+        explicit SphereGrid(uint32_t const frequency)
+            : m_frequency(frequency), m_edgeBase(6), m_faceBase(m_edgeBase + 12 * (frequency - 1)),
+              m_faceInteriorCount((frequency - 1) * (frequency - 2) / 2)
+        {
+        }
 
-        if (auto i = meshDescription->edges.find(edge); i != meshDescription->edges.end())
+        /// Get the index of a vertex of a face.
+        /// \param face The face.
+        /// \param i The position along the face's first edge, i.e., towards its second corner.
+        /// \param j The position along the face's last edge, i.e., towards its third corner.
+        /// \return A valid index.
+        [[nodiscard]] auto index(uint32_t const face, uint32_t const i, uint32_t const j) const -> uint32_t
         {
-            auto const index = i->second;
-            meshDescription->edges.erase(i);
-            return index;
+            auto const& corners = s_octahedronFaces[face];
+            auto const  n       = m_frequency;
+
+            if (i == 0 && j == 0)
+                return corners[0];
+            if (i == n)
+                return corners[1];
+            if (j == n)
+                return corners[2];
+            if (j == 0)
+                return edgeIndex(corners[0], corners[1], i);
+            if (i == 0)
+                return edgeIndex(corners[0], corners[2], j);
+            if (i + j == n)
+                return edgeIndex(corners[1], corners[2], j);
+
+            return m_faceBase + face * m_faceInteriorCount + interiorIndex(i, j);
         }
-        else
+
+        /// Get the index of a face's interior vertex, relative to the face's first interior vertex.
+        /// \param i The position along the face's first edge.
+        /// \param j The position along the face's last edge.
+        /// \return A valid index.
+        [[nodiscard]] auto interiorIndex(uint32_t const i, uint32_t const j) const -> uint32_t
         {
-            auto const point0   = meshDescription->points[i0];
-            auto const point1   = meshDescription->points[i1];
-            auto const midPoint = 0.5f * (point0 + point1);
-            auto const normal   = midPoint - meshDescription->centre;
-            auto const newPoint = meshDescription->centre + meshDescription->radius * glm::normalize(normal);
+            // Row j holds n - 1 - j interior vertices.
+            return (j - 1) * (m_frequency - 1) - (j - 1) * j / 2 + (i - 1);
+        }
 
-            auto const index = static_cast<uint32_t>(meshDescription->points.size());
+        /// Accessor.
+        /// \return The index of the first edge vertex.
+        [[nodiscard]] auto edgeBase() const
+        {
+            return m_edgeBase;
+        }
 
-            meshDescription->points.emplace_back(newPoint);
-            meshDescription->edges.insert({ edge, index });
-            return index;
+        /// Accessor.
+        /// \return The index of the first face-interior vertex.
+        [[nodiscard]] auto faceBase() const
+        {
+            return m_faceBase;
         }
-    }
 
-    static void subdivide(uint32_t const   i0,
-                          uint32_t const   i1,
-                          uint32_t const   i2,
-                          uint32_t const   targetPolygonCount,
-                          uint32_t const   currentPolygonCount,
-                          MeshDescription* meshDescription)
-    {
-        if (targetPolygonCount <= currentPolygonCount)
+        /// Accessor.
+        /// \return The number of interior vertices in each face.
+        [[nodiscard]] auto faceInteriorCount() const
         {
-            meshDescription->indices.emplace_back(i0);
-            meshDescription->indices.emplace_back(i1);
-            meshDescription->indices.emplace_back(i2);
+            return m_faceInteriorCount;
         }
-        else
+
+        /// Get the total number of vertices.
+        /// \return A valid integer.
+        [[nodiscard]] auto vertexCount() const
         {
-            auto const i01 = findOrAddIndex(i0, i1, meshDescription);
-            auto const i12 = findOrAddIndex(i1, i2, meshDescription);
-            auto const i20 = findOrAddIndex(i2, i0, meshDescription);
-
-            subdivide(i0, i01, i20, targetPolygonCount, 4 * currentPolygonCount, meshDescription);
-            subdivide(i01, i1, i12, targetPolygonCount, 4 * currentPolygonCount, meshDescription);
-            subdivide(i20, i12, i2, targetPolygonCount, 4 * currentPolygonCount, meshDescription);
-            subdivide(i01, i12, i20, targetPolygonCount, 4 * currentPolygonCount, meshDescription);
+            return m_faceBase + 8 * m_faceInteriorCount;
+        }
+
+    private:
+        [[nodiscard]] auto edgeIndex(uint32_t const from, uint32_t const to, uint32_t const position) const -> uint32_t
+        {
+            auto const lo   = std::min(from, to);
+            auto const hi   = std::max(from, to);
+            auto const edge = static_cast<uint32_t>(std::ranges::find(s_octahedronEdges, std::array<uint32_t, 2>{ lo, hi }) - s_octahedronEdges.begin());
+            auto const step = from == lo ? position : m_frequency - position;
+
+            return m_edgeBase + edge * (m_frequency - 1) + (step - 1);
         }
+
+    private:
+        uint32_t m_frequency;
+        uint32_t m_edgeBase;
+        uint32_t m_faceBase;
+        uint32_t m_faceInteriorCount;
+    };
+
+    /// Get the first triangle of a row of a band of a face, relative to the face's first triangle. The face's triangles are
+    /// emitted in bands of PRIMITIVE_BAND_WIDTH columns, each band row by row, so that consecutive rows share vertices that
+    /// are still in the cache. The bands left of column s hold 2ns - s^2 triangles.
+    /// \param n The frequency of the grid.
+    /// \param s The first column of the band.
+    /// \param j The row.
+    /// \return A valid index.
+    [[nodiscard]] static auto bandTriangle(uint32_t const n, uint32_t const s, uint32_t const j) -> uint32_t
+    {
+        auto const w = static_cast<uint32_t>(PRIMITIVE_BAND_WIDTH);
+        auto const m = n - s;
+        auto const k = m - j;
+
+        // Rows of k > w columns hold 2w triangles, and the narrower rows at the top 2k - 1.
+        auto const tail = std::min(w, m);
+        auto const row  = k > w ? 2 * w * j : 2 * w * (m - tail) + tail * tail - k * k;
+
+        return 2 * n * s - s * s + row;
     }
 
     auto makeSphere(Context* context, glm::vec3 const& centre, float const radius, uint32_t const minPolygons) -> std::unique_ptr<Mesh>
     {
-        auto meshDescription = std::make_shared<MeshDescription>(centre, radius);
-
-        meshDescription->points.reserve(minPolygons >> 1);
-        meshDescription->indices.reserve(3 * minPolygons);
-        meshDescription->edges.reserve(3 * (minPolygons >> 1));
-
-        meshDescription->points.emplace_back(centre - glm::vec3(radius, 0.0f, 0.0f));
-        meshDescription->points.emplace_back(centre + glm::vec3(radius, 0.0f, 0.0f));
-        meshDescription->points.emplace_back(centre - glm::vec3(0.0f, radius, 0.0f));
-        meshDescription->points.emplace_back(centre + glm::vec3(0.0f, radius, 0.0f));
-        meshDescription->points.emplace_back(centre - glm::vec3(0.0f, 0.0f, radius));
-        meshDescription->points.emplace_back(centre + glm::vec3(0.0f, 0.0f, radius));
-
-        auto const numPolysPerFace = minPolygons / 8;
-        subdivide(0, 5, 3, numPolysPerFace, 1, meshDescription.get());
-        subdivide(5, 1, 3, numPolysPerFace, 1, meshDescription.get());
-        subdivide(1, 4, 3, numPolysPerFace, 1, meshDescription.get());
-        subdivide(4, 0, 3, numPolysPerFace, 1, meshDescription.get());
-        subdivide(5, 0, 2, numPolysPerFace, 1, meshDescription.get());
-        subdivide(1, 5, 2, numPolysPerFace, 1, meshDescription.get());
-        subdivide(4, 1, 2, numPolysPerFace, 1, meshDescription.get());
-        subdivide(0, 4, 2, numPolysPerFace, 1, meshDescription.get());
-
-        return std::make_unique<Mesh>(context, meshDescription.get());
+        // Each of the 8 faces is divided into frequency^2 triangles, so any frequency may be used, not just powers of two.
+        // A subdivided octahedron only has counts of 8 * frequency^2, so the count is the smallest of those that is at least
+        // minPolygons, rather than exactly minPolygons as a closed mesh of any even count could be.
+        auto const frequency = std::max(1u, static_cast<uint32_t>(std::ceil(std::sqrt(minPolygons / 8.0))));
+        auto const grid      = SphereGrid(frequency);
+        auto const n         = frequency;
+
+        // The streams are written in place, in staging memory sized from the grid, so nothing is built up on the heap.
+        MeshStreams streams(context, grid.vertexCount(), 3 * 8 * n * n);
+        auto* const points  = streams.positions().data();
+        auto* const colours = streams.colours().data();
+        auto* const indices = streams.indices().data();
+
+        auto const write = [=](uint32_t const index, glm::vec3 const& direction, AABB& bounds)
+        {
+            points[index]  = centre + radius * glm::normalize(direction);
+            colours[index] = s_primitiveColour;
+            bounds.extend(points[index]);
+        };
+
+        // Every vertex is written once, by whichever pass owns it, so shared vertices are bit-identical across faces.
+        auto& bounds = streams.bounds();
+
+        for (uint32_t corner = 0; corner < s_octahedronCorners.size(); ++corner)
+            write(corner, s_octahedronCorners[corner], bounds);
+
+        for (uint32_t edge = 0; edge < s_octahedronEdges.size(); ++edge)
+        {
+            auto const& from = s_octahedronCorners[s_octahedronEdges[edge][0]];
+            auto const& to   = s_octahedronCorners[s_octahedronEdges[edge][1]];
+
+            for (auto step = 1u; step < n; ++step)
+                write(grid.edgeBase() + edge * (n - 1) + (step - 1), glm::mix(from, to, static_cast<float>(step) / n), bounds);
+        }
+
+        // The work is split into rows of faces, each of which writes its interior vertices and its triangles in every band.
+        // Each row keeps its own bounds, which are merged afterwards; min and max are exact, so the order does not matter.
+        std::vector<AABB> rowBounds(8 * n);
+
+        parallelFor(8 * n,
+                    [&](uint32_t const row)
+                    {
+                        auto const  face    = row / n;
+                        auto const  j       = row % n;
+                        auto const& corners = s_octahedronFaces[face];
+                        auto const& a       = s_octahedronCorners[corners[0]];
+                        auto const& b       = s_octahedronCorners[corners[1]];
+                        auto const& c       = s_octahedronCorners[corners[2]];
+
+                        for (auto i = 1u; j > 0 && i + j < n; ++i)
+                        {
+                            auto const direction = (static_cast<float>(n - i - j) * a + static_cast<float>(i) * b + static_cast<float>(j) * c) / static_cast<float>(n);
+                            write(grid.faceBase() + face * grid.faceInteriorCount() + grid.interiorIndex(i, j), direction, rowBounds[row]);
+                        }
+
+                        for (auto s = 0u; s + j < n; s += PRIMITIVE_BAND_WIDTH)
+                        {
+                            auto* triangle = indices + 3 * (face * n * n + bandTriangle(n, s, j));
+
+                            for (auto i = s; i < s + PRIMITIVE_BAND_WIDTH && i + j < n; ++i)
+                            {
+                                *triangle++ = grid.index(face, i, j);
+                                *triangle++ = grid.index(face, i + 1, j);
+                                *triangle++ = grid.index(face, i, j + 1);
+
+                                if (i + j + 1 < n)
+                                {
+                                    *triangle++ = grid.index(face, i + 1, j);
+                                    *triangle++ = grid.index(face, i + 1, j + 1);
+                                    *triangle++ = grid.index(face, i, j + 1);
+                                }
+                            }
+                        }
+                    });
+
+        for (auto const& row : rowBounds)
+            bounds.extend(row);
+
+        // The bands already suit the vertex cache, but walk the grid's rows of vertices back and forth, so the vertices are
+        // renumbered in the order that the bands first use them.
+        optimiseVertexFetch(streams.indices(), streams.positions(), streams.colours());
+
+        return std::make_unique<Mesh>(context, std::move(streams));
     }
 } // namespace com::rhi
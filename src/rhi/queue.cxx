@@ -22,15 +22,94 @@ namespace com::rhi
         return result == vk::Result::eSuccess;
     }
 
-    void Queue::submit(vk::CommandBuffer const& commandBuffer, FrameData const* frameData)
+    void Queue::submit(vk::CommandBuffer const&          commandBuffer,
+                       FrameData const*                  frameData,
+                       std::vector<WaitSemaphore> const& waits,
+                       std::optional<SignalSemaphore>    signal)
     {
-        vk::PipelineStageFlags const waitDstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+        std::vector<vk::Semaphore>          waitSemaphores;
+        std::vector<vk::PipelineStageFlags> waitDstStageMask;
+        std::vector<uint64_t>               waitValues;
 
-        vk::SubmitInfo const info(frameData->presentCompleteSemaphore(), waitDstStageMask, commandBuffer, frameData->renderCompleteSemaphore());
+        // Headless frames have no swap chain image to wait for or present.
+        if (frameData->presentCompleteSemaphore())
+        {
+            waitSemaphores.emplace_back(frameData->presentCompleteSemaphore());
+            waitDstStageMask.emplace_back(vk::PipelineStageFlagBits::eColorAttachmentOutput);
+            waitValues.emplace_back(0);
+        }
+
+        for (auto const& wait : waits)
+        {
+            waitSemaphores.emplace_back(wait.semaphore);
+            waitDstStageMask.emplace_back(wait.stage);
+            waitValues.emplace_back(wait.value);
+        }
+
+        std::vector<vk::Semaphore> signalSemaphores;
+        std::vector<uint64_t>      signalValues;
+
+        if (frameData->renderCompleteSemaphore())
+        {
+            signalSemaphores.emplace_back(frameData->renderCompleteSemaphore());
+            signalValues.emplace_back(0);
+        }
+
+        if (signal)
+        {
+            signalSemaphores.emplace_back(signal->semaphore);
+            signalValues.emplace_back(signal->value);
+        }
+
+        // Binary semaphores ignore their values, but every semaphore needs one when any of them is a timeline.
+        auto const           timelineInfo = vk::TimelineSemaphoreSubmitInfo(waitValues, signalValues);
+        vk::SubmitInfo const info(waitSemaphores, waitDstStageMask, commandBuffer, signalSemaphores, &timelineInfo);
 
         m_queue.submit(info, frameData->fence());
     }
 
+    void Queue::submit(vk::CommandBuffer const& commandBuffer, vk::Semaphore const& signal, vk::Fence const& fence, std::vector<WaitSemaphore> const& waits)
+    {
+        std::vector<vk::Semaphore>          waitSemaphores;
+        std::vector<vk::PipelineStageFlags> waitDstStageMask;
+        std::vector<uint64_t>               waitValues;
+
+        for (auto const& wait : waits)
+        {
+            waitSemaphores.emplace_back(wait.semaphore);
+            waitDstStageMask.emplace_back(wait.stage);
+            waitValues.emplace_back(wait.value);
+        }
+
+        std::vector<vk::Semaphore> signalSemaphores;
+        if (signal)
+            signalSemaphores.emplace_back(signal);
+
+        auto const           timelineInfo = vk::TimelineSemaphoreSubmitInfo(waitValues, {});
+        vk::SubmitInfo const info(waitSemaphores, waitDstStageMask, commandBuffer, signalSemaphores, &timelineInfo);
+
+        m_queue.submit(info, fence);
+    }
+
+    void Queue::submit(vk::CommandBuffer const& commandBuffer, vk::Semaphore const& timeline, uint64_t const value, std::vector<WaitSemaphore> const& waits)
+    {
+        std::vector<vk::Semaphore>          waitSemaphores;
+        std::vector<vk::PipelineStageFlags> waitDstStageMask;
+        std::vector<uint64_t>               waitValues;
+
+        for (auto const& wait : waits)
+        {
+            waitSemaphores.emplace_back(wait.semaphore);
+            waitDstStageMask.emplace_back(wait.stage);
+            waitValues.emplace_back(wait.value);
+        }
+
+        auto const           timelineInfo = vk::TimelineSemaphoreSubmitInfo(waitValues, value);
+        vk::SubmitInfo const info(waitSemaphores, waitDstStageMask, commandBuffer, timeline, &timelineInfo);
+
+        m_queue.submit(info);
+    }
+
     void Queue::wait()
     {
         m_queue.waitIdle();
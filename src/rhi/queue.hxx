@@ -6,6 +6,8 @@
 
 #include <vulkan/vulkan.hpp>
 
+#include <optional>
+
 namespace com::rhi
 {
     /// Specifies the queue index.
@@ -17,6 +19,21 @@ namespace com::rhi
         eTransfer  ///< A transfer queue.
     };
 
+    /// A semaphore that a submission waits upon.
+    struct WaitSemaphore final
+    {
+        vk::Semaphore          semaphore; ///< The semaphore.
+        vk::PipelineStageFlags stage;     ///< The first stage that waits.
+        uint64_t               value = 0; ///< The value to wait for; ignored by binary semaphores.
+    };
+
+    /// A timeline semaphore that a submission signals.
+    struct SignalSemaphore final
+    {
+        vk::Semaphore semaphore; ///< The semaphore.
+        uint64_t      value = 0; ///< The value to signal.
+    };
+
     /// Represents a queue.
     class Queue final
     {
@@ -35,7 +52,26 @@ namespace com::rhi
         /// Submit the queue.
         /// \param commandBuffer The command buffer.
         /// \param frameData The frame data.
-        void submit(vk::CommandBuffer const& commandBuffer, class FrameData const* frameData);
+        /// \param waits Additional semaphores to wait upon, e.g., outstanding compute work.
+        /// \param signal A timeline semaphore to signal upon completion, in addition to the frame's semaphore.
+        void submit(vk::CommandBuffer const&          commandBuffer,
+                    class FrameData const*            frameData,
+                    std::vector<WaitSemaphore> const& waits  = {},
+                    std::optional<SignalSemaphore>    signal = std::nullopt);
+
+        /// Submit work that is not tied to a frame, e.g., compute.
+        /// \param commandBuffer The command buffer.
+        /// \param signal The semaphore to signal upon completion, if any.
+        /// \param fence The fence to signal upon completion.
+        /// \param waits The semaphores to wait upon.
+        void submit(vk::CommandBuffer const& commandBuffer, vk::Semaphore const& signal, vk::Fence const& fence, std::vector<WaitSemaphore> const& waits = {});
+
+        /// Submit work that signals a timeline semaphore, e.g., transfers.
+        /// \param commandBuffer The command buffer.
+        /// \param timeline The timeline semaphore to signal upon completion.
+        /// \param value The value to signal.
+        /// \param waits The semaphores to wait upon.
+        void submit(vk::CommandBuffer const& commandBuffer, vk::Semaphore const& timeline, uint64_t const value, std::vector<WaitSemaphore> const& waits = {});
 
         /// Wait for all operations to finish.
         void wait();
@@ -0,0 +1,32 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "rhi/render-target.hxx"
+#include "rhi/buffer.hxx"
+
+namespace com::rhi
+{
+    /// The size of a colour pixel, in bytes. Every colour format the context picks is 8-bit RGBA or BGRA.
+    static constexpr vk::DeviceSize s_pixelSize = 4;
+
+    RenderTarget::RenderTarget(Context const* context, vk::Extent2D const& extent) : m_extent(extent), m_rect(vk::Offset2D(0, 0), extent)
+    {
+        auto const colourUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc;
+
+        m_colour       = std::make_unique<Image>(context->device(), m_extent, context->colorFormat(), colourUsage);
+        m_depthStencil = std::make_unique<Image>(context->device(), m_extent, context->depthFormat(), vk::ImageUsageFlagBits::eDepthStencilAttachment);
+    }
+
+    void RenderTarget::copyColour(vk::CommandBuffer const& commandBuffer, Buffer* destination)
+    {
+        m_colour->transition(Image::Usage::eTransferSrc, commandBuffer);
+        m_colour->copyRect(m_rect, 0, commandBuffer, destination);
+    }
+
+    auto RenderTarget::size() const -> vk::DeviceSize
+    {
+        return s_pixelSize * m_extent.width * m_extent.height;
+    }
+
+} // namespace com::rhi
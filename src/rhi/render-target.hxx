@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include "rhi/context.hxx"
+#include "rhi/image.hxx"
+
+namespace com::rhi
+{
+    /// An offscreen colour and depth target, for rendering without a swap chain.
+    class RenderTarget final
+    {
+    public:
+        /// Constructor.
+        /// \param context The RHI context.
+        /// \param extent The extent of the target.
+        explicit RenderTarget(Context const* context, vk::Extent2D const& extent);
+
+        /// Accessor.
+        /// \return A valid Vulkan object.
+        [[nodiscard]] auto colour()
+        {
+            return m_colour.get();
+        }
+
+        /// Copy the colour image into a buffer, as tightly packed pixels. The colour image is left as a transfer source.
+        /// \param commandBuffer The command buffer.
+        /// \param destination The target memory, which must hold at least size() bytes.
+        void copyColour(vk::CommandBuffer const& commandBuffer, class Buffer* destination);
+
+        /// Accessor.
+        /// \return A valid Vulkan object.
+        [[nodiscard]] auto depthStencil()
+        {
+            return m_depthStencil.get();
+        }
+
+        /// Accessor.
+        /// \return A valid Vulkan object.
+        [[nodiscard]] auto extent() const
+        {
+            return m_extent;
+        }
+
+        /// Accessor.
+        /// \return A valid Vulkan object.
+        [[nodiscard]] auto rect() const
+        {
+            return m_rect;
+        }
+
+        /// Get the size of the colour image, in bytes.
+        /// \return A valid size.
+        [[nodiscard]] auto size() const -> vk::DeviceSize;
+
+    private:
+        vk::Extent2D           m_extent;
+        vk::Rect2D             m_rect;
+        std::unique_ptr<Image> m_colour;
+        std::unique_ptr<Image> m_depthStencil;
+    };
+} // namespace com::rhi
@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#ifndef BRUSH_GLSL
+#define BRUSH_GLSL
+
+vec3 uint_to_colour(uint x)
+{
+    uint r = (x      ) & 0xff;
+    uint g = (x >>  8) & 0xff;
+    uint b = (x >> 16) & 0xff;
+
+    return vec3(float(r), float(g), float(b)) * (1.0 / 255.0);
+}
+
+uint colour_to_uint(vec3 x)
+{
+    uint r = uint(clamp(x.r, 0.0, 1.0) * 255.0);
+    uint g = uint(clamp(x.g, 0.0, 1.0) * 255.0);
+    uint b = uint(clamp(x.b, 0.0, 1.0) * 255.0);
+
+    return (r) | (g << 8) | (b << 16) | 0xff000000;
+}
+
+// Apply a brush to a single vertex; returns true if the vertex is within the brush.
+bool apply_brush(BrushUniform brush, inout vec3 p_edit, inout uint c_packed)
+{
+    vec3  delta  = p_edit - brush.p;
+    float d_sqrd = dot(delta, delta);
+    if (d_sqrd < brush.r_sqrd)
+    {
+        float d = sqrt(d_sqrd);
+        float weight = 1.0 - (d / brush.r);
+
+        weight *= brush.offset;
+
+        vec3 c_edit = uint_to_colour(c_packed);
+
+        p_edit = p_edit + weight * brush.n * brush.scale;
+        c_edit = mix(c_edit, brush.colour, weight * brush.amount);
+
+        c_packed = colour_to_uint(c_edit);
+        return true;
+    }
+
+    return false;
+}
+
+// Map a float to an int whose signed ordering matches the float's, so that bounds can be updated with integer atomics.
+int float_to_ordered(float f)
+{
+    int i = floatBitsToInt(f);
+    return (i >= 0) ? i : i ^ 0x7fffffff;
+}
+
+float ordered_to_float(int i)
+{
+    return intBitsToFloat((i >= 0) ? i : i ^ 0x7fffffff);
+}
+
+// Unpack the coordinates of a grid cell, which are packed with 8 bits per axis.
+uvec3 unpack_cell(uint packed)
+{
+    return uvec3(packed & 0xff, (packed >> 8) & 0xff, (packed >> 16) & 0xff);
+}
+
+uint cell_index(GridUniform grid, uvec3 c)
+{
+    return c.x + grid.dims.x * (c.y + grid.dims.y * c.z);
+}
+
+#endif // #ifndef BRUSH_GLSL
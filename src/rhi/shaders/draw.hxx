@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#ifndef DRAW_HXX
+#define DRAW_HXX
+
+// Shaders that include this file must enable GL_EXT_shader_explicit_arithmetic_types_int64, and include uniforms.hxx
+// first.
+
+/// The most triangles in a meshlet. A model's triangles are split into meshlets in index order, which the generators and
+/// subdivision keep spatially coherent.
+#define MESHLET_TRIANGLE_COUNT 124
+
+/// The room for packed vertices that each meshlet has, which is enough for triangles that share none.
+#define MESHLET_VERTEX_COUNT (3 * MESHLET_TRIANGLE_COUNT)
+
+/// A model drawn by a draw list.
+struct DrawRecord
+{
+    mat4 model; ///< The model's transform.
+
+    int  lo[3];       ///< The minimum corner of the model's object-space bounds, as ordered integers that refits grow.
+    uint index_count; ///< The number of indices.
+
+    int  hi[3];       ///< The maximum corner of the model's object-space bounds, as ordered integers that refits grow.
+    uint first_index; ///< The offset of the model's indices in the draw list's index buffer, which is even.
+
+    uint64_t positions; ///< The device address of the model's edit vertices.
+    uint64_t colours;   ///< The device address of the model's colours.
+
+    vec3  quantize_origin; ///< The object-space origin of the grid that packed positions are quantized to.
+    float quantize_step;   ///< The spacing of the grid.
+
+    uint64_t packed_vertices; ///< The device address of the draw list's packed vertices.
+    uint64_t indices;         ///< The device address of the model's indices, which refits read.
+};
+
+/// A run of a model's triangles that is culled, and drawn, as one.
+struct DrawMeshlet
+{
+    vec3  centre; ///< The centre of the object-space bounding sphere.
+    float radius; ///< The radius of the bounding sphere.
+
+    vec3  axis;   ///< The average of the triangles' object-space normals.
+    float cutoff; ///< The sine of the angle between the axis and the furthest normal; above one if they span a hemisphere.
+
+    uint record;      ///< The index of the model's record.
+    uint first_index; ///< The offset of the meshlet's indices in the draw list's index buffer.
+    uint index_count; ///< The number of indices.
+    uint shift;       ///< The number of bits that the packed positions are shifted down by to fit in 16 bits.
+
+    int  base[3]; ///< The grid point at the minimum corner of the meshlet's box, which packed positions are relative to.
+    uint pad0;    ///< Padding.
+};
+
+/// A packed vertex: a 16-bit position on the record's grid relative to the meshlet's base, followed by an RGB565 colour.
+struct DrawPackedVertex
+{
+    uint xy;       ///< The x and y positions.
+    uint z_colour; ///< The z position, and the colour in the upper half.
+};
+
+/// A VkDrawIndexedIndirectCommand.
+struct DrawCommand
+{
+    uint index_count;    ///< The number of indices.
+    uint instance_count; ///< The number of instances.
+    uint first_index;    ///< The first index.
+    int  vertex_offset;  ///< The value added to each index, which is the start of the meshlet's packed vertices.
+    uint first_instance; ///< The first instance, which is the index of the meshlet.
+};
+
+/// The header of a draw list's command buffer, which is followed by the commands.
+struct DrawCounts
+{
+    uint count; ///< The number of commands.
+    uint pad0;  ///< Padding.
+    uint pad1;  ///< Padding.
+    uint pad2;  ///< Padding.
+};
+
+/// The frustum that a draw list is culled against.
+struct CullUniform
+{
+    vec4 planes[4]; ///< The side planes of the frustum in world-space, facing inwards.
+
+    vec3 eye;           ///< The world-space eye, which back-facing meshlets are culled from.
+    uint meshlet_count; ///< The number of meshlets.
+};
+
+/// The meshlets whose bounds are recomputed from the vertices.
+struct MeshletRefitUniform
+{
+    vec4 region;        ///< A world-space sphere; only meshlets whose bounds touch it are refit, unless its radius is negative.
+    uint meshlet_count; ///< The number of meshlets, or of listed meshlets if there is a list.
+    uint pad0;          ///< Padding.
+
+    uint64_t short_indices; ///< The device address of the 16-bit indices to write.
+    uint64_t meshlets;      ///< The device address of a list of the meshlets to refit, or zero to refit every meshlet.
+};
+
+#endif // #ifndef DRAW_HXX
@@ -0,0 +1,47 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#ifndef FOOTPRINT_HXX
+#define FOOTPRINT_HXX
+
+// Shaders that include this file must enable GL_EXT_shader_explicit_arithmetic_types_int64, and include uniforms.hxx
+// first.
+
+/// The surface under a brush, reduced from the hit-test tile around the mouse.
+struct FootprintResult
+{
+    vec3 normal; ///< The averaged world-space unit normal.
+    uint count;  ///< The number of pixels that were averaged, or zero if the brush is over nothing.
+
+    vec3  centre;    ///< The world-space centroid of the pixels.
+    float min_depth; ///< The smallest depth of the pixels, in normalised device coordinates.
+
+    vec4 plane; ///< The plane through the centroid that faces along the normal, as the normal and its distance.
+
+    float max_depth; ///< The largest depth of the pixels, in normalised device coordinates.
+    float pad0;      ///< Padding.
+    float pad1;      ///< Padding.
+    float pad2;      ///< Padding.
+};
+
+/// Reduce a hit-test tile into a footprint. A single workgroup reads the whole tile.
+struct FootprintUniform
+{
+    mat4 unproject; ///< The inverse view-projection that the tile was rendered with.
+
+    uint64_t pixels; ///< The device address of the tile's depths, followed by its packed normals.
+    uint64_t result; ///< The device address of the FootprintResult.
+
+    uvec2 origin; ///< The offset of the tile in the viewport.
+    uvec2 tile;   ///< The extent of the tile.
+    uvec2 extent; ///< The extent of the viewport.
+    uvec2 centre; ///< The pixel under the mouse, relative to the tile.
+
+    float radius; ///< The world-space radius around the mouse's hit to average over, or zero for the whole tile.
+    uint  pad0;   ///< Padding.
+    uint  pad1;   ///< Padding.
+    uint  pad2;   ///< Padding.
+};
+
+#endif // #ifndef FOOTPRINT_HXX
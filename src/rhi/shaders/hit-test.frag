@@ -15,10 +15,6 @@ layout (set = 0, binding = 0, std430) uniform Camera {
     CameraUniform u_camera;
 };
 
-layout (set = 0, binding = 1, std430) uniform Model {
-    ModelUniform u_model;
-};
-
 float normal_sign(float x)
 {
     return (x < 0.0) ? -1.0 : 1.0;
@@ -15,7 +15,7 @@ layout (set = 0, binding = 0, std430) uniform Camera {
     CameraUniform u_camera;
 };
 
-layout (set = 0, binding = 1, std430) uniform Model {
+layout (push_constant, std430) uniform Model {
     ModelUniform u_model;
 };
 
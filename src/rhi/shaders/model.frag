@@ -16,10 +16,6 @@ layout (set = 0, binding = 0, std430) uniform Camera {
     CameraUniform u_camera;
 };
 
-layout (set = 0, binding = 1, std430) uniform Model {
-    ModelUniform u_model;
-};
-
 void main()
 {
     vec3 pos_world = in_world;
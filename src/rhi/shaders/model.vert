@@ -4,11 +4,17 @@
 
 #version 450
 #extension GL_EXT_scalar_block_layout : require
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
 
 #include "uniforms.hxx"
+#include "draw.hxx"
 
-layout (location = 0) in vec3 in_position;
-layout (location = 1) in vec3 in_colour;
+// The packed vertices are pulled through the device address in the model's record, so that every model is drawn by a
+// single indirect draw.
+layout (buffer_reference, std430) readonly buffer PackedVertices {
+    DrawPackedVertex in_vs[];
+};
 
 layout (location = 0) out vec3 out_world;
 layout (location = 1) out vec3 out_colour;
@@ -17,16 +23,31 @@ layout (set = 0, binding = 0, std430) uniform Camera {
     CameraUniform u_camera;
 };
 
-layout (set = 0, binding = 1, std430) uniform Model {
-    ModelUniform u_model;
+layout (set = 1, binding = 0, std430) readonly buffer Records {
+    DrawRecord in_records[];
+};
+
+layout (set = 1, binding = 2, std430) readonly buffer Meshlets {
+    DrawMeshlet in_meshlets[];
 };
 
 void main() 
 {
-    vec3 pos_object = in_position;
-    vec3 pos_world = vec3(u_model.model * vec4(pos_object, 1.0));
+    DrawMeshlet      meshlet = in_meshlets[gl_InstanceIndex];
+    DrawRecord       record  = in_records[meshlet.record];
+    DrawPackedVertex v       = PackedVertices(record.packed_vertices).in_vs[gl_VertexIndex];
+
+    // The position is a point on the record's grid, relative to the meshlet's base.
+    ivec3 t          = ivec3(v.xy & 0xffff, v.xy >> 16, v.z_colour & 0xffff) << meshlet.shift;
+    ivec3 q          = ivec3(meshlet.base[0], meshlet.base[1], meshlet.base[2]) + t;
+    vec3  pos_object = record.quantize_origin + vec3(q) * record.quantize_step;
+
+    out_colour = vec3(float((v.z_colour >> 16) & 0x1f) * (1.0 / 31.0),
+                      float((v.z_colour >> 21) & 0x3f) * (1.0 / 63.0),
+                      float((v.z_colour >> 27) & 0x1f) * (1.0 / 31.0));
+
+    vec3 pos_world = vec3(record.model * vec4(pos_object, 1.0));
 
-    out_colour = in_colour;
     out_world = pos_world;
     gl_Position = u_camera.projection * vec4(pos_world, 1.0);
 }
@@ -0,0 +1,32 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#ifndef MULTIRES_HXX
+#define MULTIRES_HXX
+
+// Shaders that include this file must enable GL_EXT_shader_explicit_arithmetic_types_int64, and include uniforms.hxx
+// first.
+
+/// Store each vertex's displacement from the interpolation of its parents.
+#define MULTIRES_MODE_STORE 0
+
+/// Rebuild each vertex from the interpolation of its parents and its displacement.
+#define MULTIRES_MODE_APPLY 1
+
+/// A pass over one multiresolution level, which reads the level below it.
+struct MultiresUniform
+{
+    uint64_t parent_positions; ///< The device address of the edit vertices of the level below.
+    uint64_t parent_colours;   ///< The device address of the colours of the level below.
+    uint64_t positions;        ///< The device address of the level's edit vertices.
+    uint64_t base_positions;   ///< The device address of the level's base vertices.
+    uint64_t colours;          ///< The device address of the level's colours.
+    uint64_t parents;          ///< The device address of the two parents of each vertex.
+    uint64_t displacements;    ///< The device address of the displacement of each vertex.
+
+    uint vertex_count; ///< The number of vertices in the level.
+    uint mode;         ///< The pass, one of MULTIRES_MODE_*.
+};
+
+#endif // #ifndef MULTIRES_HXX
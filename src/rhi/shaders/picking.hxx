@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#ifndef PICKING_HXX
+#define PICKING_HXX
+
+// Shaders that include this file must enable GL_EXT_shader_explicit_arithmetic_types_int64, and include uniforms.hxx
+// first.
+
+/// The triangle of a result whose ray has not hit anything.
+#define PICK_NO_HIT 0xFFFFFFFF
+
+/// The depth of the traversal stack. A traversal pushes at most one node per level, so this bounds the depth of the trees
+/// that can be picked exactly.
+#define PICK_STACK_SIZE 64
+
+/// A node of a device BVH, laid out as scene::BvhNode.
+struct PickNode
+{
+    vec3 lo;    ///< The minimum corner of the node's bounds.
+    uint first; ///< The first triangle of a leaf, or the right child of an interior node.
+
+    vec3 hi;    ///< The maximum corner of the node's bounds.
+    uint count; ///< The number of triangles in a leaf, or zero for an interior node.
+};
+
+/// A world-space ray that is cast into the models.
+struct PickRay
+{
+    vec3  origin; ///< The origin.
+    float t_max;  ///< The furthest distance along the ray to consider.
+
+    vec3  direction; ///< The direction, which need not be normalised.
+    float pad0;      ///< Padding.
+};
+
+/// The nearest hit of a ray.
+struct PickResult
+{
+    vec3  position; ///< The world-space position.
+    float t;        ///< The distance along the ray, in multiples of its direction.
+
+    vec3 normal;   ///< The world-space unit normal, which faces the ray.
+    uint triangle; ///< The index of the triangle in its mesh, or PICK_NO_HIT.
+
+    uint model; ///< The index of the model.
+    uint pad0;  ///< Padding.
+    uint pad1;  ///< Padding.
+    uint pad2;  ///< Padding.
+};
+
+/// Cast rays into one model. The models are picked in turn, each keeping the results that are nearer than its own hits.
+struct PickUniform
+{
+    mat4 to_object; ///< The inverse of the model's transform.
+
+    uint64_t nodes;     ///< The device address of the nodes.
+    uint64_t triangles; ///< The device address of the vertex indices of each triangle, in leaf order.
+    uint64_t order;     ///< The device address of the original index of each triangle, in leaf order.
+    uint64_t positions; ///< The device address of the edit vertices.
+    uint64_t rays;      ///< The device address of the rays.
+    uint64_t results;   ///< The device address of the results, one per ray.
+
+    uint ray_count; ///< The number of rays.
+    uint model;     ///< The index of the model.
+    uint pad0;      ///< Padding.
+    uint pad1;      ///< Padding.
+};
+
+/// Refit one level of a device BVH to the edit vertices; the levels are refit from the deepest up.
+struct BvhRefitUniform
+{
+    uint64_t nodes;       ///< The device address of the nodes.
+    uint64_t triangles;   ///< The device address of the vertex indices of each triangle, in leaf order.
+    uint64_t positions;   ///< The device address of the edit vertices.
+    uint64_t level_nodes; ///< The device address of the node indices, grouped by level.
+
+    uint first; ///< The first of the level's node indices.
+    uint count; ///< The number of nodes in the level.
+};
+
+#endif // #ifndef PICKING_HXX
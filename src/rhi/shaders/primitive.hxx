@@ -0,0 +1,40 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#ifndef PRIMITIVE_HXX
+#define PRIMITIVE_HXX
+
+// Shaders that include this file must enable GL_EXT_shader_explicit_arithmetic_types_int64, and include uniforms.hxx
+// first.
+
+#define PRIMITIVE_KIND_SPHERE      0
+#define PRIMITIVE_KIND_CUBE_SPHERE 1
+#define PRIMITIVE_KIND_PLANE       2
+
+/// The local size of the primitive generator in each dimension, which covers GROUP_SIZE invocations.
+#define PRIMITIVE_GROUP_SIZE 16
+
+/// The number of columns in each of the bands that a face's triangles are emitted in, row by row. Each row of a band reuses
+/// the vertices along the top of the row before it, so the 2 * (width + 1) vertices of two rows must fit in a 16-entry
+/// post-transform cache.
+#define PRIMITIVE_BAND_WIDTH 7
+
+/// A primitive that is generated on the device. Each invocation owns one grid point of one face.
+struct PrimitiveUniform
+{
+    vec3  centre; ///< The centre of the primitive.
+    float radius; ///< The radius, or half the width of a plane.
+
+    uint kind;      ///< The kind of primitive, i.e., any of PRIMITIVE_KIND_*.
+    uint frequency; ///< The number of segments along each edge of a face.
+    uint colour;    ///< The colour of every vertex.
+    uint pad0;      ///< Padding.
+
+    uint64_t base_positions; ///< The device address of the base vertices.
+    uint64_t edit_positions; ///< The device address of the edit vertices.
+    uint64_t colours;        ///< The device address of the colours.
+    uint64_t indices;        ///< The device address of the indices.
+};
+
+#endif // #ifndef PRIMITIVE_HXX
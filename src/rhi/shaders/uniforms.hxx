@@ -2,21 +2,34 @@
 // Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
 //
 
+#ifndef UNIFORMS_HXX
+#define UNIFORMS_HXX
+
 #if defined(__cplusplus)
 #    include <glm/mat4x4.hpp>
 #    include <glm/vec2.hpp>
 #    include <glm/vec3.hpp>
 #    include <glm/vec4.hpp>
 
-using vec2 = glm::vec2;
-using vec3 = glm::vec3;
-using vec4 = glm::vec4;
-using mat4 = glm::mat4;
-using uint = uint32_t;
+using vec2  = glm::vec2;
+using vec3  = glm::vec3;
+using vec4  = glm::vec4;
+using mat4  = glm::mat4;
+using uint  = uint32_t;
+using uvec2 = glm::uvec2;
+using uvec3 = glm::uvec3;
 #endif
 
 #define GROUP_SIZE 256
 
+#define GRID_MODE_RESET   0
+#define GRID_MODE_COUNT   1
+#define GRID_MODE_PREFIX  2
+#define GRID_MODE_SCATTER 3
+#define GRID_MODE_SPAN    4
+#define GRID_MODE_RECOUNT 5
+#define GRID_MODE_RESORT  6
+
 /// A camera.
 struct CameraUniform
 {
@@ -47,3 +60,21 @@ struct BrushUniform
     float scale;  ///< Scale.
     float offset; ///< Offset.
 };
+
+/// A uniform grid that buckets a mesh's vertices, used to cull brush dispatches.
+struct GridUniform
+{
+    vec3 origin; ///< The minimum corner of the grid.
+    uint mode;   ///< The build pass, one of GRID_MODE_*.
+
+    vec3 inv_cell;   ///< The reciprocal of the size of a cell.
+    uint cell_count; ///< The number of cells.
+
+    uvec3 dims;         ///< The number of cells along each axis.
+    uint  vertex_count; ///< The number of vertices.
+
+    uint box_min; ///< The minimum cell of the box that a pass is limited to, with 8 bits per axis.
+    uint box_max; ///< The maximum cell of the box, inclusive.
+};
+
+#endif // #ifndef UNIFORMS_HXX
@@ -0,0 +1,188 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "rhi/staging-ring.hxx"
+#include "rhi/context.hxx"
+
+#include <utility>
+
+namespace com::rhi
+{
+    /// The alignment of each copy within the arena.
+    static constexpr vk::DeviceSize s_alignment = 16;
+
+    StagingRing::StagingRing(Context* context, vk::DeviceSize const capacity) : m_context(context), m_capacity(capacity)
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        m_buffer = std::make_unique<Buffer>(m_context, m_capacity, vk::BufferUsageFlagBits::eTransferSrc);
+        m_data   = static_cast<uint8_t*>(m_buffer->data());
+
+        auto const typeInfo = vk::SemaphoreTypeCreateInfo(vk::SemaphoreType::eTimeline, m_value);
+        m_semaphore         = device.createSemaphore(vk::SemaphoreCreateInfo({}, &typeInfo));
+
+        for (auto& batch : m_batches)
+            batch.commandPool = std::make_unique<CommandPool>(m_context->device(), m_context->queueIndex(QueueIndex::eTransfer));
+    }
+
+    StagingRing::~StagingRing()
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        if (m_isRecording)
+            m_batches[m_batchIndex].commandPool->commandBuffer().end();
+
+        wait(m_value);
+
+        for (auto& batch : m_batches)
+            batch.commandPool.reset();
+
+        device.destroySemaphore(m_semaphore);
+
+        m_buffer.reset();
+    }
+
+    void StagingRing::copy(Buffer const* destination, void const* data, vk::DeviceSize size, vk::DeviceSize offset)
+    {
+        auto const* bytes = static_cast<uint8_t const*>(data);
+
+        // Data larger than the arena is copied in chunks, each of which may have to wait for space.
+        while (size > 0)
+        {
+            auto const chunk  = std::min(size, m_capacity);
+            auto const source = allocate(chunk);
+
+            std::memcpy(m_data + source, bytes, chunk);
+            m_buffer->flush(source, chunk);
+            commandBuffer().copyBuffer(m_buffer->buffer(), destination->buffer(), vk::BufferCopy(source, offset, chunk));
+
+            bytes  += chunk;
+            offset += chunk;
+            size   -= chunk;
+        }
+    }
+
+    void StagingRing::copy(Buffer const*        destination,
+                           Buffer const*        source,
+                           vk::DeviceSize const size,
+                           vk::DeviceSize const destinationOffset,
+                           vk::DeviceSize const sourceOffset)
+    {
+        auto const barrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eTransfer,
+                                                vk::AccessFlagBits2::eTransferWrite,
+                                                vk::PipelineStageFlagBits2::eTransfer,
+                                                vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite);
+        commandBuffer().pipelineBarrier2KHR(vk::DependencyInfo({}, barrier, {}, {}));
+        commandBuffer().copyBuffer(source->buffer(), destination->buffer(), vk::BufferCopy(sourceOffset, destinationOffset, size));
+
+        // Copies recorded later may write over the destination, e.g., uploads into a buffer that has just been grown.
+        commandBuffer().pipelineBarrier2KHR(vk::DependencyInfo({}, barrier, {}, {}));
+    }
+
+    void StagingRing::retire(std::unique_ptr<Buffer> buffer)
+    {
+        // The buffer belongs to the batch being recorded, which holds the copies that read it.
+        static_cast<void>(commandBuffer());
+        m_batches[m_batchIndex].retired.emplace_back(std::move(buffer));
+    }
+
+    void StagingRing::submit()
+    {
+        if (!m_isRecording)
+            return;
+
+        auto& batch = m_batches[m_batchIndex];
+        batch.commandPool->commandBuffer().end();
+        batch.value = ++m_value;
+
+        m_context->queue(QueueIndex::eTransfer)->submit(batch.commandPool->commandBuffer(), m_semaphore, batch.value, std::exchange(m_waitSemaphores, {}));
+        m_submissions.push_back({ batch.value, m_head });
+
+        m_batchIndex  = (m_batchIndex + 1) % s_batchCount;
+        m_isRecording = false;
+
+        // Release the buffers retired by the batches that have since completed, rather than when the batches are reused.
+        auto const completed = m_context->device()->logicalDevice().getSemaphoreCounterValue(m_semaphore);
+        for (auto& retiring : m_batches)
+        {
+            if (retiring.value <= completed)
+                retiring.retired.clear();
+        }
+    }
+
+    auto StagingRing::allocate(vk::DeviceSize const size) -> vk::DeviceSize
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        // Reclaim the space used by the batches that have completed.
+        auto const completed = device.getSemaphoreCounterValue(m_semaphore);
+        while (!m_submissions.empty() && m_submissions.front().value <= completed)
+        {
+            m_tail = m_submissions.front().head;
+            m_submissions.pop_front();
+        }
+
+        // An allocation never straddles the end of the arena.
+        m_head     = (m_head + s_alignment - 1) & ~(s_alignment - 1);
+        auto start = m_head % m_capacity;
+        if (start + size > m_capacity)
+        {
+            m_head += m_capacity - start;
+            start   = 0;
+        }
+
+        while (m_head + size > m_tail + m_capacity)
+        {
+            if (m_submissions.empty())
+            {
+                if (!m_isRecording)
+                {
+                    // Nothing is in flight, so the whole arena is free.
+                    m_tail = m_head;
+                    break;
+                }
+
+                // The batch being recorded holds the space, so it must be flushed.
+                submit();
+            }
+
+            auto const submission = m_submissions.front();
+            wait(submission.value);
+
+            m_tail = submission.head;
+            m_submissions.pop_front();
+        }
+
+        m_head += size;
+
+        return start;
+    }
+
+    auto StagingRing::commandBuffer() -> vk::CommandBuffer const&
+    {
+        auto& batch = m_batches[m_batchIndex];
+
+        if (!m_isRecording)
+        {
+            // The batch's previous submission must have finished before its command buffer is reused.
+            wait(batch.value);
+
+            batch.retired.clear();
+            batch.commandPool->reset();
+            batch.commandPool->commandBuffer().begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+            m_isRecording = true;
+        }
+
+        return batch.commandPool->commandBuffer();
+    }
+
+    void StagingRing::wait(uint64_t const value) const
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        while (vk::Result::eTimeout == device.waitSemaphores(vk::SemaphoreWaitInfo({}, m_semaphore, value), std::numeric_limits<uint64_t>::max()))
+            /* noop*/;
+    }
+} // namespace com::rhi
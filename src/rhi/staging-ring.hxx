@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include "rhi/buffer.hxx"
+#include "rhi/command-pool.hxx"
+#include "rhi/queue.hxx"
+
+#include <deque>
+
+namespace com::rhi
+{
+    /// A persistently mapped upload arena that copies data into device-local buffers on the transfer queue.
+    ///
+    /// Copies are recorded into a batch which is submitted once per frame, or earlier if the ring fills up. Each
+    /// submission signals the next value of a timeline semaphore; the space it used is reclaimed once that value is
+    /// reached.
+    class StagingRing final
+    {
+    public:
+        /// Constructor.
+        /// \param context The RHI context.
+        /// \param capacity The size of the arena, in bytes.
+        explicit StagingRing(class Context* context, vk::DeviceSize const capacity);
+
+        /// Destructor.
+        ~StagingRing();
+
+        /// Copy data into a buffer.
+        /// \param destination The buffer to copy to.
+        /// \param data The data.
+        /// \param size The size of the data, in bytes.
+        /// \param offset The offset into the destination, in bytes.
+        void copy(Buffer const* destination, void const* data, vk::DeviceSize size, vk::DeviceSize offset = 0);
+
+        /// Copy a range of one buffer into another. The copy happens after every copy recorded before it, so the source
+        /// may itself have been filled by the ring, and before every copy recorded after it.
+        /// \param destination The buffer to copy to.
+        /// \param source The buffer to copy from.
+        /// \param size The size of the range, in bytes.
+        /// \param destinationOffset The offset into the destination, in bytes.
+        /// \param sourceOffset The offset into the source, in bytes.
+        void copy(Buffer const* destination, Buffer const* source, vk::DeviceSize size, vk::DeviceSize destinationOffset, vk::DeviceSize sourceOffset = 0);
+
+        /// Make the next submission wait upon a semaphore, e.g., before copying into buffers that frames in flight may still read.
+        /// \param semaphore The semaphore.
+        void addWaitSemaphore(WaitSemaphore const& semaphore)
+        {
+            m_waitSemaphores.emplace_back(semaphore);
+        }
+
+        /// Keep a buffer alive until the copies recorded so far have completed, e.g., a staging buffer that was copied from.
+        /// \param buffer The buffer to release.
+        void retire(std::unique_ptr<Buffer> buffer);
+
+        /// Submit the recorded copies to the transfer queue.
+        void submit();
+
+        /// Get the semaphore that work reading the copied data must wait upon. The copies recorded so far are submitted first,
+        /// so that the semaphore covers every one of them.
+        /// \param stage The first stage that reads the data.
+        /// \return A semaphore that is signaled once every copy recorded so far has completed.
+        [[nodiscard]] auto waitSemaphore(vk::PipelineStageFlags const stage) -> WaitSemaphore
+        {
+            submit();
+            return { m_semaphore, stage, m_value };
+        }
+
+    private:
+        [[nodiscard]] auto allocate(vk::DeviceSize const size) -> vk::DeviceSize;
+        [[nodiscard]] auto commandBuffer() -> vk::CommandBuffer const&;
+        void               wait(uint64_t const value) const;
+
+    private:
+        /// The number of batches that may be in flight.
+        static constexpr uint32_t s_batchCount = 3;
+
+        /// A batch of copies.
+        struct Batch final
+        {
+            std::unique_ptr<CommandPool>         commandPool; ///< The command pool.
+            uint64_t                             value = 0;   ///< The semaphore value signaled upon completion.
+            std::vector<std::unique_ptr<Buffer>> retired;     ///< The buffers to release upon completion.
+        };
+
+        /// A submitted batch.
+        struct Submission final
+        {
+            uint64_t value; ///< The semaphore value signaled upon completion.
+            uint64_t head;  ///< The head of the ring when the batch was submitted.
+        };
+
+        class Context*                  m_context = nullptr;
+        vk::DeviceSize                  m_capacity;
+        std::unique_ptr<Buffer>         m_buffer;
+        uint8_t*                        m_data = nullptr;
+        uint64_t                        m_head = 0;
+        uint64_t                        m_tail = 0;
+        vk::Semaphore                   m_semaphore;
+        uint64_t                        m_value = 0;
+        std::array<Batch, s_batchCount> m_batches;
+        uint32_t                        m_batchIndex  = 0;
+        bool                            m_isRecording = false;
+        std::deque<Submission>          m_submissions;
+        std::vector<WaitSemaphore>      m_waitSemaphores;
+    };
+} // namespace com::rhi
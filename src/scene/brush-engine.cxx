@@ -0,0 +1,544 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "scene/brush-engine.hxx"
+#include "rhi/shaders/multires.hxx"
+#include "rhi/utilities.hxx"
+
+#include <iterator>
+
+namespace com::scene
+{
+    /// The push constants shared by the grid shaders.
+    struct GridConstants
+    {
+        BrushUniform brush; ///< The brush sample.
+        GridUniform  grid;  ///< The grid.
+    };
+
+    [[nodiscard]] static auto groupCount(uint32_t const invocations)
+    {
+        return (invocations + GROUP_SIZE - 1) / GROUP_SIZE;
+    }
+
+    [[nodiscard]] static auto unpackCell(uint32_t const packed)
+    {
+        return glm::uvec3(packed & 0xff, (packed >> 8) & 0xff, (packed >> 16) & 0xff);
+    }
+
+    [[nodiscard]] static auto cellIndex(GridUniform const& grid, uint32_t const packed)
+    {
+        auto const cell = unpackCell(packed);
+        return cell.x + grid.dims.x * (cell.y + grid.dims.y * cell.z);
+    }
+
+    static void computeBarrier(vk::CommandBuffer const& commandBuffer)
+    {
+        auto const barrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eComputeShader,
+                                                vk::AccessFlagBits2::eShaderStorageWrite,
+                                                vk::PipelineStageFlagBits2::eComputeShader,
+                                                vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite);
+
+        commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, barrier, {}, {}));
+    }
+
+    BrushEngine::BrushEngine(rhi::Context* context) : m_context(context)
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        for (auto& batch : m_batches)
+            batch.commandPool = std::make_unique<rhi::CommandPool>(m_context->device(), m_context->queueIndex(rhi::QueueIndex::eCompute));
+
+        auto const typeInfo = vk::SemaphoreTypeCreateInfo(vk::SemaphoreType::eTimeline, m_value);
+        m_semaphore         = device.createSemaphore(vk::SemaphoreCreateInfo({}, &typeInfo));
+
+        // Full-mesh dispatch.
+        std::vector<rhi::DescriptorSetDescription> descriptorSetDescription = {
+            { vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute }, // Edit vertices.
+            { vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute }  // Colours.
+        };
+        m_descriptorSetLayout = rhi::createDescriptorSetLayout(device, descriptorSetDescription);
+
+        auto const pushConstants = vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(BrushUniform));
+        m_pipelineLayout         = device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, m_descriptorSetLayout, pushConstants));
+
+        m_shader   = rhi::createShader(device, "process.comp");
+        m_pipeline = rhi::createComputePipeline(m_context, m_shader, m_pipelineLayout);
+
+        // Grid-culled dispatch; the layout matches BrushGrid's descriptor set.
+        std::vector<rhi::DescriptorSetDescription> gridDescriptorSetDescription(2 + BrushGrid::BufferTypeCount,
+                                                                                { vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute });
+        m_gridDescriptorSetLayout = rhi::createDescriptorSetLayout(device, gridDescriptorSetDescription);
+
+        auto const gridPushConstants = vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(GridConstants));
+        m_gridPipelineLayout         = device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, m_gridDescriptorSetLayout, gridPushConstants));
+
+        m_gridBuildShader   = rhi::createShader(device, "grid-build.comp");
+        m_gridCullShader    = rhi::createShader(device, "brush-cull.comp");
+        m_gridCellsShader   = rhi::createShader(device, "brush-cells.comp");
+        m_gridBuildPipeline = rhi::createComputePipeline(m_context, m_gridBuildShader, m_gridPipelineLayout);
+        m_gridCullPipeline  = rhi::createComputePipeline(m_context, m_gridCullShader, m_gridPipelineLayout);
+        m_gridCellsPipeline = rhi::createComputePipeline(m_context, m_gridCellsShader, m_gridPipelineLayout);
+
+        // Multiresolution propagation; the levels are addressed directly.
+        auto const multiresPushConstants = vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(MultiresUniform));
+        m_multiresPipelineLayout         = device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, {}, multiresPushConstants));
+
+        m_multiresShader   = rhi::createShader(device, "multires.comp");
+        m_multiresPipeline = rhi::createComputePipeline(m_context, m_multiresShader, m_multiresPipelineLayout);
+    }
+
+    BrushEngine::~BrushEngine()
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        wait();
+        m_retiredGrids.clear();
+
+        device.destroyPipeline(m_multiresPipeline);
+        device.destroyShaderModule(m_multiresShader);
+        device.destroyPipelineLayout(m_multiresPipelineLayout);
+
+        device.destroyPipeline(m_gridCellsPipeline);
+        device.destroyPipeline(m_gridCullPipeline);
+        device.destroyPipeline(m_gridBuildPipeline);
+        device.destroyShaderModule(m_gridCellsShader);
+        device.destroyShaderModule(m_gridCullShader);
+        device.destroyShaderModule(m_gridBuildShader);
+        device.destroyPipelineLayout(m_gridPipelineLayout);
+        device.destroyDescriptorSetLayout(m_gridDescriptorSetLayout);
+
+        device.destroyPipeline(m_pipeline);
+        device.destroyShaderModule(m_shader);
+        device.destroyPipelineLayout(m_pipelineLayout);
+        device.destroyDescriptorPool(m_descriptorPool);
+        device.destroyDescriptorSetLayout(m_descriptorSetLayout);
+        device.destroySemaphore(m_semaphore);
+
+        for (auto& batch : m_batches)
+            batch.commandPool.reset();
+    }
+
+    void BrushEngine::addFrameRead()
+    {
+        // The last two reading frames are kept, as the latest may be the one being recorded.
+        auto const value = m_context->pendingFrameValue();
+        if (m_frameReads[1] != value)
+            m_frameReads = { m_frameReads[1], value };
+    }
+
+    void BrushEngine::retire(std::unique_ptr<BrushGrid> grid)
+    {
+        if (grid)
+            m_retiredGrids.push_back({ std::move(grid), m_value });
+    }
+
+    void BrushEngine::endStroke(std::vector<std::unique_ptr<Model>> const& models)
+    {
+        propagate(models);
+    }
+
+    void BrushEngine::propagate(std::vector<std::unique_ptr<Model>> const& models)
+    {
+        auto const isSubdivided = std::ranges::any_of(models, [](auto const& model) { return model->multires() && model->multires()->levelCount() > 1; });
+        if (!isSubdivided)
+            return;
+
+        // The batch begins with a barrier on the strokes before it, so their writes are visible to the copies and the passes.
+        auto const& commandBuffer = beginBatch();
+
+        for (auto const& model : models)
+        {
+            if (auto* multires = model->multires(); multires && multires->levelCount() > 1)
+                propagateLevels(commandBuffer, multires);
+        }
+
+        // The levels' parents may still be uploading, and the levels may still be drawn or refit by frames in flight.
+        auto const uploads = m_context->stagingRing()->waitSemaphore(vk::PipelineStageFlagBits::eComputeShader);
+
+        submitBatch({ uploads, frameWait() });
+    }
+
+    void BrushEngine::stroke(std::vector<std::unique_ptr<Model>> const& models, std::vector<BrushUniform> const& samples)
+    {
+        if (samples.empty() || models.empty())
+            return;
+
+        auto const& device = m_context->device()->logicalDevice();
+
+        reserveDescriptorSets(models.size());
+
+        auto const& commandBuffer  = beginBatch();
+        auto const& descriptorSets = m_batches[m_batchIndex].descriptorSets;
+
+        for (size_t i = 0; i < models.size(); ++i)
+        {
+            auto const* mesh = models[i]->mesh();
+            if (!mesh || mesh->vertexCount() == 0)
+                continue;
+
+            // The kernel operates in object-space.
+            auto const toObject = glm::inverse(models[i]->transform());
+
+            if (m_mode == Mode::eCulled)
+            {
+                auto* grid = models[i]->brushGrid();
+                if (!grid || grid->mesh() != mesh)
+                {
+                    retire(models[i]->setBrushGrid(std::make_unique<BrushGrid>(m_context, mesh, m_gridDescriptorSetLayout)));
+                    grid = models[i]->brushGrid();
+                }
+
+                if (!grid->isBuilt())
+                {
+                    buildGrid(commandBuffer, grid);
+                    grid->setBuilt();
+                }
+                else if (grid->isDirty())
+                {
+                    refreshGrid(commandBuffer, grid);
+                    grid->setBuilt();
+                }
+
+                commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_gridPipelineLayout, 0, { grid->descriptorSet() }, nullptr);
+
+                for (auto const& sample : samples)
+                {
+                    auto brush = sample;
+                    brush.p    = glm::vec3(toObject * glm::vec4(sample.p, 1.0f));
+                    brush.n    = glm::normalize(glm::vec3(toObject * glm::vec4(sample.n, 0.0f)));
+
+                    dispatchCulled(commandBuffer, grid, brush);
+                    grid->addSample(brush);
+                }
+            }
+            else
+            {
+                auto const* positions = mesh->buffer(rhi::Mesh::BufferTypeEditVertex);
+                auto const* colours   = mesh->buffer(rhi::Mesh::BufferTypeColour);
+
+                std::vector<rhi::DescriptorUpdate> updateSet;
+                updateSet.emplace_back(vk::DescriptorType::eStorageBuffer, positions->buffer(), VK_WHOLE_SIZE, vk::BufferView());
+                updateSet.emplace_back(vk::DescriptorType::eStorageBuffer, colours->buffer(), VK_WHOLE_SIZE, vk::BufferView());
+                rhi::updateDescriptorSets(device, descriptorSets[i], updateSet);
+
+                commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+                commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, { descriptorSets[i] }, nullptr);
+
+                for (auto const& sample : samples)
+                {
+                    auto brush = sample;
+                    brush.p    = glm::vec3(toObject * glm::vec4(sample.p, 1.0f));
+                    brush.n    = glm::normalize(glm::vec3(toObject * glm::vec4(sample.n, 0.0f)));
+
+                    // Each sample reads the vertices written by the previous one.
+                    commandBuffer.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(BrushUniform), &brush);
+                    commandBuffer.dispatch(groupCount(mesh->vertexCount()), 1, 1);
+                    computeBarrier(commandBuffer);
+                }
+            }
+
+            // The device BVH is refit by the picker before it is next traversed, so strokes that nothing picks after cost nothing.
+            if (auto* bvh = models[i]->deviceBvh(); bvh && bvh->mesh() == mesh)
+                bvh->setStale(true);
+        }
+
+        // The edit buffers may have been filled by uploads that are still in flight, or yet to be submitted, and may still be
+        // read by frames in flight.
+        auto const uploads = m_context->stagingRing()->waitSemaphore(vk::PipelineStageFlagBits::eComputeShader);
+
+        submitBatch({ uploads, frameWait() });
+    }
+
+    void BrushEngine::wait() const
+    {
+        m_context->waitForSemaphore(m_semaphore, m_value);
+    }
+
+    auto BrushEngine::takeWaitSemaphores() -> std::vector<rhi::WaitSemaphore>
+    {
+        if (m_takenValue == m_value)
+            return {};
+
+        m_takenValue = m_value;
+
+        // The semaphore makes the compute writes visible to the graphics submission's vertex input, and to its compute
+        // passes, which refit the draw lists' meshlets. Waiting on the latest value covers every submission before it.
+        return { { m_semaphore, vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eComputeShader, m_value } };
+    }
+
+    auto BrushEngine::frameWait() const -> rhi::WaitSemaphore
+    {
+        // The frame being recorded reads after the strokes that it waits on, so only the submitted frames that read are waited on.
+        auto const submitted = m_context->pendingFrameValue() - 1;
+        auto const value     = m_frameReads[1] <= submitted ? m_frameReads[1] : m_frameReads[0];
+
+        return m_context->frameWait(vk::PipelineStageFlagBits::eComputeShader, value);
+    }
+
+    auto BrushEngine::beginBatch() -> vk::CommandBuffer const&
+    {
+        auto& batch = m_batches[m_batchIndex];
+
+        // The batch's previous submission must have finished before its command buffer and descriptor sets are reused, which
+        // only blocks once the ring has wrapped onto a submission that is still in flight.
+        m_context->waitForSemaphore(m_semaphore, batch.value);
+        batch.commandPool->reset();
+
+        if (!m_retiredGrids.empty())
+        {
+            auto const completed = m_context->device()->logicalDevice().getSemaphoreCounterValue(m_semaphore);
+            std::erase_if(m_retiredGrids, [completed](auto const& retired) { return retired.value <= completed; });
+        }
+
+        auto const& commandBuffer = batch.commandPool->commandBuffer();
+        commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+        // Submissions to the queue start in order, but their writes are only visible to later ones through a barrier. The grids'
+        // indirect arguments that earlier strokes read are also overwritten.
+        auto const barrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eDrawIndirect |
+                                                    vk::PipelineStageFlagBits2::eTransfer,
+                                                vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eTransferWrite,
+                                                vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eDrawIndirect |
+                                                    vk::PipelineStageFlagBits2::eTransfer,
+                                                vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite |
+                                                    vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eTransferRead |
+                                                    vk::AccessFlagBits2::eTransferWrite);
+        commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, barrier, {}, {}));
+
+        return commandBuffer;
+    }
+
+    void BrushEngine::submitBatch(std::vector<rhi::WaitSemaphore> waits)
+    {
+        auto& batch = m_batches[m_batchIndex];
+        batch.commandPool->commandBuffer().end();
+        batch.value = ++m_value;
+
+        std::ranges::move(std::exchange(m_waitSemaphores, {}), std::back_inserter(waits));
+        m_context->queue(rhi::QueueIndex::eCompute)->submit(batch.commandPool->commandBuffer(), m_semaphore, batch.value, waits);
+
+        m_batchIndex = (m_batchIndex + 1) % s_batchCount;
+    }
+
+    void BrushEngine::buildGrid(vk::CommandBuffer const& commandBuffer, BrushGrid const* grid)
+    {
+        GridConstants constants = { {}, grid->uniform() };
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_gridBuildPipeline);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_gridPipelineLayout, 0, { grid->descriptorSet() }, nullptr);
+
+        auto const pass = [&](uint32_t const mode, uint32_t const groups)
+        {
+            constants.grid.mode = mode;
+            commandBuffer.pushConstants(m_gridPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(GridConstants), &constants);
+            commandBuffer.dispatch(groups, 1, 1);
+            computeBarrier(commandBuffer);
+        };
+
+        // Counting sort of the vertices by cell.
+        pass(GRID_MODE_RESET, groupCount(constants.grid.cell_count));
+        pass(GRID_MODE_COUNT, groupCount(constants.grid.vertex_count));
+        pass(GRID_MODE_PREFIX, 1);
+        pass(GRID_MODE_SCATTER, groupCount(constants.grid.vertex_count));
+    }
+
+    void BrushEngine::refreshGrid(vk::CommandBuffer const& commandBuffer, BrushGrid const* grid)
+    {
+        auto const*   dispatch  = grid->buffer(BrushGrid::BufferTypeDispatch);
+        GridConstants constants = { {}, grid->dirtyUniform() };
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_gridBuildPipeline);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_gridPipelineLayout, 0, { grid->descriptorSet() }, nullptr);
+
+        auto const push = [&](uint32_t const mode)
+        {
+            constants.grid.mode = mode;
+            commandBuffer.pushConstants(m_gridPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(GridConstants), &constants);
+        };
+
+        // The passes read the span, and the size of their dispatch, from the first.
+        auto const spanBarrier = [&commandBuffer]
+        {
+            auto const barrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eComputeShader,
+                                                    vk::AccessFlagBits2::eShaderStorageWrite,
+                                                    vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eDrawIndirect,
+                                                    vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite |
+                                                        vk::AccessFlagBits2::eIndirectCommandRead);
+            commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, barrier, {}, {}));
+        };
+
+        // The cells from the box's first to its last are contiguous, and so is the span of sorted vertices between them.
+        auto const first     = cellIndex(constants.grid, constants.grid.box_min);
+        auto const cellCount = cellIndex(constants.grid, constants.grid.box_max) - first + 1;
+
+        // The span must be found before the cells are reset.
+        push(GRID_MODE_SPAN);
+        commandBuffer.dispatch(1, 1, 1);
+        spanBarrier();
+
+        push(GRID_MODE_RESET);
+        commandBuffer.dispatch(groupCount(cellCount), 1, 1);
+        computeBarrier(commandBuffer);
+
+        push(GRID_MODE_RECOUNT);
+        commandBuffer.dispatchIndirect(dispatch->buffer(), 0);
+        computeBarrier(commandBuffer);
+
+        push(GRID_MODE_PREFIX);
+        commandBuffer.dispatch(1, 1, 1);
+        computeBarrier(commandBuffer);
+
+        push(GRID_MODE_RESORT);
+        commandBuffer.dispatchIndirect(dispatch->buffer(), 0);
+
+        // The first sample's pre-pass overwrites the indirect arguments.
+        auto const sortBarrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eDrawIndirect,
+                                                    vk::AccessFlagBits2::eShaderStorageWrite,
+                                                    vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eTransfer,
+                                                    vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite |
+                                                        vk::AccessFlagBits2::eTransferWrite);
+        commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, sortBarrier, {}, {}));
+    }
+
+    void BrushEngine::dispatchCulled(vk::CommandBuffer const& commandBuffer, BrushGrid const* grid, BrushUniform const& brush)
+    {
+        auto const* dispatch  = grid->buffer(BrushGrid::BufferTypeDispatch);
+        auto const  constants = GridConstants { brush, grid->brushUniform(brush) };
+        auto const  box       = unpackCell(constants.grid.box_max) - unpackCell(constants.grid.box_min) + 1u;
+
+        // Reset the indirect arguments to an empty dispatch.
+        std::array<uint32_t, 3> const emptyDispatch = { 0, 1, 1 };
+        commandBuffer.updateBuffer<uint32_t>(dispatch->buffer(), 0, emptyDispatch);
+
+        auto const resetBarrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eTransfer,
+                                                     vk::AccessFlagBits2::eTransferWrite,
+                                                     vk::PipelineStageFlagBits2::eComputeShader,
+                                                     vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite);
+        commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, resetBarrier, {}, {}));
+
+        // Pre-pass: gather the cells around the brush whose bounds overlap it.
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_gridCullPipeline);
+        commandBuffer.pushConstants(m_gridPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(GridConstants), &constants);
+        commandBuffer.dispatch(groupCount(box.x * box.y * box.z), 1, 1);
+
+        auto const cullBarrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eComputeShader,
+                                                    vk::AccessFlagBits2::eShaderStorageWrite,
+                                                    vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eComputeShader,
+                                                    vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eShaderStorageRead);
+        commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, cullBarrier, {}, {}));
+
+        // One workgroup per active cell.
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_gridCellsPipeline);
+        commandBuffer.pushConstants(m_gridPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(GridConstants), &constants);
+        commandBuffer.dispatchIndirect(dispatch->buffer(), 0);
+
+        // The next sample reads these vertices and bounds, and overwrites the indirect arguments.
+        auto const sampleBarrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eDrawIndirect,
+                                                      vk::AccessFlagBits2::eShaderStorageWrite,
+                                                      vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eTransfer,
+                                                      vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite |
+                                                      vk::AccessFlagBits2::eTransferWrite);
+        commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, sampleBarrier, {}, {}));
+    }
+
+    void BrushEngine::propagateLevels(vk::CommandBuffer const& commandBuffer, Multires* multires)
+    {
+        auto const level = multires->level();
+
+        auto const transferBarrier = [&commandBuffer](vk::PipelineStageFlags2 const stage, vk::AccessFlags2 const access)
+        {
+            auto const barrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite, stage, access);
+            commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, barrier, {}, {}));
+        };
+
+        // A level's first vertices are those of the level below, so the sculpted level is copied down a level at a time.
+        for (auto current = level; current > 0; --current)
+        {
+            auto const* source      = multires->mesh(current);
+            auto const* destination = multires->mesh(current - 1);
+            auto const  vertexCount = destination->vertexCount();
+
+            for (auto const type : { rhi::Mesh::BufferTypeEditVertex, rhi::Mesh::BufferTypeColour })
+            {
+                auto const stride = type == rhi::Mesh::BufferTypeColour ? sizeof(uint32_t) : sizeof(glm::vec3);
+                commandBuffer.copyBuffer(source->buffer(type)->buffer(), destination->buffer(type)->buffer(), vk::BufferCopy(0, 0, stride * vertexCount));
+            }
+
+            transferBarrier(vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferRead);
+        }
+
+        // New levels start without displacements, i.e., as the interpolation of the level below.
+        for (auto current = 1u; current < multires->levelCount(); ++current)
+        {
+            if (multires->isCleared(current))
+                continue;
+
+            commandBuffer.fillBuffer(multires->buffer(current, Multires::BufferTypeDisplacement)->buffer(), 0, VK_WHOLE_SIZE, 0);
+            multires->setCleared(current);
+        }
+
+        transferBarrier(vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite);
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_multiresPipeline);
+
+        auto const pass = [&](uint32_t const current, uint32_t const mode)
+        {
+            auto const* below = multires->mesh(current - 1);
+            auto const* mesh  = multires->mesh(current);
+
+            MultiresUniform constants  = {};
+            constants.parent_positions = below->buffer(rhi::Mesh::BufferTypeEditVertex)->deviceAddress();
+            constants.parent_colours   = below->buffer(rhi::Mesh::BufferTypeColour)->deviceAddress();
+            constants.positions        = mesh->buffer(rhi::Mesh::BufferTypeEditVertex)->deviceAddress();
+            constants.base_positions   = mesh->buffer(rhi::Mesh::BufferTypeBaseVertex)->deviceAddress();
+            constants.colours          = mesh->buffer(rhi::Mesh::BufferTypeColour)->deviceAddress();
+            constants.parents          = multires->buffer(current, Multires::BufferTypeParent)->deviceAddress();
+            constants.displacements    = multires->buffer(current, Multires::BufferTypeDisplacement)->deviceAddress();
+            constants.vertex_count     = mesh->vertexCount();
+            constants.mode             = mode;
+
+            commandBuffer.pushConstants(m_multiresPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(MultiresUniform), &constants);
+            commandBuffer.dispatch(groupCount(constants.vertex_count), 1, 1);
+        };
+
+        // The levels up to the sculpted one only read what has been copied down, so they need no barriers between them.
+        for (auto current = 1u; current <= level; ++current)
+            pass(current, MULTIRES_MODE_STORE);
+
+        computeBarrier(commandBuffer);
+
+        // Each level above reads the one below it.
+        for (auto current = level + 1; current < multires->levelCount(); ++current)
+        {
+            pass(current, MULTIRES_MODE_APPLY);
+            computeBarrier(commandBuffer);
+        }
+    }
+
+    void BrushEngine::reserveDescriptorSets(size_t const count)
+    {
+        if (count <= m_descriptorSetCapacity)
+            return;
+
+        auto const& device   = m_context->device()->logicalDevice();
+        auto const  capacity = static_cast<uint32_t>(std::max(count, 2 * m_descriptorSetCapacity));
+
+        // Every batch's sets are freed with the pool, so the strokes in flight must finish first; this only happens when models
+        // are added.
+        wait();
+        device.destroyDescriptorPool(m_descriptorPool);
+
+        // The pool's set count is derived from its sizes, so the storage buffers are split across two entries.
+        auto const                          setCount            = capacity * s_batchCount;
+        std::vector<vk::DescriptorPoolSize> descriptorPoolSizes = { { vk::DescriptorType::eStorageBuffer, setCount },
+                                                                    { vk::DescriptorType::eStorageBuffer, setCount } };
+        m_descriptorPool                                        = rhi::createDescriptorPool(device, descriptorPoolSizes);
+
+        std::vector<vk::DescriptorSetLayout> layouts(capacity, m_descriptorSetLayout);
+        for (auto& batch : m_batches)
+            batch.descriptorSets = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_descriptorPool, layouts));
+
+        m_descriptorSetCapacity = capacity;
+    }
+} // namespace com::scene
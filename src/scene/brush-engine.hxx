@@ -0,0 +1,154 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include "rhi/command-pool.hxx"
+#include "rhi/queue.hxx"
+#include "rhi/shaders/uniforms.hxx"
+#include "scene/model.hxx"
+
+namespace com::scene
+{
+    /// Applies brush strokes to models on the GPU using the compute queue.
+    ///
+    /// Each stroke is recorded into the next of a small ring of batches and signals the next value of a timeline semaphore,
+    /// so the CPU carries on while strokes are in flight, and only waits when the ring wraps onto a batch that the GPU has
+    /// yet to finish. Strokes are submitted to one queue, and each begins with a barrier on the writes of those before it.
+    class BrushEngine final
+    {
+    public:
+        /// Determines how the vertices that a brush sample touches are found.
+        enum class Mode
+        {
+            eCulled, ///< Only the vertices in the grid cells that overlap the brush are processed.
+            eFull,   ///< Every vertex of the mesh is processed.
+        };
+
+    public:
+        /// Constructor.
+        /// \param context The RHI context.
+        explicit BrushEngine(rhi::Context* context);
+
+        /// Destructor.
+        ~BrushEngine();
+
+        /// Note that the frame being recorded reads the vertices or colours that strokes write, e.g., to draw or refit them, so
+        /// that later strokes wait for it to complete before writing. Strokes only wait on the frames that have done so.
+        void addFrameRead();
+
+        /// Make the next stroke wait upon a semaphore before writing, e.g., for a readback of the buffers it writes.
+        /// \param semaphore The semaphore.
+        void addWaitSemaphore(rhi::WaitSemaphore const& semaphore)
+        {
+            m_waitSemaphores.emplace_back(semaphore);
+        }
+
+        /// Signal that the current stroke has ended, so that the multiresolution levels of the models are propagated.
+        /// \param models The models the stroke was applied to.
+        void endStroke(std::vector<std::unique_ptr<Model>> const& models);
+
+        /// Accessor.
+        /// \return A valid mode.
+        [[nodiscard]] auto mode() const
+        {
+            return m_mode;
+        }
+
+        /// Set the mode.
+        /// \param mode The mode to set.
+        void setMode(Mode const mode)
+        {
+            m_mode = mode;
+        }
+
+        /// Keep a grid alive until the strokes submitted so far have completed, e.g., when a model's grid is replaced.
+        /// \param grid The grid, which may be null.
+        void retire(std::unique_ptr<BrushGrid> grid);
+
+        /// Make the multiresolution levels of a set of models agree with their sculpted levels: the sculpted level is copied
+        /// down, the displacements of the levels up to it are stored, and the levels above it are rebuilt from theirs.
+        /// \param models The models.
+        void propagate(std::vector<std::unique_ptr<Model>> const& models);
+
+        /// Apply a stroke to a set of models.
+        /// \param models The models to apply the stroke to.
+        /// \param samples The brush samples along the stroke, in world-space.
+        void stroke(std::vector<std::unique_ptr<Model>> const& models, std::vector<BrushUniform> const& samples);
+
+        /// Wait for the outstanding strokes, if any, to finish on the GPU.
+        void wait() const;
+
+        /// Get the semaphore that work must wait upon before reading or writing the buffers that strokes write, without taking it
+        /// from the next graphics submission.
+        /// \param stage The first stage that accesses the buffers.
+        /// \return A semaphore that is signaled once every submitted stroke has completed.
+        [[nodiscard]] auto waitSemaphore(vk::PipelineStageFlags const stage) const -> rhi::WaitSemaphore
+        {
+            return { m_semaphore, stage, m_value };
+        }
+
+        /// Take the semaphores that the next graphics submission must wait upon before reading the edited buffers.
+        /// \return A collection of semaphores, which is empty if no stroke has been submitted since they were last taken.
+        [[nodiscard]] auto takeWaitSemaphores() -> std::vector<rhi::WaitSemaphore>;
+
+    private:
+        /// The number of submissions that may be in flight.
+        static constexpr uint32_t s_batchCount = 3;
+
+        /// The resources of a submission, which are reused once the submission has completed.
+        struct Batch final
+        {
+            std::unique_ptr<rhi::CommandPool> commandPool;    ///< The command pool.
+            std::vector<vk::DescriptorSet>    descriptorSets; ///< The full-mesh dispatch's sets, one per model.
+            uint64_t                          value = 0;      ///< The semaphore value signaled upon completion.
+        };
+
+        /// A grid that strokes in flight may still be using.
+        struct RetiredGrid final
+        {
+            std::unique_ptr<BrushGrid> grid;      ///< The grid.
+            uint64_t                   value = 0; ///< The semaphore value signaled by the last stroke that may use it.
+        };
+
+    private:
+        [[nodiscard]] auto beginBatch() -> vk::CommandBuffer const&;
+        void               buildGrid(vk::CommandBuffer const& commandBuffer, BrushGrid const* grid);
+        void               dispatchCulled(vk::CommandBuffer const& commandBuffer, BrushGrid const* grid, BrushUniform const& brush);
+        [[nodiscard]] auto frameWait() const -> rhi::WaitSemaphore;
+        void               propagateLevels(vk::CommandBuffer const& commandBuffer, Multires* multires);
+        void               refreshGrid(vk::CommandBuffer const& commandBuffer, BrushGrid const* grid);
+        void               reserveDescriptorSets(size_t const count);
+        void               submitBatch(std::vector<rhi::WaitSemaphore> waits);
+
+    private:
+        rhi::Context*                     m_context = nullptr;
+        std::array<Batch, s_batchCount>   m_batches;
+        uint32_t                          m_batchIndex = 0;
+        vk::Semaphore                     m_semaphore;
+        uint64_t                          m_value      = 0;
+        uint64_t                          m_takenValue = 0;
+        std::vector<rhi::WaitSemaphore>   m_waitSemaphores;
+        std::array<uint64_t, 2>           m_frameReads = {};
+        std::vector<RetiredGrid>          m_retiredGrids;
+        vk::ShaderModule                  m_shader;
+        vk::DescriptorSetLayout           m_descriptorSetLayout;
+        vk::DescriptorPool                m_descriptorPool;
+        size_t                            m_descriptorSetCapacity = 0;
+        vk::PipelineLayout                m_pipelineLayout;
+        vk::Pipeline                      m_pipeline;
+        Mode                              m_mode = Mode::eCulled;
+        vk::DescriptorSetLayout           m_gridDescriptorSetLayout;
+        vk::PipelineLayout                m_gridPipelineLayout;
+        vk::ShaderModule                  m_gridBuildShader;
+        vk::ShaderModule                  m_gridCullShader;
+        vk::ShaderModule                  m_gridCellsShader;
+        vk::Pipeline                      m_gridBuildPipeline;
+        vk::Pipeline                      m_gridCullPipeline;
+        vk::Pipeline                      m_gridCellsPipeline;
+        vk::PipelineLayout                m_multiresPipelineLayout;
+        vk::ShaderModule                  m_multiresShader;
+        vk::Pipeline                      m_multiresPipeline;
+    };
+} // namespace com::scene
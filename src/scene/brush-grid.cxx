@@ -0,0 +1,117 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "scene/brush-grid.hxx"
+#include "rhi/context.hxx"
+#include "rhi/utilities.hxx"
+
+namespace com::scene
+{
+    /// The average number of vertices per cell that the grid resolution aims for.
+    static constexpr float s_verticesPerCell = 32.0f;
+
+    /// The maximum number of cells along an axis.
+    static constexpr uint32_t s_maxCellsPerAxis = 128;
+
+    static_assert(s_maxCellsPerAxis <= 256, "The cells of a box are packed with 8 bits per axis.");
+
+    BrushGrid::BrushGrid(rhi::Context* context, rhi::Mesh const* mesh, vk::DescriptorSetLayout const& layout) : m_context(context), m_mesh(mesh)
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        // Cubic cells, sized so that the longest axis has cbrt(vertices / verticesPerCell) of them.
+        auto const bounds      = m_mesh->bounds();
+        auto const extent      = glm::max(bounds.getDiagonal(), glm::vec3(1e-6f));
+        auto const longestEdge = std::max(extent.x, std::max(extent.y, extent.z));
+        auto const cellsAlong  = std::cbrt(static_cast<float>(m_mesh->vertexCount()) / s_verticesPerCell);
+        auto const cellSize    = longestEdge / std::clamp(cellsAlong, 1.0f, static_cast<float>(s_maxCellsPerAxis));
+        auto const dims        = glm::clamp(glm::uvec3(glm::ceil(extent / cellSize)), glm::uvec3(1), glm::uvec3(s_maxCellsPerAxis));
+
+        m_uniform.origin       = bounds.getMin();
+        m_uniform.inv_cell     = glm::vec3(1.0f / cellSize);
+        m_uniform.dims         = dims;
+        m_uniform.cell_count   = dims.x * dims.y * dims.z;
+        m_uniform.vertex_count = m_mesh->vertexCount();
+        m_uniform.box_max      = (dims.x - 1) | ((dims.y - 1) << 8) | ((dims.z - 1) << 16);
+
+        auto const vertexCount = static_cast<vk::DeviceSize>(std::max(m_mesh->vertexCapacity(), 1u));
+        auto const cellCount   = static_cast<vk::DeviceSize>(m_uniform.cell_count);
+        auto const usage       = vk::BufferUsageFlagBits::eStorageBuffer;
+        auto const memory      = vk::MemoryPropertyFlagBits::eDeviceLocal;
+
+        m_buffers[BufferTypeVertexCell]   = std::make_unique<rhi::Buffer>(m_context, sizeof(uint32_t) * vertexCount, usage, memory);
+        m_buffers[BufferTypeCellRange]    = std::make_unique<rhi::Buffer>(m_context, sizeof(glm::uvec2) * cellCount, usage, memory);
+        m_buffers[BufferTypeCellCursor]   = std::make_unique<rhi::Buffer>(m_context, sizeof(uint32_t) * cellCount, usage, memory);
+        m_buffers[BufferTypeSortedVertex] = std::make_unique<rhi::Buffer>(m_context, sizeof(uint32_t) * vertexCount, usage, memory);
+        m_buffers[BufferTypeCellBounds]   = std::make_unique<rhi::Buffer>(m_context, 6 * sizeof(int32_t) * cellCount, usage, memory);
+
+        // VkDispatchIndirectCommand, the span of a refresh, then the active cells.
+        auto const dispatchUsage      = usage | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst;
+        auto const dispatchSize       = sizeof(glm::uvec3) + sizeof(glm::uvec2) + sizeof(uint32_t) * cellCount;
+        m_buffers[BufferTypeDispatch] = std::make_unique<rhi::Buffer>(m_context, dispatchSize, dispatchUsage, memory);
+
+        std::vector<vk::DescriptorPoolSize> descriptorPoolSizes = { { vk::DescriptorType::eStorageBuffer, 2 + BufferTypeCount } };
+        m_descriptorPool                                        = rhi::createDescriptorPool(device, descriptorPoolSizes);
+        m_descriptorSet = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_descriptorPool, layout)).front();
+
+        std::vector<rhi::DescriptorUpdate> updateSet;
+        updateSet.emplace_back(vk::DescriptorType::eStorageBuffer, m_mesh->buffer(rhi::Mesh::BufferTypeEditVertex)->buffer(), VK_WHOLE_SIZE, vk::BufferView());
+        updateSet.emplace_back(vk::DescriptorType::eStorageBuffer, m_mesh->buffer(rhi::Mesh::BufferTypeColour)->buffer(), VK_WHOLE_SIZE, vk::BufferView());
+
+        for (auto const& buffer : m_buffers)
+            updateSet.emplace_back(vk::DescriptorType::eStorageBuffer, buffer->buffer(), VK_WHOLE_SIZE, vk::BufferView());
+
+        rhi::updateDescriptorSets(device, m_descriptorSet, updateSet);
+    }
+
+    BrushGrid::~BrushGrid()
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        device.destroyDescriptorPool(m_descriptorPool);
+    }
+
+    void BrushGrid::addSample(BrushUniform const& brush)
+    {
+        auto const min = brush.p - glm::vec3(brush.r);
+        auto const max = brush.p + glm::vec3(brush.r);
+
+        m_dirtyMin = m_isDirty ? glm::min(m_dirtyMin, min) : min;
+        m_dirtyMax = m_isDirty ? glm::max(m_dirtyMax, max) : max;
+        m_isDirty  = true;
+
+        // A vertex moves by at most the sample's full weight along the unit normal.
+        m_drift += std::abs(brush.offset * brush.scale);
+    }
+
+    auto BrushGrid::brushUniform(BrushUniform const& brush) const -> GridUniform
+    {
+        // A vertex that has drifted into the brush was bucketed within the drift of it.
+        auto const reach = glm::vec3(brush.r + m_drift);
+        return boxUniform(brush.p - reach, brush.p + reach);
+    }
+
+    auto BrushGrid::dirtyUniform() const -> GridUniform
+    {
+        // A moved vertex was within the drift of a sample's bounds when it was bucketed, and has since moved by the drift again.
+        auto const reach = glm::vec3(2.0f * m_drift);
+        return boxUniform(m_dirtyMin - reach, m_dirtyMax + reach);
+    }
+
+    auto BrushGrid::boxUniform(glm::vec3 const& min, glm::vec3 const& max) const -> GridUniform
+    {
+        // The shaders clamp a vertex to the grid's cells, so the box is clamped the same way.
+        auto const cell = [this](glm::vec3 const& p)
+        {
+            auto const c = glm::clamp(glm::ivec3(glm::floor((p - m_uniform.origin) * m_uniform.inv_cell)), glm::ivec3(0), glm::ivec3(m_uniform.dims) - 1);
+            return static_cast<uint32_t>(c.x | (c.y << 8) | (c.z << 16));
+        };
+
+        auto uniform    = m_uniform;
+        uniform.box_min = cell(min);
+        uniform.box_max = cell(max);
+
+        return uniform;
+    }
+} // namespace com::scene
@@ -0,0 +1,133 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include "rhi/mesh.hxx"
+#include "rhi/shaders/uniforms.hxx"
+
+namespace com::scene
+{
+    /// A GPU-resident uniform grid that buckets a mesh's vertices so that a brush dispatch only touches the vertices near it.
+    ///
+    /// Vertices are counting-sorted by cell. As the brush moves vertices they stay in their original bucket and the
+    /// bucket's bounds grow instead, so culling remains conservative without re-sorting. The grid tracks how far the samples
+    /// since the last sort can have moved a vertex, so that each sample only tests the cells within that distance of it.
+    /// Before the next submission, only the cells around the samples are re-sorted, which restores tight buckets at the cost
+    /// of the region that was brushed. The per-vertex buffers are sized by the mesh's capacity, so that the vertices that
+    /// dynamic topology adds are sorted in by the next full rebuild.
+    class BrushGrid final
+    {
+    public:
+        /// Specifies the type of grid buffer.
+        enum BufferType
+        {
+            BufferTypeVertexCell,   ///< The cell of each vertex.
+            BufferTypeCellRange,    ///< The offset and count of each cell's vertices.
+            BufferTypeCellCursor,   ///< Scatter cursors, used whilst building.
+            BufferTypeSortedVertex, ///< The vertex indices, sorted by cell.
+            BufferTypeCellBounds,   ///< The bounds of each cell's vertices.
+            BufferTypeDispatch,     ///< The indirect dispatch arguments, followed by the active cells.
+            BufferTypeCount         ///< The number of buffers.
+        };
+
+    public:
+        /// Constructor.
+        /// \param context The RHI context.
+        /// \param mesh The mesh to bucket.
+        /// \param layout The descriptor set layout shared by the grid shaders.
+        explicit BrushGrid(rhi::Context* context, rhi::Mesh const* mesh, vk::DescriptorSetLayout const& layout);
+
+        /// Destructor.
+        ~BrushGrid();
+
+        /// Record a brush sample that has been dispatched, which may have moved the vertices within its radius.
+        /// \param brush The sample, in object-space.
+        void addSample(BrushUniform const& brush);
+
+        /// Get the grid's parameters for a pass that is limited to the cells that a sample can affect.
+        /// \param brush The sample, in object-space.
+        /// \return The parameters, whose box covers the sample's bounds grown by the distance the vertices may have moved.
+        [[nodiscard]] auto brushUniform(BrushUniform const& brush) const -> GridUniform;
+
+        /// Accessor.
+        /// \param type The type of buffer.
+        /// \return A valid pointer.
+        [[nodiscard]] auto buffer(BufferType const type) const
+        {
+            return m_buffers[type].get();
+        }
+
+        /// Accessor.
+        /// \return A valid Vulkan object.
+        [[nodiscard]] auto descriptorSet() const
+        {
+            return m_descriptorSet;
+        }
+
+        /// Get the grid's parameters for a refresh of the cells that the samples since the last sort have moved vertices
+        /// between.
+        /// \return The parameters, whose box covers where the moved vertices started and ended.
+        [[nodiscard]] auto dirtyUniform() const -> GridUniform;
+
+        /// Flag the grid as requiring a full rebuild, e.g., after dynamic topology has added vertices within the mesh's capacity.
+        void invalidate()
+        {
+            m_uniform.vertex_count = m_mesh->vertexCount();
+            m_isBuilt              = false;
+        }
+
+        /// Determines if the grid has been built.
+        /// \return true if the grid has been built; false otherwise.
+        [[nodiscard]] auto isBuilt() const
+        {
+            return m_isBuilt;
+        }
+
+        /// Determines if samples have moved vertices since the grid was last sorted.
+        /// \return true if the grid must be refreshed; false otherwise.
+        [[nodiscard]] auto isDirty() const
+        {
+            return m_isDirty;
+        }
+
+        /// Accessor.
+        /// \return A valid pointer.
+        [[nodiscard]] auto mesh() const
+        {
+            return m_mesh;
+        }
+
+        /// Flag the grid as built, or refreshed, so that its buckets are tight.
+        void setBuilt()
+        {
+            m_isBuilt = true;
+            m_isDirty = false;
+            m_drift   = 0.0f;
+        }
+
+        /// Get the grid's parameters.
+        /// \return The parameters for the grid shaders.
+        [[nodiscard]] auto uniform() const -> GridUniform const&
+        {
+            return m_uniform;
+        }
+
+    private:
+        [[nodiscard]] auto boxUniform(glm::vec3 const& min, glm::vec3 const& max) const -> GridUniform;
+
+    private:
+        rhi::Context*                                             m_context = nullptr;
+        rhi::Mesh const*                                          m_mesh    = nullptr;
+        GridUniform                                               m_uniform = {};
+        std::array<std::unique_ptr<rhi::Buffer>, BufferTypeCount> m_buffers;
+        vk::DescriptorPool                                        m_descriptorPool;
+        vk::DescriptorSet                                         m_descriptorSet;
+        bool                                                      m_isBuilt = false;
+        bool                                                      m_isDirty = false;
+        glm::vec3                                                 m_dirtyMin;
+        glm::vec3                                                 m_dirtyMax;
+        float                                                     m_drift = 0.0f;
+    };
+} // namespace com::scene
@@ -0,0 +1,451 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "scene/bvh.hxx"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <thread>
+
+namespace com::scene
+{
+    /// The number of triangles that are tested together, which is also the preferred size of a leaf.
+    static constexpr uint32_t s_packetSize = 4;
+
+    /// The largest leaf that the surface-area heuristic may choose over a split.
+    static constexpr uint32_t s_maxLeafSize = 16;
+
+    /// The number of bins that candidate splits are evaluated at.
+    static constexpr uint32_t s_binCount = 16;
+
+    /// The cost of visiting a node, relative to testing a triangle.
+    static constexpr float s_traversalCost = 1.0f;
+
+    /// Subtrees with more triangles than this build their halves on separate threads, whilst threads remain.
+    static constexpr uint32_t s_parallelThreshold = 1u << 16;
+
+    /// The depth of the traversal stack that is reserved up front, which is ample for balanced trees.
+    static constexpr uint32_t s_stackSize = 64;
+
+    /// The longest gap between the vertices in a box that is read across rather than starting another run.
+    static constexpr uint32_t s_runGap = 16;
+
+    /// An axis-aligned box that starts empty.
+    struct Bounds final
+    {
+        glm::vec3 lo = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 hi = glm::vec3(std::numeric_limits<float>::lowest());
+
+        void grow(glm::vec3 const& point)
+        {
+            lo = glm::min(lo, point);
+            hi = glm::max(hi, point);
+        }
+
+        void grow(Bounds const& other)
+        {
+            lo = glm::min(lo, other.lo);
+            hi = glm::max(hi, other.hi);
+        }
+
+        [[nodiscard]] auto area() const
+        {
+            auto const size = glm::max(hi - lo, glm::vec3(0.0f));
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+    };
+
+    /// Builds the flattened tree over the triangles' bounds, by partitioning the triangle order in place.
+    class BvhBuilder final
+    {
+    public:
+        /// Constructor.
+        /// \param bounds The bounds of each triangle.
+        /// \param centroids The centre of each triangle's bounds.
+        /// \param order The triangle order, which is partitioned into the order of the leaves.
+        explicit BvhBuilder(std::vector<Bounds> const& bounds, std::vector<glm::vec3> const& centroids, std::vector<uint32_t>& order)
+            : m_bounds(bounds), m_centroids(centroids), m_order(order)
+        {
+        }
+
+        /// Build the subtree over a range of the order, appending its nodes in depth-first order.
+        /// \param first The first triangle of the range.
+        /// \param count The number of triangles in the range.
+        /// \param nodes The nodes to append to.
+        /// \param threads The number of threads that the subtree may be built across.
+        void build(uint32_t const first, uint32_t const count, std::vector<BvhNode>& nodes, uint32_t const threads) const
+        {
+            auto const index = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+
+            Bounds box;
+            Bounds centroidBox;
+            for (auto i = first; i < first + count; ++i)
+            {
+                box.grow(m_bounds[m_order[i]]);
+                centroidBox.grow(m_centroids[m_order[i]]);
+            }
+
+            nodes[index].lo = box.lo;
+            nodes[index].hi = box.hi;
+
+            auto const makeLeaf = [&]
+            {
+                nodes[index].first = first;
+                nodes[index].count = count;
+            };
+
+            // Split along the axis in which the centroids are most spread.
+            auto const extent = centroidBox.hi - centroidBox.lo;
+            auto const axis   = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+            if (count <= s_packetSize || extent[axis] <= 0.0f)
+                return makeLeaf();
+
+            auto const binOf = [&](uint32_t const triangle)
+            {
+                auto const offset = (m_centroids[triangle][axis] - centroidBox.lo[axis]) / extent[axis];
+                return std::min(s_binCount - 1, static_cast<uint32_t>(offset * s_binCount));
+            };
+
+            std::array<Bounds, s_binCount>   bins;
+            std::array<uint32_t, s_binCount> binCounts = {};
+            for (auto i = first; i < first + count; ++i)
+            {
+                auto const bin = binOf(m_order[i]);
+                bins[bin].grow(m_bounds[m_order[i]]);
+                ++binCounts[bin];
+            }
+
+            // Sweep from the right to find the cost of each right-hand side, then from the left to find the best split.
+            std::array<float, s_binCount> rightCosts = {};
+            Bounds                        right;
+            auto                          rightCount = 0u;
+            for (auto bin = s_binCount - 1; bin > 0; --bin)
+            {
+                right.grow(bins[bin]);
+                rightCount += binCounts[bin];
+                rightCosts[bin - 1] = static_cast<float>(rightCount) * right.area();
+            }
+
+            Bounds left;
+            auto   leftCount = 0u;
+            auto   bestBin   = 0u;
+            auto   bestCost  = std::numeric_limits<float>::max();
+            for (auto bin = 0u; bin + 1 < s_binCount; ++bin)
+            {
+                left.grow(bins[bin]);
+                leftCount += binCounts[bin];
+
+                auto const cost = static_cast<float>(leftCount) * left.area() + rightCosts[bin];
+                if (leftCount > 0 && leftCount < count && cost < bestCost)
+                {
+                    bestBin  = bin;
+                    bestCost = cost;
+                }
+            }
+
+            auto const leafCost  = static_cast<float>(count) * box.area();
+            auto const splitCost = s_traversalCost * box.area() + bestCost;
+            if (count <= s_maxLeafSize && leafCost <= splitCost)
+                return makeLeaf();
+
+            auto const begin = m_order.begin() + first;
+            auto const end   = begin + count;
+            auto       split = static_cast<uint32_t>(std::partition(begin, end, [&](uint32_t const triangle) { return binOf(triangle) <= bestBin; }) - begin);
+
+            // The bins could not separate the centroids, so fall back to halving the range about its median.
+            if (split == 0 || split == count)
+            {
+                split = count / 2;
+                std::nth_element(begin, begin + split, end, [&](uint32_t const a, uint32_t const b) { return m_centroids[a][axis] < m_centroids[b][axis]; });
+            }
+
+            if (count > s_parallelThreshold && threads > 1)
+            {
+                // Each half is built into its own nodes on its own share of the threads, and the nodes are then appended with
+                // their child links offset. Only the top few levels are copied like this, as the threads soon run out.
+                std::vector<BvhNode> leftNodes;
+                std::vector<BvhNode> rightNodes;
+                {
+                    std::jthread thread([&] { build(first, split, leftNodes, threads / 2); });
+                    build(first + split, count - split, rightNodes, threads - threads / 2);
+                }
+
+                auto const append = [&](std::vector<BvhNode> const& subtree)
+                {
+                    auto const offset = static_cast<uint32_t>(nodes.size());
+                    for (auto node : subtree)
+                    {
+                        if (node.count == 0)
+                            node.first += offset;
+                        nodes.emplace_back(node);
+                    }
+                };
+
+                append(leftNodes);
+                nodes[index].first = static_cast<uint32_t>(nodes.size());
+                append(rightNodes);
+            }
+            else
+            {
+                build(first, split, nodes, 1);
+                nodes[index].first = static_cast<uint32_t>(nodes.size());
+                build(first + split, count - split, nodes, 1);
+            }
+        }
+
+    private:
+        std::vector<Bounds> const&    m_bounds;
+        std::vector<glm::vec3> const& m_centroids;
+        std::vector<uint32_t>&        m_order;
+    };
+
+    /// Find where a ray enters a node's bounds.
+    /// \param node The node.
+    /// \param ray The ray.
+    /// \param inverse The reciprocal of the ray's direction.
+    /// \param tMax The furthest distance along the ray to consider.
+    /// \return The distance along the ray at which it enters the bounds, or infinity if it misses them.
+    [[nodiscard]] static auto enter(BvhNode const& node, Ray const& ray, glm::vec3 const& inverse, float const tMax)
+    {
+        auto const t0    = (node.lo - ray.origin) * inverse;
+        auto const t1    = (node.hi - ray.origin) * inverse;
+        auto const near  = glm::min(t0, t1);
+        auto const far   = glm::max(t0, t1);
+        auto const entry = std::max({ near.x, near.y, near.z, 0.0f });
+        auto const exit  = std::min({ far.x, far.y, far.z, tMax });
+
+        return entry <= exit ? entry : std::numeric_limits<float>::infinity();
+    }
+
+    Bvh::Bvh(std::span<glm::vec3 const> const positions, std::span<uint32_t const> const indices)
+        : m_positions(positions.begin(), positions.end())
+    {
+        auto const triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        if (triangleCount == 0)
+            return;
+
+        std::vector<Bounds>    bounds(triangleCount);
+        std::vector<glm::vec3> centroids(triangleCount);
+        for (auto triangle = 0u; triangle < triangleCount; ++triangle)
+        {
+            for (auto corner = 0u; corner < 3; ++corner)
+                bounds[triangle].grow(m_positions[indices[3 * triangle + corner]]);
+
+            centroids[triangle] = 0.5f * (bounds[triangle].lo + bounds[triangle].hi);
+        }
+
+        m_order.resize(triangleCount);
+        std::iota(m_order.begin(), m_order.end(), 0u);
+
+        // A binary tree with at least one triangle per leaf has fewer than twice as many nodes as triangles.
+        m_nodes.reserve(2 * triangleCount / s_packetSize + 1);
+        BvhBuilder(bounds, centroids, m_order).build(0, triangleCount, m_nodes, std::max(1u, std::thread::hardware_concurrency()));
+
+        m_triangles.resize(triangleCount);
+        for (auto i = 0u; i < triangleCount; ++i)
+        {
+            auto const triangle = m_order[i];
+            m_triangles[i]      = glm::uvec3(indices[3 * triangle], indices[3 * triangle + 1], indices[3 * triangle + 2]);
+        }
+    }
+
+    auto Bvh::intersect(Ray const& ray, float const tMax) const -> std::optional<RayHit>
+    {
+        std::optional<RayHit> hit;
+        if (m_nodes.empty())
+            return hit;
+
+        auto const inverse = 1.0f / ray.direction;
+        auto       nearest = tMax;
+
+        std::vector<uint32_t> stack;
+        stack.reserve(s_stackSize);
+
+        auto index = 0u;
+
+        if (enter(m_nodes[0], ray, inverse, nearest) == std::numeric_limits<float>::infinity())
+            return hit;
+
+        for (;;)
+        {
+            auto const& node = m_nodes[index];
+
+            if (node.count > 0)
+            {
+                intersectLeaf(node, ray, hit, nearest);
+            }
+            else
+            {
+                // Visit the nearer child first, so that the further one is often culled by the hit it finds.
+                auto near     = index + 1;
+                auto far      = node.first;
+                auto nearDist = enter(m_nodes[near], ray, inverse, nearest);
+                auto farDist  = enter(m_nodes[far], ray, inverse, nearest);
+
+                if (farDist < nearDist)
+                {
+                    std::swap(near, far);
+                    std::swap(nearDist, farDist);
+                }
+
+                if (nearDist != std::numeric_limits<float>::infinity())
+                {
+                    if (farDist != std::numeric_limits<float>::infinity())
+                        stack.emplace_back(far);
+
+                    index = near;
+                    continue;
+                }
+            }
+
+            if (stack.empty())
+                break;
+
+            index = stack.back();
+            stack.pop_back();
+        }
+
+        return hit;
+    }
+
+    void Bvh::intersectLeaf(BvhNode const& node, Ray const& ray, std::optional<RayHit>& hit, float& tMax) const
+    {
+        // Möller-Trumbore, over packets of triangles laid out by component, so that each lane's arithmetic is identical and
+        // the compiler can vectorise it. Unused lanes are degenerate and never hit.
+        for (auto base = node.first; base < node.first + node.count; base += s_packetSize)
+        {
+            auto const lanes = std::min(s_packetSize, node.first + node.count - base);
+
+            std::array<glm::vec3, s_packetSize> v0 = {};
+            std::array<glm::vec3, s_packetSize> e1 = {};
+            std::array<glm::vec3, s_packetSize> e2 = {};
+            for (auto lane = 0u; lane < lanes; ++lane)
+            {
+                auto const& triangle = m_triangles[base + lane];
+                v0[lane]             = m_positions[triangle.x];
+                e1[lane]             = m_positions[triangle.y] - v0[lane];
+                e2[lane]             = m_positions[triangle.z] - v0[lane];
+            }
+
+            std::array<float, s_packetSize> ts;
+            std::array<float, s_packetSize> us;
+            std::array<float, s_packetSize> vs;
+            for (auto lane = 0u; lane < s_packetSize; ++lane)
+            {
+                auto const p     = glm::cross(ray.direction, e2[lane]);
+                auto const det   = glm::dot(e1[lane], p);
+                auto const inv   = 1.0f / det;
+                auto const s     = ray.origin - v0[lane];
+                auto const u     = glm::dot(s, p) * inv;
+                auto const q     = glm::cross(s, e1[lane]);
+                auto const v     = glm::dot(ray.direction, q) * inv;
+                auto const t     = glm::dot(e2[lane], q) * inv;
+                auto const isHit = det != 0.0f && u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f && t < tMax;
+
+                ts[lane] = isHit ? t : std::numeric_limits<float>::infinity();
+                us[lane] = u;
+                vs[lane] = v;
+            }
+
+            auto const lane = static_cast<uint32_t>(std::ranges::min_element(ts) - ts.begin());
+            if (ts[lane] == std::numeric_limits<float>::infinity())
+                continue;
+
+            tMax = ts[lane];
+            hit  = RayHit{ ts[lane], m_order[base + lane], glm::vec2(us[lane], vs[lane]), glm::normalize(glm::cross(e1[lane], e2[lane])) };
+        }
+    }
+
+    void Bvh::refit(std::span<glm::uvec2 const> const runs, std::span<glm::vec3 const> const positions)
+    {
+        auto position = positions.begin();
+        for (auto const& run : runs)
+        {
+            std::copy_n(position, run.y, m_positions.begin() + run.x);
+            position += run.y;
+        }
+
+        // Children always follow their parent, so a reverse sweep visits both children before the parent.
+        for (auto index = static_cast<uint32_t>(m_nodes.size()); index-- > 0;)
+        {
+            auto&  node = m_nodes[index];
+            Bounds box;
+
+            if (node.count > 0)
+            {
+                for (auto i = node.first; i < node.first + node.count; ++i)
+                {
+                    for (auto corner = 0; corner < 3; ++corner)
+                        box.grow(m_positions[m_triangles[i][corner]]);
+                }
+            }
+            else
+            {
+                for (auto const child : { index + 1, node.first })
+                    box.grow(Bounds{ m_nodes[child].lo, m_nodes[child].hi });
+            }
+
+            node.lo = box.lo;
+            node.hi = box.hi;
+        }
+    }
+
+    auto Bvh::vertexRuns(glm::vec3 const& lo, glm::vec3 const& hi) const -> std::vector<glm::uvec2>
+    {
+        if (m_nodes.empty())
+            return {};
+
+        std::vector<uint32_t> vertices;
+        std::vector<uint32_t> stack;
+        stack.reserve(s_stackSize);
+        stack.emplace_back(0);
+
+        while (!stack.empty())
+        {
+            auto const  index = stack.back();
+            auto const& node  = m_nodes[index];
+            stack.pop_back();
+
+            if (glm::any(glm::lessThan(node.hi, lo)) || glm::any(glm::greaterThan(node.lo, hi)))
+                continue;
+
+            if (node.count == 0)
+            {
+                stack.emplace_back(node.first);
+                stack.emplace_back(index + 1);
+                continue;
+            }
+
+            for (auto i = node.first; i < node.first + node.count; ++i)
+            {
+                for (auto corner = 0; corner < 3; ++corner)
+                {
+                    auto const  vertex   = m_triangles[i][corner];
+                    auto const& position = m_positions[vertex];
+                    if (glm::all(glm::greaterThanEqual(position, lo)) && glm::all(glm::lessThanEqual(position, hi)))
+                        vertices.emplace_back(vertex);
+                }
+            }
+        }
+
+        std::ranges::sort(vertices);
+
+        std::vector<glm::uvec2> result;
+        for (auto const vertex : vertices)
+        {
+            if (!result.empty() && vertex < result.back().x + result.back().y)
+                continue;
+
+            if (!result.empty() && vertex <= result.back().x + result.back().y + s_runGap)
+                result.back().y = vertex + 1 - result.back().x;
+            else
+                result.emplace_back(vertex, 1);
+        }
+
+        return result;
+    }
+} // namespace com::scene
@@ -0,0 +1,109 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace com::scene
+{
+    /// A ray.
+    struct Ray final
+    {
+        glm::vec3 origin;    ///< The origin.
+        glm::vec3 direction; ///< The direction, which need not be normalised.
+    };
+
+    /// Where a ray hits a triangle.
+    struct RayHit final
+    {
+        float     t        = 0.0f; ///< The distance along the ray, in multiples of its direction.
+        uint32_t  triangle = 0;    ///< The index of the triangle in the mesh.
+        glm::vec2 barycentric;     ///< The weights of the triangle's second and third vertices at the hit.
+        glm::vec3 normal;          ///< The triangle's unit geometric normal, following its winding.
+    };
+
+    /// A node of a flattened BVH. An interior node's left child immediately follows it, so only its right child is stored.
+    struct BvhNode final
+    {
+        glm::vec3 lo;        ///< The minimum corner of the node's bounds.
+        uint32_t  first = 0; ///< The first triangle of a leaf, or the right child of an interior node.
+        glm::vec3 hi;        ///< The maximum corner of the node's bounds.
+        uint32_t  count = 0; ///< The number of triangles in a leaf, or zero for an interior node.
+    };
+
+    /// A bounding volume hierarchy over a mesh's triangles, for picking on the CPU.
+    ///
+    /// The tree is built with a binned surface-area heuristic, with large subtrees built in parallel, and is flattened in
+    /// depth-first order so that a traversal mostly walks forwards through memory. The triangles are reordered to match the
+    /// leaves, which are tested four at a time. As a stroke moves vertices but never changes the topology, the tree is refit
+    /// to the new positions rather than rebuilt.
+    class Bvh final
+    {
+    public:
+        /// Constructor.
+        /// \param positions The vertex positions, which are copied.
+        /// \param indices Indices into the positions, three per triangle.
+        explicit Bvh(std::span<glm::vec3 const> const positions, std::span<uint32_t const> const indices);
+
+        /// Find the nearest triangle that a ray hits, from either side.
+        /// \param ray The ray.
+        /// \param tMax The furthest distance along the ray to consider.
+        /// \return The hit, if there is one; nothing otherwise.
+        [[nodiscard]] auto intersect(Ray const& ray, float const tMax = std::numeric_limits<float>::max()) const -> std::optional<RayHit>;
+
+        /// Accessor.
+        /// \return The nodes, with the root first.
+        [[nodiscard]] auto nodes() const -> std::vector<BvhNode> const&
+        {
+            return m_nodes;
+        }
+
+        /// Accessor.
+        /// \return The original index of each triangle, in leaf order.
+        [[nodiscard]] auto order() const -> std::vector<uint32_t> const&
+        {
+            return m_order;
+        }
+
+        /// Accessor.
+        /// \return The vertex positions that the tree was built or last refit with.
+        [[nodiscard]] auto positions() const -> std::vector<glm::vec3> const&
+        {
+            return m_positions;
+        }
+
+        /// Refit the tree to moved vertices. The topology must be unchanged.
+        /// \param runs The runs of vertices that may have moved, as the first and the count of each.
+        /// \param positions The new positions of the vertices in the runs, one run after another, which are copied.
+        void refit(std::span<glm::uvec2 const> const runs, std::span<glm::vec3 const> const positions);
+
+        /// Find the vertices of the triangles that lie within a box, e.g., those that strokes may have moved since the tree was
+        /// last refit. Nearby runs are merged, as reading a few vertices too many is cheaper than another copy.
+        /// \param lo The minimum corner of the box.
+        /// \param hi The maximum corner of the box.
+        /// \return The runs of vertices, as the first and the count of each, in order.
+        [[nodiscard]] auto vertexRuns(glm::vec3 const& lo, glm::vec3 const& hi) const -> std::vector<glm::uvec2>;
+
+        /// Accessor.
+        /// \return The vertex indices of each triangle, in leaf order.
+        [[nodiscard]] auto triangles() const -> std::vector<glm::uvec3> const&
+        {
+            return m_triangles;
+        }
+
+    private:
+        void intersectLeaf(BvhNode const& node, Ray const& ray, std::optional<RayHit>& hit, float& tMax) const;
+
+    private:
+        std::vector<glm::vec3>  m_positions;
+        std::vector<glm::uvec3> m_triangles;
+        std::vector<uint32_t>   m_order;
+        std::vector<BvhNode>    m_nodes;
+    };
+} // namespace com::scene
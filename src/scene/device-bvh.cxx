@@ -0,0 +1,69 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "scene/device-bvh.hxx"
+#include "rhi/context.hxx"
+
+#include <set>
+
+namespace com::scene
+{
+    static_assert(sizeof(BvhNode) == 2 * sizeof(glm::vec4), "The nodes are uploaded as they are, so must match PickNode.");
+
+    DeviceBvh::DeviceBvh(rhi::Context* context, rhi::Mesh const* mesh, Bvh const& bvh) : m_mesh(mesh)
+    {
+        auto const& nodes = bvh.nodes();
+
+        // A node's children are one level deeper; as children follow their parent, the depths are found in one sweep.
+        std::vector<uint32_t> depths(nodes.size(), 0);
+        uint32_t              levelCount = nodes.empty() ? 0 : 1;
+        for (auto index = 0u; index < nodes.size(); ++index)
+        {
+            if (nodes[index].count > 0)
+                continue;
+
+            depths[index + 1]          = depths[index] + 1;
+            depths[nodes[index].first] = depths[index] + 1;
+            levelCount                 = std::max(levelCount, depths[index] + 2);
+        }
+
+        // Counting sort of the nodes by level, deepest first.
+        m_levels.assign(levelCount, glm::uvec2(0));
+        for (auto const depth : depths)
+            ++m_levels[levelCount - 1 - depth].y;
+
+        for (auto level = 1u; level < levelCount; ++level)
+            m_levels[level].x = m_levels[level - 1].x + m_levels[level - 1].y;
+
+        std::vector<uint32_t> levelNodes(nodes.size());
+        std::vector<uint32_t> cursors(levelCount);
+        for (auto index = 0u; index < nodes.size(); ++index)
+        {
+            auto const level                                 = levelCount - 1 - depths[index];
+            levelNodes[m_levels[level].x + cursors[level]++] = index;
+        }
+
+        // The buffers are uploaded through the staging ring on the transfer queue and then read and refit on the compute queue.
+        std::set<uint32_t>    queueSet = { context->queueIndex(rhi::QueueIndex::eCompute), context->queueIndex(rhi::QueueIndex::eTransfer) };
+        std::vector<uint32_t> sharedQueues;
+        if (queueSet.size() > 1)
+            sharedQueues.assign(queueSet.begin(), queueSet.end());
+
+        auto const usage  = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eTransferDst;
+        auto const memory = vk::MemoryPropertyFlagBits::eDeviceLocal;
+
+        // An empty mesh still has buffers, so that their device addresses are valid; nothing is ever read from them.
+        auto const upload = [&]<typename T>(BufferType const type, std::vector<T> const& data)
+        {
+            m_buffers[type] = std::make_unique<rhi::Buffer>(context, std::max(sizeof(T) * data.size(), sizeof(T)), usage, memory, sharedQueues);
+            if (!data.empty())
+                m_buffers[type]->upload(data);
+        };
+
+        upload(BufferTypeNode, nodes);
+        upload(BufferTypeTriangle, bvh.triangles());
+        upload(BufferTypeOrder, bvh.order());
+        upload(BufferTypeLevelNode, levelNodes);
+    }
+} // namespace com::scene
@@ -0,0 +1,78 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include "rhi/mesh.hxx"
+#include "scene/bvh.hxx"
+
+namespace com::scene
+{
+    /// A copy of a model's BVH that is resident on the device, so that rays can be cast into it by compute shaders.
+    ///
+    /// The tree is uploaded once from a CPU BVH and then tracks the mesh's edit vertices on its own: strokes mark it as stale,
+    /// and the picker refits it level by level, from the deepest up, before it next casts rays into it.
+    class DeviceBvh final
+    {
+    public:
+        /// Specifies the type of tree buffer.
+        enum BufferType
+        {
+            BufferTypeNode,      ///< The nodes, laid out as BvhNode.
+            BufferTypeTriangle,  ///< The vertex indices of each triangle, in leaf order.
+            BufferTypeOrder,     ///< The original index of each triangle, in leaf order.
+            BufferTypeLevelNode, ///< The node indices, grouped by level from the deepest up.
+            BufferTypeCount      ///< The number of buffers.
+        };
+
+    public:
+        /// Constructor.
+        /// \param context The RHI context.
+        /// \param mesh The mesh that the tree was built over.
+        /// \param bvh The tree to upload.
+        explicit DeviceBvh(rhi::Context* context, rhi::Mesh const* mesh, Bvh const& bvh);
+
+        /// Accessor.
+        /// \param type The type of buffer.
+        /// \return A valid pointer.
+        [[nodiscard]] auto buffer(BufferType const type) const
+        {
+            return m_buffers[type].get();
+        }
+
+        /// Get the ranges of the level nodes that make up each level, from the deepest up.
+        /// \return The offset and count of each level.
+        [[nodiscard]] auto levels() const -> std::vector<glm::uvec2> const&
+        {
+            return m_levels;
+        }
+
+        /// Determines if strokes have moved the vertices since the tree was last refit.
+        /// \return true if the tree must be refit before it is traversed; false otherwise.
+        [[nodiscard]] auto isStale() const
+        {
+            return m_isStale;
+        }
+
+        /// Accessor.
+        /// \return A valid pointer.
+        [[nodiscard]] auto mesh() const
+        {
+            return m_mesh;
+        }
+
+        /// Set whether strokes have moved the vertices since the tree was last refit.
+        /// \param isStale true if the tree must be refit before it is traversed; false otherwise.
+        void setStale(bool const isStale)
+        {
+            m_isStale = isStale;
+        }
+
+    private:
+        rhi::Mesh const*                                          m_mesh = nullptr;
+        std::array<std::unique_ptr<rhi::Buffer>, BufferTypeCount> m_buffers;
+        std::vector<glm::uvec2>                                   m_levels;
+        bool                                                      m_isStale = false;
+    };
+} // namespace com::scene
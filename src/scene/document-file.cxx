@@ -0,0 +1,337 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "scene/document-file.hxx"
+#include "base/message.hxx"
+
+#include <QSaveFile>
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace com::scene
+{
+    static_assert(std::endian::native == std::endian::little, "Document files are written in the host's layout, which must be little-endian.");
+
+    [[nodiscard]] static constexpr auto makeFourCC(char const (&code)[5]) -> uint32_t
+    {
+        return static_cast<uint32_t>(code[0]) | (static_cast<uint32_t>(code[1]) << 8) | (static_cast<uint32_t>(code[2]) << 16) |
+               (static_cast<uint32_t>(code[3]) << 24);
+    }
+
+    /// Identifies a document file.
+    static constexpr uint32_t s_magic = makeFourCC("S3D ");
+
+    /// The major version, which changes when a file can no longer be read by an older build.
+    static constexpr uint16_t s_majorVersion = 1;
+
+    /// The minor version, which changes when chunks are added.
+    static constexpr uint16_t s_minorVersion = 1;
+
+    /// The largest write, in bytes, between progress reports.
+    static constexpr uint64_t s_writeSlice = 16 << 20;
+
+    /// The data of every chunk is compressed with qCompress.
+    static constexpr uint32_t s_flagCompressed = 1;
+
+    /// The streams of every model without multiresolution levels are in vertex cache and vertex fetch order.
+    static constexpr uint32_t s_flagOptimised = 2;
+
+    /// The alignment of each chunk's data, in bytes.
+    static constexpr uint64_t s_chunkAlignment = 64;
+
+    /// Specifies the type of a chunk.
+    enum ChunkType : uint32_t
+    {
+        ChunkTypeModel         = makeFourCC("MODL"), ///< A ModelChunk.
+        ChunkTypePositions     = makeFourCC("POSN"), ///< The vertex positions, as 3 floats each.
+        ChunkTypeIndices       = makeFourCC("INDX"), ///< The indices, as 32-bit unsigned integers.
+        ChunkTypeColours       = makeFourCC("COLR"), ///< The vertex colours, as packed RGBA8.
+        ChunkTypeMultires      = makeFourCC("MRES"), ///< A MultiresChunk.
+        ChunkTypeLevelColours  = makeFourCC("LCOL"), ///< The vertex colours of the sculpted level, as packed RGBA8.
+        ChunkTypeDisplacements = makeFourCC("DISP"), ///< The displacements of the levels above the base cage, as 3 floats each.
+    };
+
+    /// The start of a file.
+    struct FileHeader final
+    {
+        uint32_t magic;        ///< Must be s_magic.
+        uint16_t majorVersion; ///< The major version.
+        uint16_t minorVersion; ///< The minor version.
+        uint32_t chunkCount;   ///< The number of entries in the chunk table, which follows the header.
+        uint32_t flags;        ///< A combination of s_flag*; a file with unknown flags cannot be read.
+    };
+
+    /// An entry in the chunk table.
+    struct ChunkHeader final
+    {
+        uint32_t type;   ///< The type of chunk.
+        uint32_t model;  ///< The index of the model that the chunk belongs to.
+        uint64_t offset; ///< The offset of the data from the start of the file, in bytes.
+        uint64_t size;   ///< The size of the data, in bytes.
+    };
+
+    /// The per-model properties.
+    struct ModelChunk final
+    {
+        glm::mat4 transform;   ///< The model's transform.
+        glm::vec3 lo;          ///< The minimum corner of the bounds.
+        uint32_t  vertexCount; ///< The number of vertices.
+        glm::vec3 hi;          ///< The maximum corner of the bounds.
+        uint32_t  indexCount;  ///< The number of indices.
+    };
+
+    /// The multiresolution levels of a subdivided model.
+    struct MultiresChunk final
+    {
+        uint32_t levelCount; ///< The number of levels, including the base cage.
+        uint32_t level;      ///< The level that is sculpted.
+    };
+
+    [[nodiscard]] static auto alignChunk(uint64_t const offset)
+    {
+        return (offset + s_chunkAlignment - 1) & ~(s_chunkAlignment - 1);
+    }
+
+    DocumentFile::DocumentFile(QString const& path) : m_file(path)
+    {
+        m_isValid = read();
+
+        if (!m_isValid)
+            base::outputError(QString("Failed to read document file '%1'.").arg(path).toStdString());
+    }
+
+    DocumentFile::~DocumentFile()
+    {
+        if (m_data)
+            m_file.unmap(m_data);
+    }
+
+    auto DocumentFile::read() -> bool
+    {
+        if (!m_file.open(QIODevice::ReadOnly))
+            return false;
+
+        m_size = static_cast<uint64_t>(m_file.size());
+        if (m_size < sizeof(FileHeader))
+            return false;
+
+        m_data = m_file.map(0, m_file.size());
+        if (!m_data)
+            return false;
+
+        FileHeader header;
+        std::memcpy(&header, m_data, sizeof(FileHeader));
+
+        if (header.magic != s_magic || header.majorVersion != s_majorVersion || (header.flags & ~(s_flagCompressed | s_flagOptimised)) != 0)
+            return false;
+
+        if (header.chunkCount > (m_size - sizeof(FileHeader)) / sizeof(ChunkHeader))
+            return false;
+
+        m_isOptimised = (header.flags & s_flagOptimised) != 0;
+
+        // Gather each model's chunks. Every model has at least one chunk, which bounds the number of models.
+        std::vector<ModelChunk const*> properties;
+        std::span const                chunks(reinterpret_cast<ChunkHeader const*>(m_data + sizeof(FileHeader)), header.chunkCount);
+
+        for (auto const& chunk : chunks)
+        {
+            if (chunk.offset % s_chunkAlignment != 0 || chunk.offset > m_size || chunk.size > m_size - chunk.offset || chunk.model >= header.chunkCount)
+                return false;
+
+            if (chunk.model >= m_models.size())
+            {
+                m_models.resize(chunk.model + 1);
+                properties.resize(chunk.model + 1);
+            }
+
+            static constexpr std::array<uint32_t, 7> s_knownTypes = { ChunkTypeModel,    ChunkTypePositions,    ChunkTypeIndices,      ChunkTypeColours,
+                                                                      ChunkTypeMultires, ChunkTypeLevelColours, ChunkTypeDisplacements };
+            if (std::ranges::find(s_knownTypes, chunk.type) == s_knownTypes.end())
+                continue;
+
+            auto&        model = m_models[chunk.model];
+            uchar const* data  = m_data + chunk.offset;
+            auto         size  = chunk.size;
+
+            // Compressed chunks are inflated into memory owned by this object; otherwise the data is used in place.
+            if (header.flags & s_flagCompressed)
+            {
+                auto const& inflated = m_inflated.emplace_back(qUncompress(data, static_cast<qsizetype>(chunk.size)));
+                if (inflated.isEmpty() && chunk.size > 0)
+                    return false;
+
+                data = reinterpret_cast<uchar const*>(inflated.constData());
+                size = static_cast<uint64_t>(inflated.size());
+            }
+
+            switch (chunk.type)
+            {
+            case ChunkTypeModel:
+                if (size < sizeof(ModelChunk))
+                    return false;
+                properties[chunk.model] = reinterpret_cast<ModelChunk const*>(data);
+                break;
+
+            case ChunkTypePositions:
+                model.positions = { reinterpret_cast<glm::vec3 const*>(data), size / sizeof(glm::vec3) };
+                break;
+
+            case ChunkTypeIndices:
+                model.indices = { reinterpret_cast<uint32_t const*>(data), size / sizeof(uint32_t) };
+                break;
+
+            case ChunkTypeColours:
+                model.colours = { reinterpret_cast<uint32_t const*>(data), size / sizeof(uint32_t) };
+                break;
+
+            case ChunkTypeMultires:
+                if (size < sizeof(MultiresChunk))
+                    return false;
+                model.levelCount = reinterpret_cast<MultiresChunk const*>(data)->levelCount;
+                model.level      = reinterpret_cast<MultiresChunk const*>(data)->level;
+                break;
+
+            case ChunkTypeLevelColours:
+                model.levelColours = { reinterpret_cast<uint32_t const*>(data), size / sizeof(uint32_t) };
+                break;
+
+            case ChunkTypeDisplacements:
+                model.displacements = { reinterpret_cast<glm::vec3 const*>(data), size / sizeof(glm::vec3) };
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < m_models.size(); ++i)
+        {
+            auto const* modelChunk = properties[i];
+            auto&       model      = m_models[i];
+
+            if (!modelChunk || modelChunk->vertexCount == 0 || model.positions.size() != modelChunk->vertexCount ||
+                model.colours.size() != modelChunk->vertexCount || model.indices.size() != modelChunk->indexCount || model.indices.size() % 3 != 0)
+            {
+                return false;
+            }
+
+            // The levels are rebuilt from the displacements, whose sizes are checked as they are; a level must exist to be sculpted.
+            if (model.levelCount == 0 || model.level >= model.levelCount || (model.levelCount > 1 && model.displacements.empty()))
+                return false;
+
+            // The indices are uploaded as they are, and an index past the vertices would have the GPU read beyond them.
+            if (!model.indices.empty() && std::ranges::max(model.indices) >= modelChunk->vertexCount)
+                return false;
+
+            model.transform = modelChunk->transform;
+            model.bounds    = AABB(modelChunk->lo, modelChunk->hi);
+        }
+
+        return true;
+    }
+
+    auto DocumentFile::write(QString const&                  path,
+                             std::vector<ModelData> const&   models,
+                             bool const                      compress,
+                             bool const                      isOptimised,
+                             std::function<void(int)> const& progress) -> bool
+    {
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly))
+            return false;
+
+        // The data of each chunk follows the table, so the offsets are known before anything is written.
+        std::vector<ModelChunk>                 modelChunks(models.size());
+        std::vector<MultiresChunk>              multiresChunks(models.size());
+        std::vector<ChunkHeader>                chunks;
+        std::vector<std::span<std::byte const>> payloads;
+        std::vector<QByteArray>                 compressed;
+
+        // Subdivided models have three more chunks.
+        auto const subdivided = static_cast<size_t>(std::ranges::count_if(models, [](auto const& model) { return model.levelCount > 1; }));
+        auto const chunkCount = 4 * models.size() + 3 * subdivided;
+        uint64_t   offset     = alignChunk(sizeof(FileHeader) + chunkCount * sizeof(ChunkHeader));
+
+        compressed.reserve(chunkCount);
+
+        auto const addChunk = [&](uint32_t const type, uint32_t const model, std::span<std::byte const> data)
+        {
+            if (compress)
+            {
+                auto const& deflated = compressed.emplace_back(qCompress(reinterpret_cast<uchar const*>(data.data()), static_cast<qsizetype>(data.size())));
+                data                 = std::as_bytes(std::span(deflated.constData(), static_cast<size_t>(deflated.size())));
+            }
+
+            chunks.push_back({ type, model, offset, data.size() });
+            payloads.emplace_back(data);
+            offset = alignChunk(offset + data.size());
+        };
+
+        for (uint32_t i = 0; i < models.size(); ++i)
+        {
+            auto const& model = models[i];
+
+            modelChunks[i] = { model.transform,
+                               model.bounds.getMin(),
+                               static_cast<uint32_t>(model.positions.size()),
+                               model.bounds.getMax(),
+                               static_cast<uint32_t>(model.indices.size()) };
+
+            addChunk(ChunkTypeModel, i, std::as_bytes(std::span(&modelChunks[i], 1)));
+            addChunk(ChunkTypePositions, i, std::as_bytes(model.positions));
+            addChunk(ChunkTypeIndices, i, std::as_bytes(model.indices));
+            addChunk(ChunkTypeColours, i, std::as_bytes(model.colours));
+
+            if (model.levelCount <= 1)
+                continue;
+
+            multiresChunks[i] = { model.levelCount, model.level };
+
+            addChunk(ChunkTypeMultires, i, std::as_bytes(std::span(&multiresChunks[i], 1)));
+            addChunk(ChunkTypeLevelColours, i, std::as_bytes(model.levelColours));
+            addChunk(ChunkTypeDisplacements, i, std::as_bytes(model.displacements));
+        }
+
+        auto const       flags    = (compress ? s_flagCompressed : 0) | (isOptimised ? s_flagOptimised : 0);
+        FileHeader const header   = { s_magic, s_majorVersion, s_minorVersion, static_cast<uint32_t>(chunks.size()), flags };
+        uint64_t         position = 0;
+
+        // Large chunks are written in slices, so that progress is reported smoothly.
+        auto const writeBytes = [&](void const* data, uint64_t const size)
+        {
+            auto const* bytes = static_cast<char const*>(data);
+
+            for (uint64_t written = 0; written < size;)
+            {
+                auto const slice = std::min(size - written, s_writeSlice);
+                if (file.write(bytes + written, static_cast<qint64>(slice)) != static_cast<qint64>(slice))
+                    return false;
+
+                written  += slice;
+                position += slice;
+
+                if (progress)
+                    progress(static_cast<int>(100 * position / offset));
+            }
+
+            return true;
+        };
+
+        auto isWritten = writeBytes(&header, sizeof(FileHeader)) && writeBytes(chunks.data(), chunks.size() * sizeof(ChunkHeader));
+
+        std::array<char, s_chunkAlignment> const padding = {};
+        for (size_t i = 0; i < chunks.size() && isWritten; ++i)
+            isWritten = writeBytes(padding.data(), chunks[i].offset - position) && writeBytes(payloads[i].data(), payloads[i].size());
+
+        if (!isWritten)
+        {
+            file.cancelWriting();
+            return false;
+        }
+
+        return file.commit();
+    }
+} // namespace com::scene
@@ -0,0 +1,101 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include <QFile>
+#include <functional>
+#include <glm/glm-aabb.hpp>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+namespace com::scene
+{
+    /// A model as it is stored in a document file. The streams refer to memory owned elsewhere, e.g., a mapped file or
+    /// readback buffers, and are in the layout that the GPU consumes.
+    struct ModelData final
+    {
+        glm::mat4                  transform; ///< The model's transform.
+        AABB                       bounds;    ///< The bounds of the positions.
+        std::span<glm::vec3 const> positions; ///< The vertex positions.
+        std::span<uint32_t const>  indices;   ///< Indices into the positions, three per triangle.
+        std::span<uint32_t const>  colours;   ///< The colour of each vertex.
+
+        uint32_t                   levelCount = 1; ///< The number of multiresolution levels, including the base cage that the streams hold.
+        uint32_t                   level      = 0; ///< The level that is sculpted, where zero is the base cage.
+        std::span<uint32_t const>  levelColours;   ///< The colour of each vertex of the sculpted level, if it is above the base cage.
+        std::span<glm::vec3 const> displacements;  ///< The displacements of each level above the base cage, one level after another.
+    };
+
+    /// A native document file, i.e., a .s3d file, mapped into memory for reading.
+    ///
+    /// A file is a header, followed by a table of chunks, followed by the chunks' data. Each chunk's data starts on a
+    /// 64-byte boundary and is a stream in the little-endian layout that the GPU consumes, so opening a file validates the
+    /// table, and makes one pass over the indices to check that they are in range; the streams are then uploaded straight
+    /// from the mapping. Chunks of an unknown type are skipped, so files written by a newer minor version remain readable.
+    /// Files may optionally be written with every chunk compressed, in which case the chunks are inflated when the file is
+    /// read. The header records whether the streams were in vertex cache order when they were written, so that opening a
+    /// file whose streams weren't optimises them once, and opening one whose streams were reads them in place.
+    ///
+    /// A subdivided model is stored as its base cage, with the displacements of the levels above it and the colours of the
+    /// level that is sculpted, from which the levels are rebuilt when it is opened; a reader that predates them opens the cage.
+    class DocumentFile final
+    {
+    public:
+        /// Constructor. Map a file and validate its chunk table.
+        /// \param path The path of the file.
+        explicit DocumentFile(QString const& path);
+
+        /// Destructor.
+        ~DocumentFile();
+
+        /// Determines if the file was mapped and is well formed.
+        /// \return true if the file is valid; false otherwise.
+        [[nodiscard]] auto isValid() const
+        {
+            return m_isValid;
+        }
+
+        /// Determines if the models were in vertex cache and vertex fetch order when they were written, apart from those with
+        /// multiresolution levels, which are never reordered.
+        /// \return true if the streams needn't be optimised; false otherwise.
+        [[nodiscard]] auto isOptimised() const
+        {
+            return m_isOptimised;
+        }
+
+        /// Get the models in the file, whose streams refer to the mapping and so are valid for the lifetime of this object.
+        /// \return A collection of models.
+        [[nodiscard]] auto models() const -> std::vector<ModelData> const&
+        {
+            return m_models;
+        }
+
+        /// Write a document file. The file is replaced atomically, so a failed write leaves an existing file intact.
+        /// \param path The path of the file.
+        /// \param models The models to write.
+        /// \param compress true to compress the chunks; false otherwise.
+        /// \param isOptimised true if the models without multiresolution levels are in vertex cache and vertex fetch order.
+        /// \param progress Called with the percentage written, if set.
+        /// \return true if the file was written; false otherwise.
+        [[nodiscard]] static auto write(QString const&                  path,
+                                        std::vector<ModelData> const&   models,
+                                        bool const                      compress    = false,
+                                        bool const                      isOptimised = false,
+                                        std::function<void(int)> const& progress    = {}) -> bool;
+
+    private:
+        [[nodiscard]] auto read() -> bool;
+
+    private:
+        QFile                   m_file;
+        uchar*                  m_data = nullptr;
+        uint64_t                m_size = 0;
+        std::vector<ModelData>  m_models;
+        std::vector<QByteArray> m_inflated;
+        bool                    m_isOptimised = false;
+        bool                    m_isValid     = false;
+    };
+} // namespace com::scene
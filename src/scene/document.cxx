@@ -3,8 +3,12 @@
 //
 
 #include "scene/document.hxx"
+#include "base/message.hxx"
 #include "base/preferences.hxx"
+#include "scene/document-file.hxx"
+#include "rhi/mesh-optimiser.hxx"
 #include "rhi/per-frame-data.hxx"
+#include "rhi/primitive-generator.hxx"
 #include "rhi/primitive.hxx"
 #include "rhi/shaders/uniforms.hxx"
 #include "rhi/utilities.hxx"
@@ -24,12 +28,33 @@ namespace com::scene
         ShaderKindCount
     };
 
-    Document::Document(rhi::Context* context, vk::Extent2D const& extent, QObject* parent) : QObject(parent), m_context(context), m_extent(extent)
+    /// The mesh buffers that are saved, in the order they are read back.
+    static constexpr std::array<rhi::Mesh::BufferType, 3> s_savedBuffers = { rhi::Mesh::BufferTypeEditVertex,
+                                                                              rhi::Mesh::BufferTypeIndex,
+                                                                              rhi::Mesh::BufferTypeColour };
+
+    /// The number of rays that sample the brush's footprint when the cursor is placed without a hit-test pass.
+    static constexpr uint32_t s_footprintRays = 32;
+
+    [[nodiscard]] static auto makeDefaultModels(rhi::Context* context)
     {
         auto const radius      = base::Preferences::read(base::PreferenceType::PrimitiveRadius).toFloat();
         auto const minPolygons = base::Preferences::read(base::PreferenceType::MinimumPrimitivePolygonCount).toUInt();
-        m_models.emplace_back(std::make_unique<Model>(rhi::makeSphere(m_context, { 0.0f, 0.0f, 0.0f }, radius, minPolygons)));
 
+        std::vector<std::unique_ptr<Model>> models;
+        models.emplace_back(std::make_unique<Model>(rhi::generateSphere(context, { 0.0f, 0.0f, 0.0f }, radius, minPolygons)));
+
+        return models;
+    }
+
+    Document::Document(rhi::Context* context, vk::Extent2D const& extent, QObject* parent)
+        : Document(context, extent, makeDefaultModels(context), parent)
+    {
+    }
+
+    Document::Document(rhi::Context* context, vk::Extent2D const& extent, std::vector<std::unique_ptr<Model>> models, QObject* parent)
+        : QObject(parent), m_context(context), m_extent(extent), m_models(std::move(models))
+    {
         auto const cursorVertexCount = base::Preferences::read(base::PreferenceType::CursorVertexCount).toUInt();
         m_cursor                     = std::make_unique<Model>(rhi::makeCursor(m_context, cursorVertexCount));
 
@@ -40,14 +65,51 @@ namespace com::scene
         m_pipelines.resize(PipelineIndexCount);
         m_shaders.resize(ShaderKindCount);
 
+        m_brushEngine = std::make_unique<BrushEngine>(m_context);
+
+        m_drawList = std::make_unique<DrawList>(m_context);
+        buildDrawLists();
+
+        m_picker = std::make_unique<Picker>(m_context);
+
+        m_hitQueries = std::make_unique<rhi::HitQueries>(m_context,
+                                                         [this](std::optional<rhi::MouseHit> const& hit)
+                                                         {
+                                                             m_hit      = hit;
+                                                             m_isHitNew = true;
+                                                         });
+
+        auto const typeInfo = vk::SemaphoreTypeCreateInfo(vk::SemaphoreType::eTimeline, m_saveValue);
+        m_saveSemaphore     = m_context->device()->logicalDevice().createSemaphore(vk::SemaphoreCreateInfo({}, &typeInfo));
+        m_saveCommandPool   = std::make_unique<rhi::CommandPool>(m_context->device(), m_context->queueIndex(rhi::QueueIndex::eTransfer));
+
+        for (auto& readback : m_topologyReadbacks)
+            readback.commandPool = std::make_unique<rhi::CommandPool>(m_context->device(), m_context->queueIndex(rhi::QueueIndex::eTransfer));
+
         resize(extent);
     }
 
     Document::~Document()
     {
+        // The file must be complete before the document goes, and frames in flight may still reference its resources.
+        waitForSave();
+        m_context->waitForIdle();
+
+        m_context->device()->logicalDevice().destroySemaphore(m_saveSemaphore);
+        m_saveCommandPool.reset();
+
+        for (auto& readback : m_topologyReadbacks)
+            readback.commandPool.reset();
+
+        m_brushEngine.reset();
+        m_picker.reset();
+
         destroyHitTestPipeline();
         destroyModelPipeline();
         destroyCursorPipeline();
+
+        m_navigationDrawList.reset();
+        m_drawList.reset();
     }
 
     auto Document::bounds() const -> AABB
@@ -60,6 +122,56 @@ namespace com::scene
         return result;
     }
 
+    void Document::cull(Camera const* camera)
+    {
+        adaptTopology();
+
+        // Subdivided models are drawn at a lower level while the camera moves, and at the sculpted level once it stops.
+        auto const mode = camera->mode();
+        m_isNavigating  = m_navigationDrawList && (mode == CameraMode::Orbit || mode == CameraMode::Dolly || mode == CameraMode::Truck);
+
+        // A new hit is applied by this frame's stroke, which the draw waits on, so the meshlets it can reach are refit now.
+        if (mode == CameraMode::Pick && m_hit && m_isHitNew)
+        {
+            auto const from   = m_lastBrushPoint.value_or(m_hit->point);
+            auto const centre = 0.5f * (from + m_hit->point);
+            auto const radius = 0.5f * glm::distance(from, m_hit->point) + base::Preferences::read(base::PreferenceType::BrushRadius).toFloat();
+
+            m_drawList->refit(centre, radius);
+            if (m_navigationDrawList)
+                m_navigationDrawList->refit(centre, radius);
+        }
+
+        if (drawList()->cull(camera, m_context->frameData()->commandBuffer()))
+            m_brushEngine->addFrameRead();
+    }
+
+    auto Document::multiresLevel() const -> uint32_t
+    {
+        auto result = 0u;
+
+        for (auto const& model : m_models)
+        {
+            if (auto const* multires = model->multires(); multires)
+                result = std::max(result, multires->level());
+        }
+
+        return result;
+    }
+
+    auto Document::multiresLevelCount() const -> uint32_t
+    {
+        auto result = 1u;
+
+        for (auto const& model : m_models)
+        {
+            if (auto const* multires = model->multires(); multires)
+                result = std::max(result, multires->levelCount());
+        }
+
+        return result;
+    }
+
     auto Document::name() -> QString
     {
         if (!m_path.isEmpty())
@@ -71,76 +183,759 @@ namespace com::scene
         return tr("Untitled");
     }
 
-    void Document::render(Camera const* camera, vk::CommandBuffer const& commandBuffer)
+    auto Document::pick(Ray const& ray) -> std::optional<rhi::MouseHit>
     {
-        auto index = PipelineIndexModel;
+        updateBvhs();
 
-        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipelines[index]);
-        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayouts[index], 0, { m_descriptorSets[index] }, nullptr);
+        std::optional<rhi::MouseHit> result;
+        auto                         tMax = std::numeric_limits<float>::max();
 
         for (auto const& model : m_models)
         {
-            uploadUniforms(camera, model->transform(), index);
-            model->render(commandBuffer);
+            auto const* bvh = model->bvh();
+            if (!bvh)
+                continue;
+
+            // The ray is taken into the model's space rather than the tree out of it. As the direction is not renormalised,
+            // distances along the ray are the same in either space and so compare across models.
+            auto const inverse  = glm::inverse(model->transform());
+            auto const localRay = Ray{ glm::vec3(inverse * glm::vec4(ray.origin, 1.0f)), glm::vec3(inverse * glm::vec4(ray.direction, 0.0f)) };
+            auto const hit      = bvh->intersect(localRay, tMax);
+            if (!hit)
+                continue;
+
+            auto normal = glm::normalize(glm::transpose(glm::mat3(inverse)) * hit->normal);
+            if (glm::dot(normal, ray.direction) > 0.0f)
+                normal = -normal;
+
+            tMax   = hit->t;
+            result = rhi::MouseHit{ ray.origin + hit->t * ray.direction, normal };
+        }
+
+        return result;
+    }
+
+    auto Document::pickOnDevice(std::span<Ray const> const rays) -> std::vector<std::optional<PickHit>>
+    {
+        auto const isUploaded = std::ranges::all_of(m_models,
+                                                    [](auto const& model)
+                                                    { return !model->mesh() || (model->deviceBvh() && model->deviceBvh()->mesh() == model->mesh()); });
+
+        if (!isUploaded)
+        {
+            updateBvhs();
+
+            for (auto const& model : m_models)
+            {
+                if (model->bvh() && (!model->deviceBvh() || model->deviceBvh()->mesh() != model->mesh()))
+                    model->setDeviceBvh(std::make_unique<DeviceBvh>(m_context, model->mesh(), *model->bvh()));
+            }
         }
 
+        return m_picker->pick(m_models, rays);
+    }
+
+    auto Document::placeCursor(Camera const* camera, QPoint const& point) -> bool
+    {
+        // The ray runs from the eye through the point on the far plane, in the same normalised device coordinates as a hit.
+        auto const x   = (2.0f * static_cast<float>(point.x()) / static_cast<float>(m_extent.width)) - 1.0f;
+        auto const y   = (2.0f * static_cast<float>(point.y()) / static_cast<float>(m_extent.height)) - 1.0f;
+        auto const farPoint = glm::inverse(camera->viewProjection()) * glm::vec4(x, y, 1.0f, 1.0f);
+
+        m_hit      = pick(Ray{ camera->eye(), glm::vec3(farPoint) / farPoint.w - camera->eye() });
+        m_isHitNew = true;
+
+        if (!m_hit)
+            return false;
+
+        // There is no hit-test tile to reduce the brush's footprint from, so it is sampled by rays cast on the device instead.
+        auto const radius = base::Preferences::read(base::PreferenceType::BrushRadius).toFloat();
+        m_hit->footprint  = sampleFootprint(m_hit->point, m_hit->normal, radius);
+
+        return true;
+    }
+
+    void Document::render(vk::CommandBuffer const& commandBuffer)
+    {
+        auto index = PipelineIndexModel;
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipelines[index]);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayouts[index], 0, { descriptorSet(index) }, nullptr);
+
+        drawList()->render(commandBuffer, m_pipelineLayouts[index]);
+
         if (m_hit)
         {
             index = PipelineIndexCursor;
 
             commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipelines[index]);
-            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayouts[index], 0, { m_descriptorSets[index] }, nullptr);
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayouts[index], 0, { descriptorSet(index) }, nullptr);
 
-            uploadUniforms(camera, { 1.0f }, index);
+            pushModelTransform(commandBuffer, glm::mat4(1.0f), index);
             m_cursor->render(commandBuffer);
         }
     }
 
-    auto Document::save(QString const) -> bool
+    auto Document::open(rhi::Context* context, vk::Extent2D const& extent, QString const& path, QObject* parent) -> std::unique_ptr<Document>
+    {
+        DocumentFile file(path);
+        if (!file.isValid())
+            return {};
+
+        // The streams are copied from the mapping into the staging ring as they are, so the file can be unmapped as soon as
+        // the meshes exist. Files whose streams were saved in the order that edits left them are optimised for the vertex cache
+        // and vertex fetch as they are opened, from host copies; the document then saves them in that order, so opening it
+        // again needn't.
+        std::vector<std::unique_ptr<Model>> models;
+
+        // The uploads into the meshes that have been made must complete before the meshes are released.
+        auto const fail = [&]() -> std::unique_ptr<Document>
+        {
+            base::outputError(QString("The multiresolution levels in document file '%1' are incomplete.").arg(path).toStdString());
+            context->stagingRing()->submit();
+            context->waitForIdle();
+            return {};
+        };
+
+        for (auto const& data : file.models())
+        {
+            // The levels of a subdivided model follow the order of its base cage's vertices, so the cage is kept as it is.
+            if (!file.isOptimised() && data.levelCount <= 1)
+            {
+                std::vector<glm::vec3> positions(data.positions.begin(), data.positions.end());
+                std::vector<uint32_t>  indices(data.indices.begin(), data.indices.end());
+                std::vector<uint32_t>  colours(data.colours.begin(), data.colours.end());
+                rhi::optimiseMesh(indices, positions, colours);
+
+                auto mesh = std::make_unique<rhi::Mesh>(context, positions, indices, colours, data.bounds);
+                models.emplace_back(std::make_unique<Model>(std::move(mesh), data.transform));
+                continue;
+            }
+
+            auto  mesh  = std::make_unique<rhi::Mesh>(context, data.positions, data.indices, data.colours, data.bounds);
+            auto& model = models.emplace_back(std::make_unique<Model>(std::move(mesh), data.transform));
+            if (data.levelCount <= 1)
+                continue;
+
+            // The levels are subdivided from the cage's indices on the CPU, as they were when they were made, and take their
+            // displacements from the file. Their sizes are only known as they are built, so they are checked against it then.
+            auto                  multires = std::make_unique<Multires>(context, model->mesh());
+            std::vector<uint32_t> indices(data.indices.begin(), data.indices.end());
+            size_t                offset = 0;
+
+            for (auto level = 1u; level < data.levelCount; ++level)
+            {
+                indices                = multires->subdivide(indices);
+                auto const vertexCount = multires->mesh(level)->vertexCount();
+                if (vertexCount > data.displacements.size() - offset)
+                    return fail();
+
+                multires->buffer(level, Multires::BufferTypeDisplacement)->upload(data.displacements.subspan(offset, vertexCount));
+                multires->setCleared(level);
+                offset += vertexCount;
+            }
+
+            auto const* sculpted = multires->mesh(data.level);
+            if (offset != data.displacements.size() || (data.level > 0 && data.levelColours.size() != sculpted->vertexCount()))
+                return fail();
+
+            model->setMultires(std::move(multires));
+        }
+
+        auto document           = std::unique_ptr<Document>(new Document(context, extent, std::move(models), parent));
+        document->m_path        = path;
+        document->m_isOptimised = true;
+
+        // The levels above each cage are rebuilt from their displacements, with the cage sculpted so that none is stored over.
+        document->m_brushEngine->propagate(document->m_models);
+
+        // The sculpted level's colours are then restored over those it took from the level below, once the rebuild has written them.
+        auto* stagingRing = context->stagingRing();
+        stagingRing->addWaitSemaphore(document->m_brushEngine->waitSemaphore(vk::PipelineStageFlagBits::eTransfer));
+
+        for (size_t i = 0; i < file.models().size(); ++i)
+        {
+            auto const& data     = file.models()[i];
+            auto*       multires = document->m_models[i]->multires();
+            if (!multires)
+                continue;
+
+            multires->setLevel(data.level);
+            if (data.level > 0)
+                multires->mesh(data.level)->buffer(rhi::Mesh::BufferTypeColour)->upload(data.levelColours);
+        }
+
+        stagingRing->submit();
+        document->buildDrawLists();
+
+        return document;
+    }
+
+    auto Document::sampleFootprint(glm::vec3 const& point, glm::vec3 const& normal, float const radius) -> rhi::Footprint
     {
+        // Any vector that is not parallel to the normal gives the axes of a disc around the hit.
+        auto const side      = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        auto const tangent   = glm::normalize(glm::cross(normal, side));
+        auto const bitangent = glm::cross(normal, tangent);
+
+        // The rays are spread evenly over the disc, and start a radius above it so that they find the surface either side.
+        std::vector<Ray> rays;
+        for (auto i = 0u; i < s_footprintRays; ++i)
+        {
+            auto const angle    = 2.39996f * static_cast<float>(i);
+            auto const distance = radius * std::sqrt((static_cast<float>(i) + 0.5f) / static_cast<float>(s_footprintRays));
+            auto const offset   = distance * (std::cos(angle) * tangent + std::sin(angle) * bitangent);
+
+            rays.push_back(Ray{ point + offset + radius * normal, -normal });
+        }
+
+        // Only the surface within reach of the brush is averaged, as the rays may carry on through the model.
+        glm::vec3 normalSum(0.0f);
+        glm::vec3 centreSum(0.0f);
+        auto      count = 0u;
+
+        for (auto const& hit : pickOnDevice(rays))
+        {
+            if (!hit || glm::distance(hit->point, point) > 2.0f * radius)
+                continue;
+
+            normalSum += hit->normal;
+            centreSum += hit->point;
+            ++count;
+        }
+
+        rhi::Footprint footprint;
+        if (count == 0 || glm::dot(normalSum, normalSum) == 0.0f)
+            return footprint;
+
+        footprint.normal     = glm::normalize(normalSum);
+        footprint.centre     = centreSum / static_cast<float>(count);
+        footprint.plane      = glm::vec4(footprint.normal, -glm::dot(footprint.normal, footprint.centre));
+        footprint.pixelCount = count;
+
+        return footprint;
+    }
+
+    auto Document::save(QString const path) -> bool
+    {
+        auto const target = path.isEmpty() ? m_path : path;
+
+        // An untitled document has nowhere to be saved until it is given a path.
+        if (target.isEmpty() || (target == m_path && !m_isModified))
+            return true;
+
+        // Only one save may be in flight, as its snapshot and semaphore are reused.
+        waitForSave();
+
+        // A stroke in progress has only been applied to the sculpted level, so it is propagated through the others first.
+        if (m_lastBrushPoint)
+            m_brushEngine->propagate(m_models);
+
+        m_saveReadbacks     = snapshot();
+        auto const compress = base::Preferences::read(base::PreferenceType::CompressDocuments).toBool();
+
+        // The streams are filled in from the snapshot once it has arrived.
+        std::vector<ModelData> models;
+        for (auto const& model : m_models)
+        {
+            if (!model->mesh())
+                continue;
+
+            auto& data     = models.emplace_back();
+            data.transform = model->transform();
+
+            if (auto const* multires = model->multires(); multires)
+            {
+                data.levelCount = multires->levelCount();
+                data.level      = multires->level();
+            }
+        }
+
+        // The document takes the new path now, so that edits made while the file is written mark it as modified again.
+        auto const previousPath = std::exchange(m_path, target);
+        m_isModified            = false;
+        m_isSaved               = false;
+
+        m_saveThread = std::thread(
+            [this, value = m_saveValue, target, previousPath, compress, isOptimised = m_isOptimised, models = std::move(models)]() mutable
+            {
+                m_context->waitForSemaphore(m_saveSemaphore, value);
+
+                // The streams are written straight from the readbacks.
+                auto readback = m_saveReadbacks.begin();
+
+                auto const next = [&readback]()
+                {
+                    auto const* buffer = (readback++)->get();
+                    buffer->invalidate();
+                    return buffer;
+                };
+
+                for (size_t i = 0; i < models.size(); ++i)
+                {
+                    auto const* positions = next();
+                    auto const* indices   = next();
+                    auto const* colours   = next();
+
+                    auto& data     = models[i];
+                    data.positions = std::span(static_cast<glm::vec3 const*>(positions->data()), positions->size() / sizeof(glm::vec3));
+                    data.indices   = std::span(static_cast<uint32_t const*>(indices->data()), indices->size() / sizeof(uint32_t));
+                    data.colours   = std::span(static_cast<uint32_t const*>(colours->data()), colours->size() / sizeof(uint32_t));
+
+                    // Strokes move the vertices, so the bounds are those of the edited positions.
+                    for (auto const& point : data.positions)
+                        data.bounds.extend(point);
+
+                    if (data.levelCount <= 1)
+                        continue;
+
+                    // The sculpted level's colours, which are empty for the base cage, then each level's displacements in one run.
+                    auto const* levelColours  = next();
+                    auto const* displacements = next();
+                    if (data.level > 0)
+                        data.levelColours = std::span(static_cast<uint32_t const*>(levelColours->data()), levelColours->size() / sizeof(uint32_t));
+
+                    data.displacements = std::span(static_cast<glm::vec3 const*>(displacements->data()), displacements->size() / sizeof(glm::vec3));
+                }
+
+                // Events posted to the document are discarded if it is destroyed, so the slots never see a dangling document.
+                auto const progress  = [this](int percent) { QMetaObject::invokeMethod(this, [this, percent]() { emit saveProgress(percent); }); };
+                auto const isSuccess = DocumentFile::write(target, models, compress, isOptimised, progress);
+
+                m_isSaved = true;
+
+                QMetaObject::invokeMethod(this,
+                                          [this, isSuccess, target, previousPath]()
+                                          {
+                                              // The snapshot is released on this thread, unless a later save has since replaced it.
+                                              if (m_isSaved)
+                                                  m_saveReadbacks.clear();
+
+                                              // Restore the previous path, unless another save has taken over since.
+                                              if (!isSuccess && m_path == target)
+                                              {
+                                                  m_path       = previousPath;
+                                                  m_isModified = true;
+                                              }
+
+                                              emit saveFinished(isSuccess);
+                                          });
+            });
+
         return true;
     }
 
+    void Document::setMultiresLevel(uint32_t const level)
+    {
+        // The draw lists keep their previous buffers until the frames in flight have drawn them, and the brush keeps the grids
+        // until the strokes in flight have finished with them, so nothing waits here.
+        for (auto const& model : m_models)
+        {
+            auto* multires = model->multires();
+            if (!multires)
+                continue;
+
+            multires->setLevel(level);
+
+            // The grid and both hierarchies are rebuilt over the level when next needed.
+            m_brushEngine->retire(model->setBrushGrid(nullptr));
+            model->setBvh(nullptr);
+            model->setDeviceBvh(nullptr);
+        }
+
+        ++m_geometryRevision;
+        buildDrawLists();
+    }
+
+    void Document::subdivide()
+    {
+        // Levels are added above the highest, so that is the level whose indices are read back.
+        for (auto const& model : m_models)
+        {
+            if (auto* multires = model->multires(); multires)
+                multires->setLevel(multires->levelCount() - 1);
+        }
+
+        static constexpr std::array<rhi::Mesh::BufferType, 1> s_indexBuffers = { rhi::Mesh::BufferTypeIndex };
+        auto const                                            readbacks      = readBack(s_indexBuffers);
+
+        // The levels are built on the CPU, so the indices must have arrived.
+        m_context->waitForSemaphore(m_saveSemaphore, m_saveValue);
+
+        auto readback = readbacks.begin();
+        for (auto const& model : m_models)
+        {
+            if (!model->mesh())
+                continue;
+
+            auto const* indexBuffer = (readback++)->get();
+            indexBuffer->invalidate();
+            auto const indices = std::span(static_cast<uint32_t const*>(indexBuffer->data()), indexBuffer->size() / sizeof(uint32_t));
+
+            if (!model->multires())
+                model->setMultires(std::make_unique<Multires>(m_context, model->mesh()));
+
+            // The levels are built over a fixed topology.
+            model->setDynamicTopology(nullptr);
+            model->multires()->subdivide(indices);
+
+            m_brushEngine->retire(model->setBrushGrid(nullptr));
+            model->setBvh(nullptr);
+            model->setDeviceBvh(nullptr);
+        }
+
+        // The new levels are interpolated from the highest of the old ones before they are sculpted.
+        m_brushEngine->propagate(m_models);
+
+        for (auto const& model : m_models)
+        {
+            if (auto* multires = model->multires(); multires)
+                multires->setLevel(multires->levelCount() - 1);
+        }
+
+        m_isModified = true;
+        ++m_geometryRevision;
+        buildDrawLists();
+    }
+
+    auto Document::updateBrush(Camera const* camera) -> std::vector<rhi::WaitSemaphore>
+    {
+        if (camera->mode() != CameraMode::Pick || !m_hit)
+        {
+            if (m_lastBrushPoint)
+            {
+                m_brushEngine->endStroke(m_models);
+
+                // Ending the stroke propagates it through the multiresolution levels that navigation draws.
+                if (m_navigationDrawList)
+                    m_navigationDrawList->refit();
+            }
+
+            m_lastBrushPoint.reset();
+            return m_brushEngine->takeWaitSemaphores();
+        }
+
+        // Each hit is applied once, when it arrives; frames that are only waiting for the next hit leave the stroke as it is.
+        if (!m_isHitNew)
+            return m_brushEngine->takeWaitSemaphores();
+
+        m_isHitNew       = false;
+        auto const point = m_hit->point;
+
+        auto const radius   = base::Preferences::read(base::PreferenceType::BrushRadius).toFloat();
+        auto const strength = base::Preferences::read(base::PreferenceType::BrushStrength).toFloat();
+
+        BrushUniform brush = {};
+        brush.n            = m_hit->footprint.pixelCount > 0 ? m_hit->footprint.normal : m_hit->normal;
+        brush.r            = radius;
+        brush.r_sqrd       = radius * radius;
+        brush.scale        = strength;
+        brush.offset       = 1.0f;
+
+        // Space the samples along the stroke so that fast mouse movements don't leave gaps.
+        auto const                spacing = 0.25f * radius;
+        auto const                from    = m_lastBrushPoint.value_or(point);
+        auto const                steps   = std::max(1u, static_cast<uint32_t>(glm::distance(from, point) / spacing));
+        std::vector<BrushUniform> samples;
+
+        for (auto step = 1u; step <= steps; ++step)
+        {
+            brush.p = glm::mix(from, point, static_cast<float>(step) / static_cast<float>(steps));
+            samples.emplace_back(brush);
+
+            // Only the vertices that a sample reaches are moved, so the hierarchies refit just those within the samples' box.
+            m_bvhDirty.extend(brush.p, brush.r);
+        }
+
+        m_lastBrushPoint = point;
+        m_isModified     = true;
+        ++m_geometryRevision;
+
+        m_brushEngine->stroke(m_models, samples);
+
+        // The topology is adapted at the start of the next frame, as this frame has already recorded draws of the buffers.
+        if (base::Preferences::read(base::PreferenceType::DynamicTopology).toBool())
+            m_pendingTopology = PendingTopology{ brush, from };
+
+        return m_brushEngine->takeWaitSemaphores();
+    }
+
     void Document::updateHitTestQuery(Camera const* camera, vk::Rect2D const& rect)
     {
-        auto*       frameData     = m_context->frameData();
-        auto const& commandBuffer = frameData->commandBuffer();
+        auto const& commandBuffer = m_context->frameData()->commandBuffer();
+
+        // Hits requested by earlier frames are picked up once those frames have completed.
+        m_hitQueries->poll();
+
+        if (!m_shouldUpdateHitBuffer)
+            return;
+
+        m_shouldUpdateHitBuffer = false;
+
+        // Nothing under the mouse can have changed, so the current hit still holds.
+        auto const point  = camera->lastPoint();
+        auto const radius = base::Preferences::read(base::PreferenceType::BrushRadius).toFloat();
+        auto const query  = HitQuery{ point, camera->viewProjection(), m_geometryRevision, radius };
+        if (query == m_lastHitQuery)
+            return;
+
+        m_lastHitQuery = query;
+
+        // The pass only covers a tile around the mouse, which is kept within the viewport.
+        auto const x      = std::clamp(point.x(), 0, static_cast<int32_t>(m_extent.width) - 1);
+        auto const y      = std::clamp(point.y(), 0, static_cast<int32_t>(m_extent.height) - 1);
+        auto const origin = vk::Offset2D(std::clamp(x - static_cast<int32_t>(m_hitTile.width / 2), 0, static_cast<int32_t>(m_extent.width - m_hitTile.width)),
+                                         std::clamp(y - static_cast<int32_t>(m_hitTile.height / 2), 0, static_cast<int32_t>(m_extent.height - m_hitTile.height)));
+
+        m_hitDepth->transition(rhi::Image::Usage::eAttachmentReadWrite, commandBuffer);
+        m_hitNormal->transition(rhi::Image::Usage::eAttachmentWriteOnly, commandBuffer);
+
+        renderHitTesting(rect, origin, commandBuffer);
+
+        m_hitDepth->transition(rhi::Image::Usage::eTransferSrc, commandBuffer);
+        m_hitNormal->transition(rhi::Image::Usage::eTransferSrc, commandBuffer);
+
+        auto const unproject = glm::inverse(camera->viewProjection());
+        auto const tile      = vk::Rect2D(origin, m_hitTile);
+        m_hitQueries->request(static_cast<uint32_t>(x), static_cast<uint32_t>(y), m_extent, unproject, tile, radius, m_hitDepth.get(), m_hitNormal.get(), commandBuffer);
+    }
+
+    void Document::uploadUniforms(Camera const* camera)
+    {
+        CameraUniform const cameraParams = { camera->viewProjection(), camera->eye() };
+        m_context->frameData()->cameraUniformBuffer()->upload(cameraParams);
+    }
+
+    void Document::adaptTopology()
+    {
+        // The copy that the last frame started is applied first, as the copy that this frame starts must see its edits.
+        applyTopology();
+
+        if (!m_pendingTopology)
+            return;
+
+        auto const stroke     = *std::exchange(m_pendingTopology, std::nullopt);
+        auto const detailSize = base::Preferences::read(base::PreferenceType::DynamicTopologyDetail).toFloat();
+        if (detailSize <= 0.0f)
+            return;
+
+        // The copies on the CPU are made when first needed; after that, they only take the vertices that strokes have moved.
+        auto const isAdapted = std::ranges::any_of(m_models, [](auto const& model) { return model->mesh() && !model->multires(); });
+        if (!isAdapted)
+            return;
+
+        static constexpr std::array<rhi::Mesh::BufferType, 2> s_syncBuffers = { rhi::Mesh::BufferTypeEditVertex, rhi::Mesh::BufferTypeColour };
+
+        // Models are only ever placed with rigid transforms and uniform scales, so the brush stays a sphere in model space.
+        auto const& brush   = stroke.brush;
+        auto const  isBuilt = std::ranges::all_of(m_models, [](auto const& model) { return !model->mesh() || model->multires() || model->dynamicTopology(); });
+        if (!isBuilt || m_topologyRevision + 1 != m_geometryRevision)
+        {
+            // Building the copies, or catching them up with edits other than the last stroke, is rare, so it waits for the read back
+            // and edits the topology straight away.
+            static constexpr std::array<rhi::Mesh::BufferType, 3> s_buildBuffers = { rhi::Mesh::BufferTypeEditVertex,
+                                                                                      rhi::Mesh::BufferTypeColour,
+                                                                                      rhi::Mesh::BufferTypeIndex };
+
+            auto const types     = isBuilt ? std::span<rhi::Mesh::BufferType const>(s_syncBuffers) : std::span<rhi::Mesh::BufferType const>(s_buildBuffers);
+            auto const readbacks = readBack(types);
+
+            m_context->waitForSemaphore(m_saveSemaphore, m_saveValue);
+
+            auto readback = readbacks.begin();
+            for (auto const& model : m_models)
+            {
+                if (!model->mesh())
+                    continue;
+
+                auto const* positionBuffer = (readback++)->get();
+                auto const* colourBuffer   = (readback++)->get();
+                positionBuffer->invalidate();
+                colourBuffer->invalidate();
+
+                auto const positions = std::span(static_cast<glm::vec3 const*>(positionBuffer->data()), positionBuffer->size() / sizeof(glm::vec3));
+                auto const colours   = std::span(static_cast<uint32_t const*>(colourBuffer->data()), colourBuffer->size() / sizeof(uint32_t));
+
+                auto const* indexBuffer = isBuilt ? nullptr : (readback++)->get();
+
+                // Models that already have a topology keep its free lists, and only take the vertices.
+                if (auto* topology = model->dynamicTopology(); topology)
+                {
+                    topology->setVertices(positions, colours);
+                    continue;
+                }
+
+                // Multiresolution levels are built over a fixed topology, so it is never adapted.
+                if (!indexBuffer || model->multires())
+                    continue;
+
+                indexBuffer->invalidate();
+                auto const indices = std::span(static_cast<uint32_t const*>(indexBuffer->data()), indexBuffer->size() / sizeof(uint32_t));
+                model->setDynamicTopology(std::make_unique<DynamicTopology>(positions, indices, colours));
+            }
+
+            m_topologyRevision = m_geometryRevision;
+            editTopology(brush);
+            return;
+        }
+
+        // Only the pending stroke has moved vertices since they were last taken, and only those within its capsule. They are read
+        // back without waiting, and the next frame applies them along with the edits around the stroke.
+        auto& readback          = m_topologyReadbacks[m_topologyReadbackIndex];
+        m_topologyReadbackIndex = (m_topologyReadbackIndex + 1) % static_cast<uint32_t>(m_topologyReadbacks.size());
+
+        readback.runs.clear();
+        for (auto const& model : m_models)
+        {
+            if (!model->mesh())
+                continue;
+
+            auto const* topology = model->dynamicTopology();
+            auto const  inverse  = glm::inverse(model->transform());
+            auto const  scale    = glm::length(glm::vec3(inverse[0]));
+            auto const  from     = glm::vec3(inverse * glm::vec4(stroke.from, 1.0f));
+            auto const  to       = glm::vec3(inverse * glm::vec4(brush.p, 1.0f));
+            readback.runs.emplace_back(topology ? topology->vertexRuns(from, to, brush.r * scale) : std::vector<glm::uvec2>());
+        }
+
+        readback.buffers   = readBack(s_syncBuffers, readback.runs, readback.commandPool.get());
+        readback.brush     = brush;
+        readback.value     = m_saveValue;
+        readback.isPending = true;
+
+        m_topologyRevision = m_geometryRevision;
+    }
+
+    void Document::applyTopology()
+    {
+        // Only one copy is ever in flight, in the slot before the one that the next copy takes.
+        auto const count    = static_cast<uint32_t>(m_topologyReadbacks.size());
+        auto&      readback = m_topologyReadbacks[(m_topologyReadbackIndex + count - 1) % count];
+        if (!readback.isPending)
+            return;
+
+        readback.isPending = false;
+
+        // The copy was submitted a frame ago, so it has almost always completed by now.
+        m_context->waitForSemaphore(m_saveSemaphore, readback.value);
 
-        if (m_shouldUpdateHitBuffer)
+        auto buffer    = readback.buffers.begin();
+        auto modelRuns = readback.runs.begin();
+        for (auto const& model : m_models)
         {
-            m_hitDepth->transition(rhi::Image::Usage::eAttachmentReadWrite, commandBuffer);
-            m_hitNormal->transition(rhi::Image::Usage::eAttachmentWriteOnly, commandBuffer);
+            if (!model->mesh())
+                continue;
+
+            auto const* positionBuffer = (buffer++)->get();
+            auto const* colourBuffer   = (buffer++)->get();
+            auto const& vertexRuns     = *modelRuns++;
+            auto*       topology       = model->dynamicTopology();
+            if (!topology || vertexRuns.empty())
+                continue;
+
+            positionBuffer->invalidate();
+            colourBuffer->invalidate();
+
+            auto const positions = std::span(static_cast<glm::vec3 const*>(positionBuffer->data()), positionBuffer->size() / sizeof(glm::vec3));
+            auto const colours   = std::span(static_cast<uint32_t const*>(colourBuffer->data()), colourBuffer->size() / sizeof(uint32_t));
+            topology->setVertices(vertexRuns, positions, colours);
+        }
 
-            renderHitTesting(rect, camera, commandBuffer);
+        readback.buffers.clear();
+        editTopology(readback.brush);
+    }
+
+    void Document::editTopology(BrushUniform const& brush)
+    {
+        auto const detailSize = base::Preferences::read(base::PreferenceType::DynamicTopologyDetail).toFloat();
+        if (detailSize <= 0.0f)
+            return;
 
-            m_hitDepth->transition(rhi::Image::Usage::eTransferSrc, commandBuffer);
-            m_hitNormal->transition(rhi::Image::Usage::eTransferSrc, commandBuffer);
+        auto* stagingRing = m_context->stagingRing();
+        auto  isChanged   = false;
+        auto  isRebuilt   = false;
 
-            m_shouldUpdateHitBuffer = false;
+        std::vector<glm::uvec2> triangles;
 
-            auto const point = camera->lastPoint();
-            m_hitDepth->copyPixel(point.x(), point.y(), 0, commandBuffer, frameData->mouseBuffer());
-            m_hitNormal->copyPixel(point.x(), point.y(), 4, commandBuffer, frameData->mouseBuffer());
-            m_hit = rhi::createMouseHit(point.x(), point.y(), m_extent.width, m_extent.height, frameData->mouseBuffer());
+        for (auto const& model : m_models)
+        {
+            auto* topology = model->dynamicTopology();
+            if (!topology)
+                continue;
+
+            auto const inverse = glm::inverse(model->transform());
+            auto const scale   = glm::length(glm::vec3(inverse[0]));
+            auto const centre  = glm::vec3(inverse * glm::vec4(brush.p, 1.0f));
+            if (!topology->update(centre, brush.r * scale, detailSize * scale))
+                continue;
+
+            // The frames in flight may still be drawing the slots that are rewritten, and the last stroke may still be writing the
+            // vertices, so the copies wait for both on the device. Buffers that are outgrown are released by the ring once the
+            // copies have completed, by when nothing that was submitted before them can be using them.
+            if (!isChanged)
+            {
+                stagingRing->addWaitSemaphore(m_context->frameCompleteWait(vk::PipelineStageFlagBits::eTransfer));
+                stagingRing->addWaitSemaphore(m_brushEngine->waitSemaphore(vk::PipelineStageFlagBits::eTransfer));
+                isChanged = true;
+            }
+
+            auto*      mesh       = model->mesh();
+            auto const isReplaced = topology->upload(mesh, triangles);
+            if (!isReplaced)
+            {
+                auto const isPatched = m_drawList->update(mesh, triangles) && (!m_navigationDrawList || m_navigationDrawList->update(mesh, triangles));
+                isRebuilt            = isRebuilt || !isPatched;
+            }
+
+            // A grid over buffers that are still in use is sorted again by the next stroke; the hierarchies were built for the
+            // previous triangles, so they are rebuilt when next picked.
+            if (auto* grid = model->brushGrid(); grid && !isReplaced)
+                grid->invalidate();
+            else
+                m_brushEngine->retire(model->setBrushGrid(nullptr));
+
+            model->setBvh(nullptr);
+            model->setDeviceBvh(nullptr);
+            isRebuilt = isRebuilt || isReplaced;
         }
+
+        if (!isChanged)
+            return;
+
+        // The lists keep their previous buffers, and any patches already recorded into them, until the frames in flight are done.
+        if (isRebuilt)
+            buildDrawLists();
+
+        // This frame's cull and draw wait for the copies.
+        stagingRing->submit();
+
+        // The copies on the CPU take the edits too, so strokes since the read back are still all that they lack. The triangles
+        // that were rewritten are no longer in vertex cache order, so the document is optimised again when it is next opened.
+        m_isModified  = true;
+        m_isOptimised = false;
+        ++m_geometryRevision;
+        ++m_topologyRevision;
     }
 
-    void Document::uploadUniforms(Camera const* camera, glm::mat4 const& modelTransform, PipelineIndex const index)
+    void Document::buildDrawLists()
     {
-        auto const& device    = m_context->device()->logicalDevice();
-        auto*       frameData = m_context->frameData();
+        m_drawList->build(m_models);
 
-        CameraUniform cameraParams = { camera->viewProjection(), camera->eye() };
-        auto*         cameraBuffer = frameData->cameraUniformBuffer();
-        cameraBuffer->upload(cameraParams);
+        // A second list draws subdivided models at a lower level while the camera moves; without any, the first serves for both.
+        auto const levelsDropped = base::Preferences::read(base::PreferenceType::MultiresNavigationLevels).toUInt();
+        auto const isDropped     = levelsDropped > 0 && std::ranges::any_of(m_models, [](auto const& model) { return model->multires() && model->multires()->level() > 0; });
 
-        auto* modelBuffer = frameData->modelUniformBuffer();
-        modelBuffer->upload(modelTransform);
+        if (!isDropped)
+        {
+            m_navigationDrawList.reset();
+            m_isNavigating = false;
+            return;
+        }
+
+        if (!m_navigationDrawList)
+            m_navigationDrawList = std::make_unique<DrawList>(m_context);
 
-        std::vector<rhi::DescriptorUpdate> updateSet;
-        updateSet.emplace_back(vk::DescriptorType::eUniformBuffer, cameraBuffer->buffer(), VK_WHOLE_SIZE, vk::BufferView());
-        updateSet.emplace_back(vk::DescriptorType::eUniformBuffer, modelBuffer->buffer(), VK_WHOLE_SIZE, vk::BufferView());
-        rhi::updateDescriptorSets(device, m_descriptorSets[index], updateSet);
+        m_navigationDrawList->build(m_models, levelsDropped);
     }
 
     void Document::createCursorPipeline()
@@ -150,17 +945,7 @@ namespace com::scene
         auto const& device = m_context->device()->logicalDevice();
         auto const  i      = PipelineIndexCursor;
 
-        std::vector<vk::DescriptorPoolSize> descriptorPoolSizes = { { vk::DescriptorType::eUniformBuffer, 1 }, { vk::DescriptorType::eUniformBuffer, 1 } };
-        m_descriptorPools[i]                                    = rhi::createDescriptorPool(device, descriptorPoolSizes);
-
-        std::vector<rhi::DescriptorSetDescription> descriptorSetDescription = {
-            { vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment },
-            { vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment }
-        };
-        m_descriptorSetLayouts[i] = rhi::createDescriptorSetLayout(device, descriptorSetDescription);
-
-        m_descriptorSets[i]  = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_descriptorPools[i], m_descriptorSetLayouts[i])).front();
-        m_pipelineLayouts[i] = device.createPipelineLayout(vk::PipelineLayoutCreateInfo(vk::PipelineLayoutCreateFlags(), m_descriptorSetLayouts[i]));
+        createDescriptorSets(i);
 
         m_shaders[ShaderCursorVertex]   = rhi::createShader(device, "cursor.vert");
         m_shaders[ShaderCursorFragment] = rhi::createShader(device, "cursor.frag");
@@ -186,27 +971,23 @@ namespace com::scene
         auto const& device = m_context->device()->logicalDevice();
         auto const  i      = PipelineIndexHitTest;
 
+        // The attachments only hold the tile around the mouse, which is the brush's footprint; the rest of the viewport is never
+        // rendered.
+        auto const tileSize = std::max(1u, base::Preferences::read(base::PreferenceType::BrushFootprintSize).toUInt());
+        m_hitTile           = vk::Extent2D(std::min(tileSize, m_extent.width), std::min(tileSize, m_extent.height));
+        m_lastHitQuery      = std::nullopt;
+
         m_hitDepth = std::make_unique<rhi::Image>(m_context->device(),
-                                                  m_extent,
+                                                  m_hitTile,
                                                   vk::Format::eD32Sfloat,
                                                   vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eTransferSrc);
 
         m_hitNormal = std::make_unique<rhi::Image>(m_context->device(),
-                                                   m_extent,
+                                                   m_hitTile,
                                                    vk::Format::eR32Uint,
                                                    vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc);
 
-        std::vector<vk::DescriptorPoolSize> descriptorPoolSizes = { { vk::DescriptorType::eUniformBuffer, 1 }, { vk::DescriptorType::eUniformBuffer, 1 } };
-        m_descriptorPools[i]                                    = rhi::createDescriptorPool(device, descriptorPoolSizes);
-
-        std::vector<rhi::DescriptorSetDescription> descriptorSetDescription = {
-            { vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment },
-            { vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment }
-        };
-        m_descriptorSetLayouts[i] = rhi::createDescriptorSetLayout(device, descriptorSetDescription);
-
-        m_descriptorSets[i]  = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_descriptorPools[i], m_descriptorSetLayouts[i])).front();
-        m_pipelineLayouts[i] = device.createPipelineLayout(vk::PipelineLayoutCreateInfo(vk::PipelineLayoutCreateFlags(), m_descriptorSetLayouts[i]));
+        createDescriptorSets(i);
 
         m_shaders[ShaderHitTestVertex]   = rhi::createShader(device, "hit-test.vert");
         m_shaders[ShaderHitTestFragment] = rhi::createShader(device, "hit-test.frag");
@@ -235,29 +1016,17 @@ namespace com::scene
         auto const& device = m_context->device()->logicalDevice();
         auto const  i      = PipelineIndexModel;
 
-        std::vector<vk::DescriptorPoolSize> descriptorPoolSizes = { { vk::DescriptorType::eUniformBuffer, 1 }, { vk::DescriptorType::eUniformBuffer, 1 } };
-        m_descriptorPools[i]                                    = rhi::createDescriptorPool(device, descriptorPoolSizes);
-
-        std::vector<rhi::DescriptorSetDescription> descriptorSetDescription = {
-            { vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment },
-            { vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment }
-        };
-        m_descriptorSetLayouts[i] = rhi::createDescriptorSetLayout(device, descriptorSetDescription);
-
-        m_descriptorSets[i]  = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_descriptorPools[i], m_descriptorSetLayouts[i])).front();
-        m_pipelineLayouts[i] = device.createPipelineLayout(vk::PipelineLayoutCreateInfo(vk::PipelineLayoutCreateFlags(), m_descriptorSetLayouts[i]));
+        createDescriptorSets(i);
 
         m_shaders[ShaderModelVertex]   = rhi::createShader(device, "model.vert");
         m_shaders[ShaderModelFragment] = rhi::createShader(device, "model.frag");
 
         std::vector<vk::Format> colorformats        = { m_context->colorFormat() };
         auto const              renderingCreateInfo = vk::PipelineRenderingCreateInfo({}, colorformats, m_context->depthFormat());
-        auto const              vertexAttributes    = std::vector<std::pair<vk::Format, size_t>>{ //
-                                                                                  { std::make_pair(vk::Format::eR32G32B32Sfloat, sizeof(glm::vec3)) },
-                                                                                  { std::make_pair(vk::Format::eR8G8B8A8Unorm, sizeof(uint32_t)) }
-        };
+
+        // There are no vertex attributes; the vertex shader pulls the vertex streams through the draw list's records.
         m_pipelines[i] = rhi::createGraphicsPipeline(m_context,
-                                                     vertexAttributes,
+                                                     {},
                                                      m_shaders[ShaderModelVertex],
                                                      m_shaders[ShaderModelFragment],
                                                      vk::FrontFace::eClockwise,
@@ -267,6 +1036,52 @@ namespace com::scene
                                                      m_pipelineLayouts[i]);
     }
 
+    void Document::createDescriptorSets(PipelineIndex const index)
+    {
+        auto const& device     = m_context->device()->logicalDevice();
+        auto const  frameCount = m_context->frameCount();
+
+        // One set per frame in flight, each bound to that frame's camera; they are written once, here.
+        std::vector<vk::DescriptorPoolSize> descriptorPoolSizes = { { vk::DescriptorType::eUniformBuffer, frameCount } };
+        m_descriptorPools[index]                                = rhi::createDescriptorPool(device, descriptorPoolSizes);
+
+        std::vector<rhi::DescriptorSetDescription> descriptorSetDescription = {
+            { vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment }
+        };
+        m_descriptorSetLayouts[index] = rhi::createDescriptorSetLayout(device, descriptorSetDescription);
+
+        std::vector<vk::DescriptorSetLayout> layouts(frameCount, m_descriptorSetLayouts[index]);
+        m_descriptorSets[index] = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_descriptorPools[index], layouts));
+
+        for (auto frame = 0u; frame < frameCount; ++frame)
+        {
+            auto const* cameraBuffer = m_context->frameData(frame)->cameraUniformBuffer();
+
+            std::vector<rhi::DescriptorUpdate> updateSet;
+            updateSet.emplace_back(vk::DescriptorType::eUniformBuffer, cameraBuffer->buffer(), VK_WHOLE_SIZE, vk::BufferView());
+            rhi::updateDescriptorSets(device, m_descriptorSets[index][frame], updateSet);
+        }
+
+        // The models are drawn indirectly and read their records from the draw list's set; the cursor and hit-test
+        // draws push their model's transform as a constant, so that drawing a model costs no descriptor updates.
+        std::vector<vk::DescriptorSetLayout> setLayouts = { m_descriptorSetLayouts[index] };
+        if (index == PipelineIndexModel)
+            setLayouts.emplace_back(m_drawList->descriptorSetLayout());
+
+        auto const pushConstants = vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(ModelUniform));
+        m_pipelineLayouts[index] = device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, setLayouts, pushConstants));
+    }
+
+    auto Document::descriptorSet(PipelineIndex const index) const -> vk::DescriptorSet const&
+    {
+        return m_descriptorSets[index][m_context->frameIndex()];
+    }
+
+    auto Document::drawList() const -> DrawList*
+    {
+        return m_isNavigating ? m_navigationDrawList.get() : m_drawList.get();
+    }
+
     void Document::destroyCursorPipeline()
     {
         destroyPipeline(PipelineIndexCursor, m_shaders[ShaderCursorVertex], m_shaders[ShaderCursorFragment]);
@@ -299,8 +1114,167 @@ namespace com::scene
         device.destroyPipeline(m_pipelines[index]);
     }
 
-    void Document::renderHitTesting(vk::Rect2D const& rect, Camera const* camera, vk::CommandBuffer const& commandBuffer)
+    auto Document::beginReadBack(rhi::CommandPool* const commandPool) -> vk::CommandBuffer const&
+    {
+        // The save's command buffer is reused, so any earlier read back on it must have completed. Every other read back on it is
+        // waited on as soon as it is submitted, so only a save's snapshot can still be in flight.
+        auto* const pool = commandPool ? commandPool : m_saveCommandPool.get();
+        if (!commandPool && isSaving())
+            m_context->waitForSemaphore(m_saveSemaphore, m_saveValue);
+
+        auto const& commandBuffer = pool->commandBuffer();
+        pool->reset();
+
+        commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+        return commandBuffer;
+    }
+
+    auto Document::readBack(std::span<rhi::Mesh::BufferType const> const  types,
+                            std::span<std::vector<glm::uvec2> const> const runs,
+                            rhi::CommandPool* const                        commandPool) -> std::vector<std::unique_ptr<rhi::Buffer>>
+    {
+        auto const& commandBuffer = beginReadBack(commandPool);
+
+        std::vector<std::unique_ptr<rhi::Buffer>> readbacks;
+        auto                                      modelRuns = runs.begin();
+        for (auto const& model : m_models)
+        {
+            auto const* mesh = model->mesh();
+            if (!mesh)
+                continue;
+
+            for (auto const type : types)
+            {
+                auto const* source = mesh->buffer(type);
+
+                // Only the part in use is read, as buffers that have grown with dynamic topology hold spare capacity.
+                if (runs.empty())
+                {
+                    auto const size     = mesh->usedSize(type);
+                    auto       readback = std::make_unique<rhi::Buffer>(m_context, size, vk::BufferUsageFlagBits::eTransferDst);
+
+                    commandBuffer.copyBuffer(source->buffer(), readback->buffer(), vk::BufferCopy(0, 0, size));
+                    readbacks.emplace_back(std::move(readback));
+                    continue;
+                }
+
+                // Otherwise each model's runs of elements are read one after another.
+                auto const                  stride = rhi::Mesh::stride(type);
+                vk::DeviceSize              size   = 0;
+                std::vector<vk::BufferCopy> copies;
+
+                for (auto const& run : *modelRuns)
+                {
+                    copies.emplace_back(stride * run.x, size, stride * run.y);
+                    size += stride * run.y;
+                }
+
+                auto readback = std::make_unique<rhi::Buffer>(m_context, std::max(size, stride), vk::BufferUsageFlagBits::eTransferDst);
+                if (!copies.empty())
+                    commandBuffer.copyBuffer(source->buffer(), readback->buffer(), copies);
+
+                readbacks.emplace_back(std::move(readback));
+            }
+
+            if (!runs.empty())
+                ++modelRuns;
+        }
+
+        submitReadBack(commandBuffer);
+        return readbacks;
+    }
+
+    auto Document::snapshot() -> std::vector<std::unique_ptr<rhi::Buffer>>
     {
+        auto const& commandBuffer = beginReadBack();
+
+        // Each read back holds at least a byte, as a buffer may not be empty, and the copies are made for those that are not.
+        std::vector<std::unique_ptr<rhi::Buffer>> readbacks;
+        auto const                                readback = [&](vk::DeviceSize const size)
+        {
+            readbacks.emplace_back(std::make_unique<rhi::Buffer>(m_context, std::max(size, vk::DeviceSize(1)), vk::BufferUsageFlagBits::eTransferDst));
+            return readbacks.back()->buffer();
+        };
+
+        for (auto const& model : m_models)
+        {
+            if (!model->mesh())
+                continue;
+
+            // A subdivided model is saved as its base cage, which the sculpted level has been copied down to, and its displacements.
+            auto const* multires = model->multires();
+            auto const* mesh     = multires ? multires->mesh(0) : model->mesh();
+            for (auto const type : s_savedBuffers)
+            {
+                auto const size        = mesh->usedSize(type);
+                auto const destination = readback(size);
+                if (size > 0)
+                    commandBuffer.copyBuffer(mesh->buffer(type)->buffer(), destination, vk::BufferCopy(0, 0, size));
+            }
+
+            if (!multires || multires->levelCount() <= 1)
+                continue;
+
+            // The levels above the sculpted one take their colours from it, so its colours are all that painting has left.
+            auto const* sculpted   = multires->mesh(multires->level());
+            auto const  colourSize = multires->level() > 0 ? sculpted->usedSize(rhi::Mesh::BufferTypeColour) : 0;
+            auto const  colours    = readback(colourSize);
+            if (colourSize > 0)
+                commandBuffer.copyBuffer(sculpted->buffer(rhi::Mesh::BufferTypeColour)->buffer(), colours, vk::BufferCopy(0, 0, colourSize));
+
+            // The displacements of every level are read one after another.
+            std::vector<vk::BufferCopy> copies;
+            vk::DeviceSize              size = 0;
+            for (auto level = 1u; level < multires->levelCount(); ++level)
+            {
+                auto const levelSize = multires->buffer(level, Multires::BufferTypeDisplacement)->size();
+                copies.emplace_back(0, size, levelSize);
+                size += levelSize;
+            }
+
+            auto const displacements = readback(size);
+            for (auto level = 1u; level < multires->levelCount(); ++level)
+                commandBuffer.copyBuffer(multires->buffer(level, Multires::BufferTypeDisplacement)->buffer(), displacements, copies[level - 1]);
+        }
+
+        submitReadBack(commandBuffer);
+        return readbacks;
+    }
+
+    void Document::submitReadBack(vk::CommandBuffer const& commandBuffer)
+    {
+        auto const barrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eTransfer,
+                                                vk::AccessFlagBits2::eTransferWrite,
+                                                vk::PipelineStageFlagBits2::eHost,
+                                                vk::AccessFlagBits2::eHostRead);
+        commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, barrier, {}, {}));
+        commandBuffer.end();
+
+        // Uploads may not have been submitted yet, and strokes in flight may still be writing the edit buffers. The copy waits for
+        // both on the GPU, and later strokes wait for the copy, so the snapshot is consistent without the CPU waiting on either.
+        auto const uploads = m_context->stagingRing()->waitSemaphore(vk::PipelineStageFlagBits::eTransfer);
+        auto const strokes = m_brushEngine->waitSemaphore(vk::PipelineStageFlagBits::eTransfer);
+        m_context->queue(rhi::QueueIndex::eTransfer)->submit(commandBuffer, m_saveSemaphore, ++m_saveValue, { uploads, strokes });
+
+        m_brushEngine->addWaitSemaphore({ m_saveSemaphore, vk::PipelineStageFlagBits::eComputeShader, m_saveValue });
+    }
+
+    void Document::pushModelTransform(vk::CommandBuffer const& commandBuffer, glm::mat4 const& transform, PipelineIndex const index) const
+    {
+        ModelUniform const modelParams = { transform };
+        commandBuffer.pushConstants(m_pipelineLayouts[index], vk::ShaderStageFlagBits::eVertex, 0, sizeof(ModelUniform), &modelParams);
+    }
+
+    void Document::renderHitTesting(vk::Rect2D const& rect, vk::Offset2D const& origin, vk::CommandBuffer const& commandBuffer)
+    {
+        // The viewport is shifted so that the tile at the origin lands on the attachments, and restored afterwards.
+        auto const tile   = vk::Rect2D(vk::Offset2D(0, 0), m_hitTile);
+        auto const width  = static_cast<float>(rect.extent.width);
+        auto const height = static_cast<float>(rect.extent.height);
+
+        commandBuffer.setViewport(0, vk::Viewport(static_cast<float>(-origin.x), static_cast<float>(-origin.y), width, height, 0.0f, 1.0f));
+        commandBuffer.setScissor(0, tile);
+
         std::vector<vk::RenderingAttachmentInfo> attachments;
 
         // Color attachment.
@@ -312,23 +1286,112 @@ namespace com::scene
         auto depthAttachment = m_hitDepth->asRenderingAttachmentInfo();
         depthAttachment.setClearValue(vk::ClearDepthStencilValue(0.0f));
 
-        vk::RenderingInfo renderInfo({}, rect, 1u, 0, attachments, &depthAttachment);
+        vk::RenderingInfo renderInfo({}, tile, 1u, 0, attachments, &depthAttachment);
         commandBuffer.beginRendering(renderInfo);
 
         commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipelines[PipelineIndexHitTest]);
         commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
                                          m_pipelineLayouts[PipelineIndexHitTest],
                                          0, //
-                                         { m_descriptorSets[PipelineIndexHitTest] },
+                                         { descriptorSet(PipelineIndexHitTest) },
                                          nullptr);
 
         for (auto const& model : m_models)
         {
-            uploadUniforms(camera, model->transform(), PipelineIndexHitTest);
+            pushModelTransform(commandBuffer, model->transform(), PipelineIndexHitTest);
             model->render(commandBuffer);
         }
 
         commandBuffer.endRendering();
+
+        // The pass draws from the edit vertices.
+        m_brushEngine->addFrameRead();
+
+        commandBuffer.setViewport(0, vk::Viewport(static_cast<float>(rect.offset.x), static_cast<float>(rect.offset.y), width, height, 0.0f, 1.0f));
+        commandBuffer.setScissor(0, rect);
     }
 
+    void Document::updateBvhs()
+    {
+        auto const isBuilt = std::ranges::all_of(m_models, [](auto const& model) { return !model->mesh() || model->bvh(); });
+        if (isBuilt && m_bvhRevision == m_geometryRevision)
+            return;
+
+        // New models need their indices too; otherwise strokes have only moved the vertices, so the trees are refit.
+        static constexpr std::array<rhi::Mesh::BufferType, 2> s_buildBuffers = { rhi::Mesh::BufferTypeEditVertex, rhi::Mesh::BufferTypeIndex };
+        static constexpr std::array<rhi::Mesh::BufferType, 1> s_refitBuffers = { rhi::Mesh::BufferTypeEditVertex };
+
+        // A refit reads back only the vertices within the box of the samples since the last one. A vertex that none of them
+        // reached is where the tree last saw it, so those that moved were all inside the box in the tree's positions.
+        std::vector<std::vector<glm::uvec2>> runs;
+        if (isBuilt)
+        {
+            auto const lo = m_bvhDirty.isNull() ? glm::vec3(0.0f) : m_bvhDirty.getMin();
+            auto const hi = m_bvhDirty.isNull() ? glm::vec3(0.0f) : m_bvhDirty.getMax();
+
+            for (auto const& model : m_models)
+            {
+                if (!model->mesh())
+                    continue;
+
+                // The box is taken into the model's space by its corners, as the transform may rotate it.
+                auto const inverse = glm::inverse(model->transform());
+                auto       localLo = glm::vec3(std::numeric_limits<float>::max());
+                auto       localHi = glm::vec3(std::numeric_limits<float>::lowest());
+                for (auto corner = 0u; corner < 8; ++corner)
+                {
+                    auto const point = glm::vec3(corner & 1 ? hi.x : lo.x, corner & 2 ? hi.y : lo.y, corner & 4 ? hi.z : lo.z);
+                    auto const local = glm::vec3(inverse * glm::vec4(point, 1.0f));
+                    localLo          = glm::min(localLo, local);
+                    localHi          = glm::max(localHi, local);
+                }
+
+                runs.emplace_back(m_bvhDirty.isNull() ? std::vector<glm::uvec2>() : model->bvh()->vertexRuns(localLo, localHi));
+            }
+        }
+
+        m_bvhDirty.setNull();
+
+        if (isBuilt && std::ranges::all_of(runs, [](auto const& modelRuns) { return modelRuns.empty(); }))
+        {
+            m_bvhRevision = m_geometryRevision;
+            return;
+        }
+
+        auto const types     = isBuilt ? std::span<rhi::Mesh::BufferType const>(s_refitBuffers) : std::span<rhi::Mesh::BufferType const>(s_buildBuffers);
+        auto const readbacks = readBack(types, runs);
+
+        m_context->waitForSemaphore(m_saveSemaphore, m_saveValue);
+
+        auto readback  = readbacks.begin();
+        auto modelRuns = runs.begin();
+        for (auto const& model : m_models)
+        {
+            if (!model->mesh())
+                continue;
+
+            auto const* positionBuffer = (readback++)->get();
+            positionBuffer->invalidate();
+            auto const positions = std::span(static_cast<glm::vec3 const*>(positionBuffer->data()), positionBuffer->size() / sizeof(glm::vec3));
+
+            if (isBuilt)
+            {
+                model->bvh()->refit(*modelRuns++, positions);
+                continue;
+            }
+
+            auto const* indexBuffer = (readback++)->get();
+            indexBuffer->invalidate();
+            auto const indices = std::span(static_cast<uint32_t const*>(indexBuffer->data()), indexBuffer->size() / sizeof(uint32_t));
+            model->setBvh(std::make_unique<Bvh>(positions, indices));
+        }
+
+        m_bvhRevision = m_geometryRevision;
+    }
+
+    void Document::waitForSave()
+    {
+        if (m_saveThread.joinable())
+            m_saveThread.join();
+    }
 } // namespace com::scene
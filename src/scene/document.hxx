@@ -4,12 +4,20 @@
 
 #pragma once
 
+#include "rhi/command-pool.hxx"
 #include "rhi/hit-testing.hxx"
 #include "rhi/image.hxx"
+#include "scene/brush-engine.hxx"
 #include "scene/camera.hxx"
+#include "scene/draw-list.hxx"
 #include "scene/model.hxx"
+#include "scene/picker.hxx"
 
 #include <QObject>
+#include <array>
+#include <atomic>
+#include <optional>
+#include <thread>
 
 namespace com::scene
 {
@@ -45,6 +53,12 @@ namespace com::scene
         /// \return A valid bounding box.
         [[nodiscard]] auto bounds() const -> AABB;
 
+        /// Cull the models against the camera, recording the compute pass on the current frame's command buffer. This
+        /// must be called before the frame's rendering begins. The topology is first adapted around the stroke whose vertices the
+        /// last frame read back, as that may replace the buffers that the frame reads.
+        /// \param camera The camera.
+        void cull(Camera const* camera);
+
         /// Determines if the document has been modified.
         /// \return true if the document has been modified; false otherwise.
         [[nodiscard]] auto isModified()
@@ -52,6 +66,13 @@ namespace com::scene
             return m_isModified;
         }
 
+        /// Determines if the document is being written in the background.
+        /// \return true if a save is in progress; false otherwise.
+        [[nodiscard]] auto isSaving() const
+        {
+            return m_saveThread.joinable() && !m_isSaved;
+        }
+
         /// Get the models in the current file.
         /// \return A valid string.
         [[nodiscard]] auto models() const -> std::vector<std::unique_ptr<Model>> const&
@@ -59,6 +80,14 @@ namespace com::scene
             return m_models;
         }
 
+        /// Get the multiresolution level that is sculpted.
+        /// \return The highest level that any model is sculpted on, or zero if none has been subdivided.
+        [[nodiscard]] auto multiresLevel() const -> uint32_t;
+
+        /// Get the number of multiresolution levels.
+        /// \return The most levels that any model has, including the base cage, or one if none has been subdivided.
+        [[nodiscard]] auto multiresLevelCount() const -> uint32_t;
+
         /// Get the name of the document, without extension.
         /// \return A valid string.
         [[nodiscard]] auto name() -> QString;
@@ -70,15 +99,47 @@ namespace com::scene
             return m_path;
         }
 
-        /// Render the document.
+        /// Find the nearest point where a ray hits the models, on the CPU. The hierarchies are built when first needed and refit
+        /// after strokes, which reads the edited vertices back from the GPU.
+        /// \param ray The world-space ray.
+        /// \return The world-space hit, with its normal facing the ray, if there is one; nothing otherwise.
+        [[nodiscard]] auto pick(Ray const& ray) -> std::optional<rhi::MouseHit>;
+
+        /// Cast rays into the models on the device. The device hierarchies are uploaded from the CPU ones when first needed,
+        /// and are then refit on the device when strokes have moved the vertices, so later picks read nothing back but their
+        /// results.
+        /// \param rays The world-space rays.
+        /// \return The nearest hit of each ray, if it hit anything.
+        [[nodiscard]] auto pickOnDevice(std::span<Ray const> const rays) -> std::vector<std::optional<PickHit>>;
+
+        /// Place the cursor under a point without rendering, as the hit-test pass would, so that strokes can be applied headless.
+        /// The hit is picked on the CPU, and the brush's footprint around it is sampled by rays cast on the device.
         /// \param camera The camera.
+        /// \param point The point in the viewport.
+        /// \return true if a model was under the point; false otherwise.
+        auto placeCursor(Camera const* camera, QPoint const& point) -> bool;
+
+        /// Render the document.
         /// \param commandBuffer The command buffer.
-        void render(Camera const* camera, vk::CommandBuffer const& commandBuffer);
+        void render(vk::CommandBuffer const& commandBuffer);
+
+        /// Get the latest hit, which lags the request that made it by at least one frame.
+        /// \return The world-space hit, if a model was under the mouse; nothing otherwise.
+        [[nodiscard]] auto hit() const -> std::optional<rhi::MouseHit> const&
+        {
+            return m_hit;
+        }
 
-        /// Update the hit-test data on next-frame.
+        /// Determines if a requested hit is yet to arrive, in which case frames must keep being rendered to deliver it.
+        /// \return true if a hit is in flight; false otherwise.
+        [[nodiscard]] auto isHitPending() const
+        {
+            return m_shouldUpdateHitBuffer || m_hitQueries->isPending();
+        }
+
+        /// Update the hit-test data on next-frame. The current hit is kept until the new one arrives.
         void requestHitUpdate()
         {
-            m_hit.reset();
             m_shouldUpdateHitBuffer = true;
         }
 
@@ -92,48 +153,152 @@ namespace com::scene
             createCursorPipeline();
         }
 
-        /// Save the document if it has been modified.
+        /// Open a document file.
+        /// \param context The RHI context.
+        /// \param extent The physical extent of the document.
+        /// \param path The path of the file.
+        /// \param parent The parent object, if any.
+        /// \return A valid pointer if the file was read; nullptr otherwise.
+        [[nodiscard]] static auto open(rhi::Context* context, vk::Extent2D const& extent, QString const& path, QObject* parent = nullptr)
+            -> std::unique_ptr<Document>;
+
+        /// Save the document if it has been modified. An untitled document is not saved unless a path is given. The meshes are
+        /// snapshotted on the GPU and written on a worker thread; saveFinished() is emitted when the file has been written.
         /// \param path A new path to save file.
-        /// \return true if the document has not been modified or if it was saved successfully; false otherwise.
+        /// \return true if the document has not been modified or if the save was started; false otherwise.
         [[nodiscard]] auto save(QString const path = {}) -> bool;
 
-        /// Read the mouse data to see if a hit occured.
+        /// Sculpt subdivided models on a multiresolution level. The levels above it are rebuilt from it after each stroke, and the
+        /// levels below it take its vertices.
+        /// \param level The level, where zero is the base cage; it is clamped to the levels that each model has.
+        void setMultiresLevel(uint32_t const level);
+
+        /// Add a multiresolution level above the highest of every model, and sculpt on it. A model's mesh becomes its base
+        /// cage when it is first subdivided, after which its topology is no longer adapted by strokes.
+        void subdivide();
+
+        /// Apply the brush at the current hit, if the user is sculpting.
+        /// \param camera The camera.
+        /// \return The semaphores that the frame's graphics submission must wait upon.
+        [[nodiscard]] auto updateBrush(Camera const* camera) -> std::vector<rhi::WaitSemaphore>;
+
+        /// Deliver any hits that have been read back, and request a new one if the mouse has moved.
         /// \param camera The camera.
         /// \param rect The swap chain rect.
         void updateHitTestQuery(Camera const* camera, vk::Rect2D const& rect);
 
-        /// Upload data to the GPU.
+        /// Upload the frame's camera to the GPU. Model transforms are pushed as constants when each model is drawn.
         /// \param camera The camera.
-        /// \param modelTransform The model's transform.
-        /// \param index The pipeline index.
-        void uploadUniforms(Camera const* camera, glm::mat4 const& modelTransform, PipelineIndex const index);
+        void uploadUniforms(Camera const* camera);
+
+    signals:
+        /// Emitted as a background save writes the file.
+        /// \param percent The percentage written.
+        void saveProgress(int percent);
+
+        /// Emitted when a background save has finished.
+        /// \param isSuccess true if the file was written; false otherwise.
+        void saveFinished(bool isSuccess);
+
+    private:
+        explicit Document(rhi::Context* context, vk::Extent2D const& extent, std::vector<std::unique_ptr<Model>> models, QObject* parent);
+
+        void               adaptTopology();
+        void               applyTopology();
+        [[nodiscard]] auto beginReadBack(rhi::CommandPool* const commandPool = nullptr) -> vk::CommandBuffer const&;
+        void               buildDrawLists();
+        void               createCursorPipeline();
+        void               createDescriptorSets(PipelineIndex const index);
+        void               createHitTestPipeline();
+        void               createModelPipeline();
+        [[nodiscard]] auto descriptorSet(PipelineIndex const index) const -> vk::DescriptorSet const&;
+        [[nodiscard]] auto drawList() const -> DrawList*;
+        void               destroyCursorPipeline();
+        void               destroyHitTestPipeline();
+        void               destroyModelPipeline();
+        void               destroyPipeline(PipelineIndex const index, vk::ShaderModule& vertex, vk::ShaderModule& fragment);
+        void               editTopology(BrushUniform const& brush);
+        [[nodiscard]] auto readBack(std::span<rhi::Mesh::BufferType const> const  types,
+                                    std::span<std::vector<glm::uvec2> const> const runs        = {},
+                                    rhi::CommandPool* const                        commandPool = nullptr) -> std::vector<std::unique_ptr<rhi::Buffer>>;
+        [[nodiscard]] auto sampleFootprint(glm::vec3 const& point, glm::vec3 const& normal, float const radius) -> rhi::Footprint;
+        void               pushModelTransform(vk::CommandBuffer const& commandBuffer, glm::mat4 const& transform, PipelineIndex const index) const;
+        void               renderHitTesting(vk::Rect2D const& rect, vk::Offset2D const& origin, vk::CommandBuffer const& commandBuffer);
+        [[nodiscard]] auto snapshot() -> std::vector<std::unique_ptr<rhi::Buffer>>;
+        void               submitReadBack(vk::CommandBuffer const& commandBuffer);
+        void               updateBvhs();
+        void               waitForSave();
 
     private:
-        void createCursorPipeline();
-        void createHitTestPipeline();
-        void createModelPipeline();
-        void destroyCursorPipeline();
-        void destroyHitTestPipeline();
-        void destroyModelPipeline();
-        void destroyPipeline(PipelineIndex const index, vk::ShaderModule& vertex, vk::ShaderModule& fragment);
-        void renderHitTesting(vk::Rect2D const& rect, Camera const* camera, vk::CommandBuffer const& commandBuffer);
+        /// What a hit depends upon; a query is skipped if none of it has changed since the last one.
+        struct HitQuery final
+        {
+            QPoint    point;          ///< The point under the mouse.
+            glm::mat4 viewProjection; ///< The camera's view-projection.
+            uint64_t  geometry = 0;   ///< The revision of the models' geometry.
+            float     radius   = 0;   ///< The radius of the brush, which the footprint is averaged over.
+
+            [[nodiscard]] auto operator==(HitQuery const& other) const -> bool = default;
+        };
+
+        /// A stroke whose topology is yet to be adapted.
+        struct PendingTopology final
+        {
+            BrushUniform brush; ///< The brush at the end of the stroke, around which the topology is adapted.
+            glm::vec3    from;  ///< The start of the stroke, which with the brush bounds the vertices that the stroke moved.
+        };
+
+        /// A read back of the vertices that a stroke may have moved, which the next frame applies to the topology.
+        struct TopologyReadback final
+        {
+            std::unique_ptr<rhi::CommandPool>         commandPool;       ///< The command pool that the copy is recorded on.
+            std::vector<std::unique_ptr<rhi::Buffer>> buffers;           ///< The positions and colours of each model's runs.
+            std::vector<std::vector<glm::uvec2>>      runs;              ///< The runs of vertices of each model.
+            BrushUniform                              brush;             ///< The brush at the end of the stroke.
+            uint64_t                                  value     = 0;     ///< The save semaphore value that the copy signals.
+            bool                                      isPending = false; ///< Whether the copy is yet to be applied.
+        };
 
     private:
-        rhi::Context*                        m_context = nullptr;
-        vk::Extent2D                         m_extent;
-        std::unique_ptr<Model>               m_cursor;
-        bool                                 m_isModified = false;
-        std::vector<std::unique_ptr<Model>>  m_models;
-        QString                              m_path;
-        bool                                 m_shouldUpdateHitBuffer = false;
-        std::unique_ptr<rhi::Image>          m_hitDepth;
-        std::unique_ptr<rhi::Image>          m_hitNormal;
-        std::vector<vk::DescriptorSetLayout> m_descriptorSetLayouts;
-        std::vector<vk::DescriptorPool>      m_descriptorPools;
-        std::vector<vk::DescriptorSet>       m_descriptorSets;
-        std::vector<vk::PipelineLayout>      m_pipelineLayouts;
-        std::vector<vk::Pipeline>            m_pipelines;
-        std::vector<vk::ShaderModule>        m_shaders;
-        std::unique_ptr<rhi::MouseHit>       m_hit;
+        rhi::Context*                               m_context = nullptr;
+        vk::Extent2D                                m_extent;
+        std::unique_ptr<Model>                      m_cursor;
+        bool                                        m_isModified  = false;
+        bool                                        m_isOptimised = false;
+        std::vector<std::unique_ptr<Model>>         m_models;
+        QString                                     m_path;
+        bool                                        m_shouldUpdateHitBuffer = false;
+        std::unique_ptr<rhi::Image>                 m_hitDepth;
+        std::unique_ptr<rhi::Image>                 m_hitNormal;
+        vk::Extent2D                                m_hitTile;
+        std::optional<HitQuery>                     m_lastHitQuery;
+        uint64_t                                    m_geometryRevision = 0;
+        uint64_t                                    m_bvhRevision      = 0;
+        AABB                                        m_bvhDirty;
+        std::vector<vk::DescriptorSetLayout>        m_descriptorSetLayouts;
+        std::vector<vk::DescriptorPool>             m_descriptorPools;
+        std::vector<std::vector<vk::DescriptorSet>> m_descriptorSets;
+        std::vector<vk::PipelineLayout>             m_pipelineLayouts;
+        std::vector<vk::Pipeline>                   m_pipelines;
+        std::vector<vk::ShaderModule>               m_shaders;
+        std::optional<rhi::MouseHit>                m_hit;
+        bool                                        m_isHitNew = false;
+        std::unique_ptr<rhi::HitQueries>            m_hitQueries;
+        std::unique_ptr<BrushEngine>                m_brushEngine;
+        std::unique_ptr<DrawList>                   m_drawList;
+        std::unique_ptr<DrawList>                   m_navigationDrawList;
+        bool                                        m_isNavigating = false;
+        std::unique_ptr<Picker>                     m_picker;
+        std::optional<glm::vec3>                    m_lastBrushPoint;
+        std::optional<PendingTopology>              m_pendingTopology;
+        uint64_t                                    m_topologyRevision = 0;
+        std::array<TopologyReadback, 2>             m_topologyReadbacks;
+        uint32_t                                    m_topologyReadbackIndex = 0;
+        std::unique_ptr<rhi::CommandPool>           m_saveCommandPool;
+        std::vector<std::unique_ptr<rhi::Buffer>>   m_saveReadbacks;
+        vk::Semaphore                               m_saveSemaphore;
+        uint64_t                                    m_saveValue = 0;
+        std::thread                                 m_saveThread;
+        std::atomic_bool                            m_isSaved = false;
     };
 } // namespace com::scene
@@ -0,0 +1,424 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "scene/draw-list.hxx"
+#include "rhi/context.hxx"
+#include "rhi/utilities.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+namespace com::scene
+{
+    /// The offset of the draw commands in the command buffer, which starts with the draw counts.
+    static constexpr vk::DeviceSize s_commandsOffset = sizeof(DrawCounts);
+
+    /// The most meshlets that one inline update of the refit list writes, which vkCmdUpdateBuffer limits to 64KiB.
+    static constexpr size_t s_updateLimit = 65536 / sizeof(uint32_t);
+
+    /// Map a float to an integer whose signed order matches the float's, as float_to_ordered() does in the shaders.
+    /// \param value The float.
+    /// \return The ordered integer.
+    [[nodiscard]] static auto floatToOrdered(float const value)
+    {
+        auto const bits = std::bit_cast<int32_t>(value);
+        return bits >= 0 ? bits : bits ^ 0x7fffffff;
+    }
+
+    DrawList::DrawList(rhi::Context* context) : m_context(context)
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        std::vector<rhi::DescriptorSetDescription> descriptorSetDescription = {
+            { vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute | vk::ShaderStageFlagBits::eVertex }, // Records.
+            { vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute },                                    // Commands.
+            { vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute | vk::ShaderStageFlagBits::eVertex }  // Meshlets.
+        };
+        m_descriptorSetLayout = rhi::createDescriptorSetLayout(device, descriptorSetDescription);
+
+        auto const pushConstants = vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullUniform));
+        m_pipelineLayout         = device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, m_descriptorSetLayout, pushConstants));
+
+        m_shader   = rhi::createShader(device, "draw-cull.comp");
+        m_pipeline = rhi::createComputePipeline(m_context, m_shader, m_pipelineLayout);
+
+        auto const refitPushConstants = vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(MeshletRefitUniform));
+        m_refitPipelineLayout         = device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, m_descriptorSetLayout, refitPushConstants));
+
+        m_refitShader   = rhi::createShader(device, "meshlet-refit.comp");
+        m_refitPipeline = rhi::createComputePipeline(m_context, m_refitShader, m_refitPipelineLayout);
+    }
+
+    DrawList::~DrawList()
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        release(std::numeric_limits<uint64_t>::max());
+
+        device.destroyPipeline(m_refitPipeline);
+        device.destroyShaderModule(m_refitShader);
+        device.destroyPipelineLayout(m_refitPipelineLayout);
+
+        device.destroyPipeline(m_pipeline);
+        device.destroyShaderModule(m_shader);
+        device.destroyPipelineLayout(m_pipelineLayout);
+        device.destroyDescriptorPool(m_descriptorPool);
+        device.destroyDescriptorSetLayout(m_descriptorSetLayout);
+    }
+
+    void DrawList::build(std::vector<std::unique_ptr<Model>> const& models, uint32_t const levelsDropped)
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        std::vector<DrawRecord> records;
+        uint32_t                indexCount = 0;
+
+        m_ranges.clear();
+        m_refitMeshlets.clear();
+
+        for (auto const& model : models)
+        {
+            auto const* mesh = model->mesh(levelsDropped);
+            if (!mesh || mesh->buffer(rhi::Mesh::BufferTypeIndex)->count() == 0)
+                continue;
+
+            // The bounds start as those of the mesh when it was made, and the refits grow them as strokes move the vertices.
+            auto const lo = mesh->bounds().getMin();
+            auto const hi = mesh->bounds().getMax();
+
+            DrawRecord record  = {};
+            record.model       = model->transform();
+            record.index_count = mesh->buffer(rhi::Mesh::BufferTypeIndex)->count();
+            record.first_index = indexCount;
+            record.positions   = mesh->buffer(rhi::Mesh::BufferTypeEditVertex)->deviceAddress();
+            record.colours     = mesh->buffer(rhi::Mesh::BufferTypeColour)->deviceAddress();
+            record.indices     = mesh->buffer(rhi::Mesh::BufferTypeIndex)->deviceAddress();
+
+            for (auto axis = 0; axis < 3; ++axis)
+            {
+                record.lo[axis] = floatToOrdered(lo[axis]);
+                record.hi[axis] = floatToOrdered(hi[axis]);
+            }
+
+            // Packed positions are quantized to a grid over the bounds whose spacing fits the whole model in 16 bits. Each
+            // meshlet is packed relative to its own corner of the grid, so strokes that move the vertices never leave it.
+            auto const extent      = hi - lo;
+            record.quantize_origin = lo;
+            record.quantize_step   = std::max(std::max(extent.x, std::max(extent.y, extent.z)) / 65535.0f, std::numeric_limits<float>::min());
+
+            // The room runs to the capacity of the mesh's buffers, which only dynamic topology leaves spare, and is rounded up
+            // so that the next record starts on an even index.
+            auto const indexCapacity = 3 * (mesh->indexCapacity() / 3);
+            m_ranges.push_back({ mesh, record.positions, static_cast<uint32_t>(records.size()), record.first_index, record.index_count, indexCapacity });
+
+            indexCount += indexCapacity + (indexCapacity & 1);
+            records.emplace_back(record);
+        }
+
+        // The frame being recorded may already have culled or drawn the previous buffers.
+        release(m_context->completedFrameValue());
+
+        Retired retired = { m_context->pendingFrameValue(), {}, std::exchange(m_descriptorPool, nullptr) };
+        for (auto* buffer : { &m_commands, &m_refitList, &m_shortIndices, &m_packedVertices, &m_meshlets, &m_records })
+        {
+            if (*buffer)
+                retired.buffers.emplace_back(std::move(*buffer));
+        }
+
+        if (retired.descriptorPool || !retired.buffers.empty())
+            m_retired.emplace_back(std::move(retired));
+
+        // Each record's triangles are split into meshlets in index order, and the meshlets over its spare room start empty;
+        // their bounds are left for the device to compute.
+        std::vector<DrawMeshlet> meshlets;
+        for (auto& range : m_ranges)
+        {
+            range.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+
+            auto const triangleCount    = range.indexCount / 3;
+            auto const triangleCapacity = range.indexCapacity / 3;
+            for (auto first = 0u; first < triangleCapacity; first += MESHLET_TRIANGLE_COUNT)
+            {
+                DrawMeshlet meshlet = {};
+                meshlet.record      = range.record;
+                meshlet.first_index = range.firstIndex + 3 * first;
+                meshlet.index_count = 3 * std::min(triangleCount - std::min(first, triangleCount), static_cast<uint32_t>(MESHLET_TRIANGLE_COUNT));
+                meshlets.emplace_back(meshlet);
+            }
+        }
+
+        m_drawCount    = static_cast<uint32_t>(records.size());
+        m_meshletCount = static_cast<uint32_t>(meshlets.size());
+        if (m_meshletCount == 0)
+        {
+            m_drawCount = 0;
+            m_ranges.clear();
+            return;
+        }
+
+        auto const memory = vk::MemoryPropertyFlagBits::eDeviceLocal;
+
+        // The packed vertices and 16-bit indices are written by the refits, with room for every meshlet's own run of vertices.
+        auto const usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+        m_packedVertices = std::make_unique<rhi::Buffer>(m_context, sizeof(DrawPackedVertex) * MESHLET_VERTEX_COUNT * meshlets.size(), usage, memory);
+        m_shortIndices   = std::make_unique<rhi::Buffer>(m_context, sizeof(uint32_t) * (indexCount / 2), vk::BufferUsageFlagBits::eIndexBuffer | usage, memory);
+
+        for (auto& record : records)
+            record.packed_vertices = m_packedVertices->deviceAddress();
+
+        m_records = std::make_unique<rhi::Buffer>(m_context,
+                                                  sizeof(DrawRecord) * records.size(),
+                                                  vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                                                  memory);
+        m_records->upload(records);
+
+        m_meshlets = std::make_unique<rhi::Buffer>(m_context,
+                                                   sizeof(DrawMeshlet) * meshlets.size(),
+                                                   vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                                                   memory);
+        m_meshlets->upload(meshlets);
+
+        // Patches list the meshlets to refit, each at most once.
+        m_refitList = std::make_unique<rhi::Buffer>(m_context,
+                                                    sizeof(uint32_t) * meshlets.size(),
+                                                    vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress |
+                                                        vk::BufferUsageFlagBits::eTransferDst,
+                                                    memory);
+
+        refit();
+
+        // The draw counts followed by room for a command per meshlet.
+        auto const commandUsage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst;
+        m_commands              = std::make_unique<rhi::Buffer>(m_context, s_commandsOffset + sizeof(DrawCommand) * meshlets.size(), commandUsage, memory);
+
+        std::vector<vk::DescriptorPoolSize> descriptorPoolSizes = { { vk::DescriptorType::eStorageBuffer, 3 } };
+        m_descriptorPool                                        = rhi::createDescriptorPool(device, descriptorPoolSizes);
+        m_descriptorSet = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_descriptorPool, m_descriptorSetLayout)).front();
+
+        std::vector<rhi::DescriptorUpdate> updateSet;
+        updateSet.emplace_back(vk::DescriptorType::eStorageBuffer, m_records->buffer(), VK_WHOLE_SIZE, vk::BufferView());
+        updateSet.emplace_back(vk::DescriptorType::eStorageBuffer, m_commands->buffer(), VK_WHOLE_SIZE, vk::BufferView());
+        updateSet.emplace_back(vk::DescriptorType::eStorageBuffer, m_meshlets->buffer(), VK_WHOLE_SIZE, vk::BufferView());
+        rhi::updateDescriptorSets(device, m_descriptorSet, updateSet);
+    }
+
+    auto DrawList::cull(Camera const* camera, vk::CommandBuffer const& commandBuffer) -> bool
+    {
+        if (!m_retired.empty())
+            release(m_context->completedFrameValue());
+
+        if (m_drawCount == 0)
+            return false;
+
+        // Only the refits read the edit streams; the draw reads the packed vertices that they write.
+        auto isReadingEdits = false;
+
+        // Extract the side planes of the frustum; the near and far planes are ignored, as the side planes alone reject
+        // everything behind the eye.
+        auto const& m         = camera->viewProjection();
+        auto const  row       = [&m](int const i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+        CullUniform uniform   = {};
+        uniform.planes[0]     = row(3) + row(0);
+        uniform.planes[1]     = row(3) - row(0);
+        uniform.planes[2]     = row(3) + row(1);
+        uniform.planes[3]     = row(3) - row(1);
+        uniform.eye           = camera->eye();
+        uniform.meshlet_count = m_meshletCount;
+
+        // The vertices may have been moved by strokes, and the previous frame's cull and draw may still be reading the bounds
+        // and packed vertices.
+        if (m_refitRegion && m_refitRegion->w < 0.0f)
+            m_refitMeshlets.clear();
+
+        if (m_refitRegion || !m_refitMeshlets.empty())
+        {
+            isReadingEdits = true;
+
+            // The list is written inline, once the previous frame's refit has read it.
+            if (!m_refitMeshlets.empty())
+            {
+                std::ranges::sort(m_refitMeshlets);
+                m_refitMeshlets.erase(std::unique(m_refitMeshlets.begin(), m_refitMeshlets.end()), m_refitMeshlets.end());
+
+                auto const listBarrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eComputeShader,
+                                                            vk::AccessFlagBits2::eNone,
+                                                            vk::PipelineStageFlagBits2::eTransfer,
+                                                            vk::AccessFlagBits2::eTransferWrite);
+                commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, listBarrier, {}, {}));
+
+                for (size_t first = 0; first < m_refitMeshlets.size(); first += s_updateLimit)
+                {
+                    auto const count = std::min(m_refitMeshlets.size() - first, s_updateLimit);
+                    commandBuffer.updateBuffer(m_refitList->buffer(), sizeof(uint32_t) * first, sizeof(uint32_t) * count, m_refitMeshlets.data() + first);
+                }
+            }
+
+            auto const refitSources = vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eTransfer |
+                                      vk::PipelineStageFlagBits2::eIndexInput | vk::PipelineStageFlagBits2::eVertexShader;
+            auto const refitBarrier = vk::MemoryBarrier2(refitSources,
+                                                         vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eTransferWrite,
+                                                         vk::PipelineStageFlagBits2::eComputeShader,
+                                                         vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite);
+            commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, refitBarrier, {}, {}));
+
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_refitPipeline);
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_refitPipelineLayout, 0, m_descriptorSet, nullptr);
+
+            auto const shortIndices = m_shortIndices->deviceAddress();
+            if (m_refitRegion)
+            {
+                MeshletRefitUniform refit = { *std::exchange(m_refitRegion, std::nullopt), m_meshletCount, 0, shortIndices, 0 };
+                commandBuffer.pushConstants(m_refitPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(MeshletRefitUniform), &refit);
+                commandBuffer.dispatch((m_meshletCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+                // Both refits may write a meshlet that is listed and within the region.
+                if (!m_refitMeshlets.empty())
+                {
+                    auto const computeBarrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eComputeShader,
+                                                                   vk::AccessFlagBits2::eShaderStorageWrite,
+                                                                   vk::PipelineStageFlagBits2::eComputeShader,
+                                                                   vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite);
+                    commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, computeBarrier, {}, {}));
+                }
+            }
+
+            if (!m_refitMeshlets.empty())
+            {
+                auto const          count = static_cast<uint32_t>(m_refitMeshlets.size());
+                MeshletRefitUniform refit = { glm::vec4(0.0f, 0.0f, 0.0f, -1.0f), count, 0, shortIndices, m_refitList->deviceAddress() };
+                commandBuffer.pushConstants(m_refitPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(MeshletRefitUniform), &refit);
+                commandBuffer.dispatch((count + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+                m_refitMeshlets.clear();
+            }
+        }
+
+        // The previous frame's draw must have read the commands before the count is reset.
+        auto const resetBarrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eDrawIndirect,
+                                                     vk::AccessFlagBits2::eIndirectCommandRead,
+                                                     vk::PipelineStageFlagBits2::eTransfer,
+                                                     vk::AccessFlagBits2::eTransferWrite);
+        commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, resetBarrier, {}, {}));
+        commandBuffer.fillBuffer(m_commands->buffer(), 0, sizeof(DrawCounts), 0);
+
+        auto const cullBarrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eTransfer | vk::PipelineStageFlagBits2::eComputeShader,
+                                                    vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eShaderStorageWrite,
+                                                    vk::PipelineStageFlagBits2::eComputeShader,
+                                                    vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite);
+        commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, cullBarrier, {}, {}));
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, nullptr);
+        commandBuffer.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullUniform), &uniform);
+        commandBuffer.dispatch((m_meshletCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+        // The draw also reads the vertices, indices and records that the refit may have written.
+        auto const drawBarrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eComputeShader,
+                                                    vk::AccessFlagBits2::eShaderStorageWrite,
+                                                    vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eIndexInput |
+                                                        vk::PipelineStageFlagBits2::eVertexShader,
+                                                    vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eIndexRead |
+                                                        vk::AccessFlagBits2::eShaderStorageRead);
+        commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, drawBarrier, {}, {}));
+
+        return isReadingEdits;
+    }
+
+    void DrawList::release(uint64_t const completedValue)
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        std::erase_if(m_retired,
+                      [&](Retired const& retired)
+                      {
+                          if (retired.frameValue > completedValue)
+                              return false;
+
+                          if (retired.descriptorPool)
+                              device.destroyDescriptorPool(retired.descriptorPool);
+
+                          return true;
+                      });
+    }
+
+    void DrawList::refit(glm::vec3 const& centre, float const radius)
+    {
+        if (!m_refitRegion)
+        {
+            m_refitRegion = glm::vec4(centre, radius);
+            return;
+        }
+
+        // Everything is already flagged.
+        if (m_refitRegion->w < 0.0f)
+            return;
+
+        // The smallest sphere around both.
+        auto const previous = glm::vec3(*m_refitRegion);
+        auto const distance = glm::distance(previous, centre);
+        if (distance + radius <= m_refitRegion->w)
+            return;
+
+        if (distance + m_refitRegion->w <= radius)
+        {
+            m_refitRegion = glm::vec4(centre, radius);
+            return;
+        }
+
+        auto const merged = 0.5f * (distance + radius + m_refitRegion->w);
+        m_refitRegion     = glm::vec4(previous + (centre - previous) * ((merged - m_refitRegion->w) / distance), merged);
+    }
+
+    auto DrawList::update(rhi::Mesh const* mesh, std::span<glm::uvec2 const> const triangles) -> bool
+    {
+        auto const range = std::ranges::find(m_ranges, mesh, &RecordRange::mesh);
+        if (range == m_ranges.end())
+            return false;
+
+        auto const indexCount = mesh->buffer(rhi::Mesh::BufferTypeIndex)->count();
+        if (range->positions != mesh->buffer(rhi::Mesh::BufferTypeEditVertex)->deviceAddress() || indexCount > range->indexCapacity)
+            return false;
+
+        // The refits read the triangles from the mesh's own indices, and write the meshlets' 16-bit indices from them.
+        auto const meshletSize = 3u * MESHLET_TRIANGLE_COUNT;
+
+        for (auto const& run : triangles)
+        {
+            for (auto meshlet = run.x / MESHLET_TRIANGLE_COUNT; meshlet <= (run.x + run.y - 1) / MESHLET_TRIANGLE_COUNT; ++meshlet)
+                m_refitMeshlets.emplace_back(range->firstMeshlet + meshlet);
+        }
+
+        // Triangles added beyond the end lengthen the last meshlets into the room that was reserved for them.
+        if (indexCount != range->indexCount)
+        {
+            auto const first = std::min(indexCount, range->indexCount) / meshletSize;
+            auto const last  = (std::max(indexCount, range->indexCount) - 1) / meshletSize;
+
+            for (auto meshlet = first; meshlet <= last; ++meshlet)
+            {
+                auto const start = meshletSize * meshlet;
+                auto const count = std::min(indexCount - std::min(start, indexCount), meshletSize);
+                m_meshlets->upload(&count, sizeof(count), sizeof(DrawMeshlet) * (range->firstMeshlet + meshlet) + offsetof(DrawMeshlet, index_count));
+                m_refitMeshlets.emplace_back(range->firstMeshlet + meshlet);
+            }
+
+            m_records->upload(&indexCount, sizeof(indexCount), sizeof(DrawRecord) * range->record + offsetof(DrawRecord, index_count));
+            range->indexCount = indexCount;
+        }
+
+        return true;
+    }
+
+    void DrawList::render(vk::CommandBuffer const& commandBuffer, vk::PipelineLayout const& pipelineLayout) const
+    {
+        if (m_drawCount == 0)
+            return;
+
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 1, m_descriptorSet, nullptr);
+        commandBuffer.bindIndexBuffer(m_shortIndices->buffer(), 0, vk::IndexType::eUint16);
+        commandBuffer.drawIndexedIndirectCount(m_commands->buffer(), s_commandsOffset, m_commands->buffer(), 0, m_meshletCount, sizeof(DrawCommand));
+    }
+} // namespace com::scene
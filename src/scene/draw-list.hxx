@@ -0,0 +1,145 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include "rhi/shaders/uniforms.hxx"
+#include "rhi/shaders/draw.hxx"
+#include "scene/model.hxx"
+
+#include <optional>
+
+namespace com::scene
+{
+    /// Draws a set of models with a single indirect draw, culled against the camera's frustum on the GPU.
+    ///
+    /// Each model has a record holding its transform, bounds and the device addresses of its streams. Its indices are split
+    /// into meshlets of MESHLET_TRIANGLE_COUNT triangles, each with a bounding sphere and a cone around its normals. Every
+    /// frame a compute pass writes a draw command for each meshlet that is within the frustum and faces the eye, so the CPU
+    /// cost of drawing is the same for one model as for thousands, and the GPU only processes the triangles that can be seen.
+    /// The meshlets' bounds are computed on the device, and are refit wherever strokes move the vertices, growing the bounds
+    /// of their models as they go.
+    ///
+    /// Models are drawn from compressed vertex streams: each meshlet has its own run of 8-byte packed vertices, whose positions
+    /// are quantized to 16 bits on a grid over its model relative to the meshlet's corner, and whose colours are packed to 16
+    /// bits, so that its indices always fit in 16 bits. The packed vertices and indices are regenerated along with the bounds
+    /// of the meshlets that strokes touch, while the brush keeps editing the full-precision streams.
+    ///
+    /// Each record reserves room in the index buffer, and meshlets, for as many triangles as its mesh's buffers can hold, so
+    /// that dynamic topology patches the triangles that it rewrites or adds in place, and only the meshlets holding them are
+    /// refit; the list is only rebuilt when the mesh's buffers grow.
+    class DrawList final
+    {
+    public:
+        /// Constructor.
+        /// \param context The RHI context.
+        explicit DrawList(rhi::Context* context);
+
+        /// Destructor.
+        ~DrawList();
+
+        /// Build the records and meshlets, and flag every meshlet to be refit, which writes the packed vertices and indices. The
+        /// uploads are recorded on the context's staging ring. The previous buffers are kept until the frames that may draw them
+        /// have completed, so the list can be rebuilt with frames in flight.
+        /// \param models The models to draw.
+        /// \param levelsDropped The number of multiresolution levels below the sculpted one to draw subdivided models at.
+        void build(std::vector<std::unique_ptr<Model>> const& models, uint32_t const levelsDropped = 0);
+
+        /// Record the compute pass that culls the meshlets and writes the draw commands, after refitting the bounds of any
+        /// meshlets that have been flagged.
+        /// \param camera The camera.
+        /// \param commandBuffer The command buffer, which must not be within a render pass.
+        /// \return true if the frame reads the models' edit vertices or colours to refit the meshlets; false if it only reads the
+        /// packed streams.
+        auto cull(Camera const* camera, vk::CommandBuffer const& commandBuffer) -> bool;
+
+        /// Accessor.
+        /// \return A valid Vulkan object.
+        [[nodiscard]] auto descriptorSetLayout() const
+        {
+            return m_descriptorSetLayout;
+        }
+
+        /// Get the number of records.
+        /// \return A valid integer.
+        [[nodiscard]] auto drawCount() const
+        {
+            return m_drawCount;
+        }
+
+        /// Patch the list after dynamic topology has rewritten or added some of a mesh's triangles, and flag the meshlets that hold
+        /// them to be refit before the next cull. The uploads are recorded on the context's staging ring, which must not run them
+        /// while frames that draw the list are in flight.
+        /// \param mesh The mesh, whose buffers must have been uploaded through the ring.
+        /// \param triangles The runs of triangles that changed, as the first and the count of each.
+        /// \return true if the list was patched; false if it must be rebuilt, as the mesh's buffers have been replaced, or it has
+        /// outgrown the room that the list reserved for it.
+        auto update(rhi::Mesh const* mesh, std::span<glm::uvec2 const> const triangles) -> bool;
+
+        /// Flag the bounds of every meshlet to be refit before the next cull.
+        void refit()
+        {
+            m_refitRegion = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+        }
+
+        /// Flag the bounds of the meshlets that touch a world-space sphere to be refit before the next cull. The spheres flagged
+        /// before then are merged.
+        /// \param centre The centre of the sphere.
+        /// \param radius The radius of the sphere.
+        void refit(glm::vec3 const& centre, float const radius);
+
+        /// Draw the models that survived culling.
+        /// \param commandBuffer The command buffer.
+        /// \param pipelineLayout The layout of the bound pipeline, whose second set is the draw list's.
+        void render(vk::CommandBuffer const& commandBuffer, vk::PipelineLayout const& pipelineLayout) const;
+
+    private:
+        /// The buffers and descriptor pool of a previous build, which frames in flight may still read.
+        struct Retired final
+        {
+            uint64_t                                  frameValue = 0; ///< The value of the last frame that may read them.
+            std::vector<std::unique_ptr<rhi::Buffer>> buffers;        ///< The buffers.
+            vk::DescriptorPool                        descriptorPool; ///< The descriptor pool, and so the set.
+        };
+
+        /// Where a mesh's record, indices and meshlets were placed when the list was built.
+        struct RecordRange final
+        {
+            rhi::Mesh const*  mesh          = nullptr; ///< The mesh.
+            vk::DeviceAddress positions     = 0;       ///< The address of the mesh's edit vertices, which change if it grows.
+            uint32_t          record        = 0;       ///< The index of the record.
+            uint32_t          firstIndex    = 0;       ///< The offset of the mesh's indices in the index buffer.
+            uint32_t          indexCount    = 0;       ///< The number of indices in use.
+            uint32_t          indexCapacity = 0;       ///< The number of indices that there is room for.
+            uint32_t          firstMeshlet  = 0;       ///< The index of the first meshlet.
+        };
+
+    private:
+        void release(uint64_t const completedValue);
+
+    private:
+        rhi::Context*                m_context = nullptr;
+        std::unique_ptr<rhi::Buffer> m_records;
+        std::unique_ptr<rhi::Buffer> m_commands;
+        std::unique_ptr<rhi::Buffer> m_meshlets;
+        std::unique_ptr<rhi::Buffer> m_packedVertices;
+        std::unique_ptr<rhi::Buffer> m_shortIndices;
+        std::unique_ptr<rhi::Buffer> m_refitList;
+        vk::DescriptorSetLayout      m_descriptorSetLayout;
+        vk::DescriptorPool           m_descriptorPool;
+        vk::DescriptorSet            m_descriptorSet;
+        vk::PipelineLayout           m_pipelineLayout;
+        vk::ShaderModule             m_shader;
+        vk::Pipeline                 m_pipeline;
+        vk::PipelineLayout           m_refitPipelineLayout;
+        vk::ShaderModule             m_refitShader;
+        vk::Pipeline                 m_refitPipeline;
+        uint32_t                     m_drawCount    = 0;
+        uint32_t                     m_meshletCount = 0;
+        std::optional<glm::vec4>     m_refitRegion;
+        std::vector<uint32_t>        m_refitMeshlets;
+        std::vector<RecordRange>     m_ranges;
+        std::vector<Retired>         m_retired;
+    };
+} // namespace com::scene
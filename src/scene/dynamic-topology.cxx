@@ -0,0 +1,563 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "scene/dynamic-topology.hxx"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <limits>
+
+namespace com::scene
+{
+    /// Edges shorter than this fraction of the detail size are collapsed. It is below a half, so that the halves of an edge
+    /// that has just been split are not collapsed straight back.
+    static constexpr float s_collapseRatio = 0.4f;
+
+    /// The most splits and collapses that one update makes, which bounds its cost when the detail size is much smaller than the
+    /// mesh's edges; later updates carry on where it left off.
+    static constexpr uint32_t s_maxEdits = 4096;
+
+    /// The factor by which the mesh's buffers grow beyond what is needed, so that they are rarely replaced.
+    static constexpr float s_growthFactor = 1.5f;
+
+    /// The size of the grid's cells relative to the mesh's mean edge length when the topology is built.
+    static constexpr float s_cellEdgeRatio = 4.0f;
+
+    /// The longest gap between the vertices in a region that is read across rather than starting another run.
+    static constexpr uint32_t s_runGap = 16;
+
+    /// Marks a vertex that is in no cell.
+    static constexpr uint64_t s_noCell = std::numeric_limits<uint64_t>::max();
+
+    /// Pack the coordinates of a cell into a key, 21 bits to an axis.
+    /// \param cell The cell.
+    /// \return The key.
+    [[nodiscard]] static auto cellKey(glm::ivec3 const& cell)
+    {
+        auto const mask = (uint64_t(1) << 21) - 1;
+        return ((static_cast<uint64_t>(cell.x) & mask) << 42) | ((static_cast<uint64_t>(cell.y) & mask) << 21) | (static_cast<uint64_t>(cell.z) & mask);
+    }
+
+    /// Find the squared distance from a point to a segment.
+    /// \param point The point.
+    /// \param from One end of the segment.
+    /// \param to The other end of the segment.
+    /// \return The squared distance.
+    [[nodiscard]] static auto segmentDistanceSqrd(glm::vec3 const& point, glm::vec3 const& from, glm::vec3 const& to)
+    {
+        auto const direction  = to - from;
+        auto const lengthSqrd = glm::dot(direction, direction);
+        auto const t          = lengthSqrd > 0.0f ? glm::clamp(glm::dot(point - from, direction) / lengthSqrd, 0.0f, 1.0f) : 0.0f;
+        auto const offset     = point - (from + t * direction);
+        return glm::dot(offset, offset);
+    }
+
+    /// Determines if a triangle slot has been removed.
+    [[nodiscard]] static auto isRemoved(glm::uvec3 const& triangle)
+    {
+        return triangle.x == triangle.y;
+    }
+
+    /// Average two packed RGBA8 colours. Each channel is halved before the sum, so that none carries into the next.
+    [[nodiscard]] static auto mixColours(uint32_t const a, uint32_t const b)
+    {
+        return ((a >> 1) & 0x7f7f7f7fu) + ((b >> 1) & 0x7f7f7f7fu);
+    }
+
+    /// Call a function for each run of consecutive slots, then clear the slots.
+    template <typename Function>
+    static void forEachRun(std::vector<uint32_t>& slots, Function const& function)
+    {
+        std::ranges::sort(slots);
+        auto const end = std::unique(slots.begin(), slots.end());
+
+        for (auto first = slots.begin(); first != end;)
+        {
+            auto last = std::next(first);
+            while (last != end && *last == *std::prev(last) + 1)
+                ++last;
+
+            function(*first, static_cast<uint32_t>(std::distance(first, last)));
+            first = last;
+        }
+
+        slots.clear();
+    }
+
+    DynamicTopology::DynamicTopology(std::span<glm::vec3 const> const positions,
+                                     std::span<uint32_t const> const  indices,
+                                     std::span<uint32_t const> const  colours)
+        : m_positions(positions.begin(), positions.end()),
+          m_colours(colours.begin(), colours.end()),
+          m_vertexTriangles(positions.size()),
+          m_vertexCells(positions.size(), s_noCell)
+    {
+        m_triangles.reserve(indices.size() / 3);
+
+        auto edgeLengths = 0.0;
+        auto edgeCount   = 0u;
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            auto const triangle = static_cast<uint32_t>(m_triangles.size());
+            auto const corners  = glm::uvec3(indices[i], indices[i + 1], indices[i + 2]);
+
+            m_triangles.emplace_back(corners);
+
+            if (isRemoved(corners))
+            {
+                m_freeTriangles.emplace_back(triangle);
+                continue;
+            }
+
+            for (auto corner = 0; corner < 3; ++corner)
+            {
+                m_vertexTriangles[corners[corner]].emplace_back(triangle);
+                edgeLengths += glm::distance(m_positions[corners[corner]], m_positions[corners[(corner + 1) % 3]]);
+                ++edgeCount;
+            }
+        }
+
+        // The cells are sized so that the brush covers a few of them across; they don't follow the detail size as it changes.
+        auto const meanEdgeLength = edgeCount > 0 ? static_cast<float>(edgeLengths / edgeCount) : 0.0f;
+        m_cellSize                = meanEdgeLength > 0.0f ? s_cellEdgeRatio * meanEdgeLength : 1.0f;
+
+        for (auto vertex = 0u; vertex < m_positions.size(); ++vertex)
+            placeVertex(vertex);
+
+        // Vertices that no triangle uses, e.g., those collapsed before the mesh was saved, are reused like any other.
+        for (auto vertex = 0u; vertex < m_vertexTriangles.size(); ++vertex)
+        {
+            if (m_vertexTriangles[vertex].empty())
+                m_freeVertices.emplace_back(vertex);
+        }
+    }
+
+    auto DynamicTopology::update(glm::vec3 const& centre, float const radius, float const detailSize) -> bool
+    {
+        auto const splitLengthSqrd    = detailSize * detailSize;
+        auto const collapseLengthSqrd = splitLengthSqrd * s_collapseRatio * s_collapseRatio;
+        auto       edits              = 0u;
+
+        // Edges are split longest first, and the halves are revisited by the next pass until none is too long.
+        while (edits < s_maxEdits)
+        {
+            auto candidates = edges(centre, radius, splitLengthSqrd, std::numeric_limits<float>::max());
+            if (candidates.empty())
+                break;
+
+            std::ranges::sort(candidates, std::ranges::greater(), &Edge::lengthSqrd);
+
+            for (auto const& edge : candidates)
+            {
+                if (edits == s_maxEdits)
+                    break;
+
+                // A neighbouring split may have already split the edge.
+                if (edgeTriangles(edge.a, edge.b).empty())
+                    continue;
+
+                split(edge.a, edge.b);
+                ++edits;
+            }
+        }
+
+        // Edges are collapsed shortest first, skipping those that earlier collapses have removed or lengthened.
+        auto candidates = edges(centre, radius, 0.0f, collapseLengthSqrd);
+        std::ranges::sort(candidates, std::ranges::less(), &Edge::lengthSqrd);
+
+        for (auto const& edge : candidates)
+        {
+            if (edits == s_maxEdits)
+                break;
+
+            if (m_vertexTriangles[edge.a].empty() || m_vertexTriangles[edge.b].empty())
+                continue;
+
+            auto const offset = m_positions[edge.a] - m_positions[edge.b];
+            if (glm::dot(offset, offset) > collapseLengthSqrd)
+                continue;
+
+            if (collapse(edge.a, edge.b))
+                ++edits;
+        }
+
+        return edits > 0;
+    }
+
+    void DynamicTopology::setVertices(std::span<glm::vec3 const> const positions, std::span<uint32_t const> const colours)
+    {
+        auto const run = glm::uvec2(0, std::min(m_positions.size(), std::min(positions.size(), colours.size())));
+        setVertices(std::span(&run, 1), positions, colours);
+    }
+
+    void DynamicTopology::setVertices(std::span<glm::uvec2 const> const runs, std::span<glm::vec3 const> const positions, std::span<uint32_t const> const colours)
+    {
+        auto offset = 0u;
+
+        for (auto const& run : runs)
+        {
+            for (auto vertex = run.x; vertex < run.x + run.y; ++vertex, ++offset)
+            {
+                m_colours[vertex] = colours[offset];
+                if (m_positions[vertex] == positions[offset])
+                    continue;
+
+                m_positions[vertex] = positions[offset];
+                placeVertex(vertex);
+            }
+        }
+    }
+
+    auto DynamicTopology::upload(rhi::Mesh* mesh, std::vector<glm::uvec2>& triangles) -> bool
+    {
+        auto const vertexCount = this->vertexCount();
+        auto const indexCount  = 3 * triangleCount();
+        auto const isReplaced  = vertexCount > mesh->vertexCapacity() || indexCount > mesh->indexCapacity();
+
+        if (isReplaced)
+        {
+            mesh->reserve(static_cast<uint32_t>(s_growthFactor * static_cast<float>(vertexCount)),
+                          static_cast<uint32_t>(s_growthFactor * static_cast<float>(indexCount)));
+        }
+
+        auto* indices = mesh->buffer(rhi::Mesh::BufferTypeIndex);
+        auto* base    = mesh->buffer(rhi::Mesh::BufferTypeBaseVertex);
+        auto* edit    = mesh->buffer(rhi::Mesh::BufferTypeEditVertex);
+        auto* colours = mesh->buffer(rhi::Mesh::BufferTypeColour);
+
+        // New vertices start with the same base and edited positions, as the mesh's own vertices do.
+        forEachRun(m_dirtyVertices,
+                   [&](uint32_t const first, uint32_t const count)
+                   {
+                       auto const positions = std::span(m_positions).subspan(first, count);
+                       base->upload(sizeof(glm::vec3) * first, positions);
+                       edit->upload(sizeof(glm::vec3) * first, positions);
+                       colours->upload(sizeof(uint32_t) * first, std::span(m_colours).subspan(first, count));
+                   });
+
+        triangles.clear();
+        forEachRun(m_dirtyTriangles,
+                   [&](uint32_t const first, uint32_t const count)
+                   {
+                       indices->upload(sizeof(glm::uvec3) * first, std::span(m_triangles).subspan(first, count));
+                       triangles.emplace_back(first, count);
+                   });
+
+        mesh->setCounts(vertexCount, indexCount);
+        return isReplaced;
+    }
+
+    auto DynamicTopology::vertexRuns(glm::vec3 const& from, glm::vec3 const& to, float const radius) const -> std::vector<glm::uvec2>
+    {
+        auto vertices = verticesNear(from, to, radius);
+        std::ranges::sort(vertices);
+
+        std::vector<glm::uvec2> result;
+        for (auto const vertex : vertices)
+        {
+            if (!result.empty() && vertex <= result.back().x + result.back().y + s_runGap)
+                result.back().y = vertex + 1 - result.back().x;
+            else
+                result.emplace_back(vertex, 1);
+        }
+
+        return result;
+    }
+
+    auto DynamicTopology::addTriangle(glm::uvec3 const& triangle) -> uint32_t
+    {
+        uint32_t slot = 0;
+
+        if (m_freeTriangles.empty())
+        {
+            slot = static_cast<uint32_t>(m_triangles.size());
+            m_triangles.emplace_back(triangle);
+        }
+        else
+        {
+            slot = m_freeTriangles.back();
+            m_freeTriangles.pop_back();
+            m_triangles[slot] = triangle;
+        }
+
+        for (auto corner = 0; corner < 3; ++corner)
+            m_vertexTriangles[triangle[corner]].emplace_back(slot);
+
+        m_dirtyTriangles.emplace_back(slot);
+        return slot;
+    }
+
+    auto DynamicTopology::addVertex(glm::vec3 const& position, uint32_t const colour) -> uint32_t
+    {
+        uint32_t slot = 0;
+
+        if (m_freeVertices.empty())
+        {
+            slot = static_cast<uint32_t>(m_positions.size());
+            m_positions.emplace_back(position);
+            m_colours.emplace_back(colour);
+            m_vertexTriangles.emplace_back();
+            m_vertexCells.emplace_back(s_noCell);
+        }
+        else
+        {
+            slot = m_freeVertices.back();
+            m_freeVertices.pop_back();
+            m_positions[slot] = position;
+            m_colours[slot]   = colour;
+        }
+
+        placeVertex(slot);
+        m_dirtyVertices.emplace_back(slot);
+        return slot;
+    }
+
+    auto DynamicTopology::collapse(uint32_t const a, uint32_t const b) -> bool
+    {
+        // Only interior edges of a manifold are collapsed, and only if the two vertices share no neighbours but the two opposite
+        // the edge; otherwise the surface would be pinched or torn.
+        auto const shared = edgeTriangles(a, b);
+        if (shared.size() != 2 || isBoundary(a) || isBoundary(b))
+            return false;
+
+        auto const            aNeighbours = neighbours(a);
+        auto const            bNeighbours = neighbours(b);
+        std::vector<uint32_t> common;
+        std::ranges::set_intersection(aNeighbours, bNeighbours, std::back_inserter(common));
+        if (common.size() != 2)
+            return false;
+
+        // The vertices meet at the middle of the edge, which must not turn any of the remaining triangles over.
+        auto const target = 0.5f * (m_positions[a] + m_positions[b]);
+
+        for (auto const vertex : { a, b })
+        {
+            for (auto const triangle : m_vertexTriangles[vertex])
+            {
+                if (std::ranges::find(shared, triangle) != shared.end())
+                    continue;
+
+                auto const&              corners = m_triangles[triangle];
+                std::array<glm::vec3, 3> before;
+                std::array<glm::vec3, 3> after;
+
+                for (auto corner = 0; corner < 3; ++corner)
+                {
+                    before[corner] = m_positions[corners[corner]];
+                    after[corner]  = corners[corner] == a || corners[corner] == b ? target : before[corner];
+                }
+
+                auto const normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                auto const normalAfter  = glm::cross(after[1] - after[0], after[2] - after[0]);
+                if (glm::dot(normalBefore, normalAfter) <= 0.0f)
+                    return false;
+            }
+        }
+
+        for (auto const triangle : shared)
+            removeTriangle(triangle);
+
+        // The list is copied, as moving each triangle to the surviving vertex removes it from the list being walked.
+        for (auto const triangle : std::vector(m_vertexTriangles[b]))
+        {
+            auto corners = m_triangles[triangle];
+            for (auto corner = 0; corner < 3; ++corner)
+            {
+                if (corners[corner] == b)
+                    corners[corner] = a;
+            }
+
+            setTriangle(triangle, corners);
+        }
+
+        m_positions[a] = target;
+        m_colours[a]   = mixColours(m_colours[a], m_colours[b]);
+        placeVertex(a);
+        m_dirtyVertices.emplace_back(a);
+        m_freeVertices.emplace_back(b);
+
+        return true;
+    }
+
+    auto DynamicTopology::edges(glm::vec3 const& centre, float const radius, float const minLengthSqrd, float const maxLengthSqrd) const
+        -> std::vector<Edge>
+    {
+        std::vector<Edge> result;
+
+        // An edge is a candidate if either end is within the sphere.
+        for (auto const vertex : verticesNear(centre, centre, radius))
+        {
+            for (auto const triangle : m_vertexTriangles[vertex])
+            {
+                auto const& corners = m_triangles[triangle];
+
+                for (auto corner = 0; corner < 3; ++corner)
+                {
+                    auto const a = corners[corner];
+                    auto const b = corners[(corner + 1) % 3];
+                    if (a != vertex && b != vertex)
+                        continue;
+
+                    auto const length     = m_positions[a] - m_positions[b];
+                    auto const lengthSqrd = glm::dot(length, length);
+                    if (lengthSqrd >= minLengthSqrd && lengthSqrd <= maxLengthSqrd)
+                        result.emplace_back(Edge{ std::min(a, b), std::max(a, b), lengthSqrd });
+                }
+            }
+        }
+
+        // Each edge is found from both of its triangles, and from both ends when they are both within the sphere.
+        auto const order = [](Edge const& lhs, Edge const& rhs) { return lhs.a != rhs.a ? lhs.a < rhs.a : lhs.b < rhs.b; };
+        auto const equal = [](Edge const& lhs, Edge const& rhs) { return lhs.a == rhs.a && lhs.b == rhs.b; };
+
+        std::ranges::sort(result, order);
+        result.erase(std::unique(result.begin(), result.end(), equal), result.end());
+
+        return result;
+    }
+
+    auto DynamicTopology::edgeTriangles(uint32_t const a, uint32_t const b) const -> std::vector<uint32_t>
+    {
+        std::vector<uint32_t> result;
+
+        for (auto const triangle : m_vertexTriangles[a])
+        {
+            auto const& corners = m_triangles[triangle];
+            if (corners.x == b || corners.y == b || corners.z == b)
+                result.emplace_back(triangle);
+        }
+
+        return result;
+    }
+
+    auto DynamicTopology::isBoundary(uint32_t const vertex) const -> bool
+    {
+        // Edges on a boundary have one triangle, and non-manifold edges more than two; either way the vertex is left alone.
+        return std::ranges::any_of(neighbours(vertex), [&](uint32_t const neighbour) { return edgeTriangles(vertex, neighbour).size() != 2; });
+    }
+
+    auto DynamicTopology::neighbours(uint32_t const vertex) const -> std::vector<uint32_t>
+    {
+        std::vector<uint32_t> result;
+
+        for (auto const triangle : m_vertexTriangles[vertex])
+        {
+            for (auto corner = 0; corner < 3; ++corner)
+            {
+                if (m_triangles[triangle][corner] != vertex)
+                    result.emplace_back(m_triangles[triangle][corner]);
+            }
+        }
+
+        std::ranges::sort(result);
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+
+        return result;
+    }
+
+    void DynamicTopology::placeVertex(uint32_t const vertex)
+    {
+        auto const key = cellKey(glm::ivec3(glm::floor(m_positions[vertex] / m_cellSize)));
+        auto&      old = m_vertexCells[vertex];
+        if (key == old)
+            return;
+
+        if (old != s_noCell)
+        {
+            auto const cell = m_cells.find(old);
+            std::erase(cell->second, vertex);
+            if (cell->second.empty())
+                m_cells.erase(cell);
+        }
+
+        m_cells[key].emplace_back(vertex);
+        old = key;
+    }
+
+    void DynamicTopology::removeTriangle(uint32_t const triangle)
+    {
+        auto const corners = m_triangles[triangle];
+        for (auto corner = 0; corner < 3; ++corner)
+            std::erase(m_vertexTriangles[corners[corner]], triangle);
+
+        m_triangles[triangle] = glm::uvec3(0);
+        m_freeTriangles.emplace_back(triangle);
+        m_dirtyTriangles.emplace_back(triangle);
+    }
+
+    void DynamicTopology::setTriangle(uint32_t const triangle, glm::uvec3 const& corners)
+    {
+        auto const previous = m_triangles[triangle];
+        for (auto corner = 0; corner < 3; ++corner)
+            std::erase(m_vertexTriangles[previous[corner]], triangle);
+
+        m_triangles[triangle] = corners;
+        for (auto corner = 0; corner < 3; ++corner)
+            m_vertexTriangles[corners[corner]].emplace_back(triangle);
+
+        m_dirtyTriangles.emplace_back(triangle);
+    }
+
+    void DynamicTopology::split(uint32_t const a, uint32_t const b)
+    {
+        auto const triangles = edgeTriangles(a, b);
+        auto const middle    = addVertex(0.5f * (m_positions[a] + m_positions[b]), mixColours(m_colours[a], m_colours[b]));
+
+        for (auto const triangle : triangles)
+        {
+            // The corners are rotated so that the edge comes first, and each half keeps the triangle's winding.
+            auto corners = m_triangles[triangle];
+            while ((corners.x != a && corners.x != b) || (corners.y != a && corners.y != b))
+                corners = glm::uvec3(corners.y, corners.z, corners.x);
+
+            setTriangle(triangle, glm::uvec3(corners.x, middle, corners.z));
+            addTriangle(glm::uvec3(middle, corners.y, corners.z));
+        }
+    }
+
+    auto DynamicTopology::verticesNear(glm::vec3 const& from, glm::vec3 const& to, float const radius) const -> std::vector<uint32_t>
+    {
+        auto const            radiusSqrd = radius * radius;
+        std::vector<uint32_t> result;
+
+        // Removed vertices keep their cells until they are reused, and are skipped.
+        auto const visit = [&](std::vector<uint32_t> const& vertices)
+        {
+            for (auto const vertex : vertices)
+            {
+                if (!m_vertexTriangles[vertex].empty() && segmentDistanceSqrd(m_positions[vertex], from, to) <= radiusSqrd)
+                    result.emplace_back(vertex);
+            }
+        };
+
+        auto const lo = glm::ivec3(glm::floor((glm::min(from, to) - radius) / m_cellSize));
+        auto const hi = glm::ivec3(glm::floor((glm::max(from, to) + radius) / m_cellSize));
+
+        // A region that spans more cells than are occupied walks the occupied ones instead.
+        auto const span = glm::dvec3(hi - lo + 1);
+        if (span.x * span.y * span.z > static_cast<double>(m_cells.size()))
+        {
+            for (auto const& [key, vertices] : m_cells)
+                visit(vertices);
+
+            return result;
+        }
+
+        for (auto z = lo.z; z <= hi.z; ++z)
+        {
+            for (auto y = lo.y; y <= hi.y; ++y)
+            {
+                for (auto x = lo.x; x <= hi.x; ++x)
+                {
+                    if (auto const cell = m_cells.find(cellKey(glm::ivec3(x, y, z))); cell != m_cells.end())
+                        visit(cell->second);
+                }
+            }
+        }
+
+        return result;
+    }
+} // namespace com::scene
@@ -0,0 +1,119 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include "rhi/mesh.hxx"
+
+#include <glm/glm.hpp>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace com::scene
+{
+    /// Adapts a mesh's triangles to a detail size under the brush, so that the mesh only gains triangles where it is sculpted.
+    ///
+    /// Edges within the brush that are longer than the detail size are split and those much shorter than it are collapsed.
+    /// The topology is edited on a copy kept on the CPU, and the mesh's buffers serve as pools: they grow geometrically, the
+    /// slots of collapsed vertices and triangles are reused before they grow, and only the slots that changed are uploaded.
+    /// A removed triangle is left in place with all its indices equal, so that it rasterises to nothing.
+    ///
+    /// The vertices are bucketed in a sparse grid, so that finding the edges under the brush, and the vertices that a stroke
+    /// may have moved, costs in proportion to the region rather than the mesh.
+    class DynamicTopology final
+    {
+    public:
+        /// Constructor.
+        /// \param positions The vertex positions, which are copied.
+        /// \param indices Indices into the positions, three per triangle.
+        /// \param colours The colour of each vertex, which are copied.
+        explicit DynamicTopology(std::span<glm::vec3 const> const positions, std::span<uint32_t const> const indices, std::span<uint32_t const> const colours);
+
+        /// Adapt the edges within a sphere to a detail size.
+        /// \param centre The centre of the sphere.
+        /// \param radius The radius of the sphere.
+        /// \param detailSize The length that edges are adapted towards.
+        /// \return true if the topology changed; false otherwise.
+        auto update(glm::vec3 const& centre, float const radius, float const detailSize) -> bool;
+
+        /// Replace the vertices with those that strokes have since written on the device. Vertices that this has added must be
+        /// included, so they must have been uploaded first.
+        /// \param positions The vertex positions.
+        /// \param colours The colour of each vertex.
+        void setVertices(std::span<glm::vec3 const> const positions, std::span<uint32_t const> const colours);
+
+        /// Replace some of the vertices with those that strokes have since written on the device.
+        /// \param runs The runs of vertices, as the first and the count of each.
+        /// \param positions The positions of the vertices in the runs, one run after another.
+        /// \param colours The colours of the vertices in the runs, one run after another.
+        void setVertices(std::span<glm::uvec2 const> const runs, std::span<glm::vec3 const> const positions, std::span<uint32_t const> const colours);
+
+        /// Accessor.
+        /// \return The number of triangle slots, including those that have been removed.
+        [[nodiscard]] auto triangleCount() const
+        {
+            return static_cast<uint32_t>(m_triangles.size());
+        }
+
+        /// Upload the vertices and triangles that have changed, growing the mesh's buffers if they are too small. The copies are
+        /// recorded on the context's staging ring, which must not run them while the device is using the mesh.
+        /// \param mesh The mesh that this was built from.
+        /// \param triangles Receives the runs of triangles that were uploaded, as the first and the count of each.
+        /// \return true if the mesh's buffers were replaced, so that anything that refers to them must be rebuilt; false otherwise.
+        auto upload(rhi::Mesh* mesh, std::vector<glm::uvec2>& triangles) -> bool;
+
+        /// Accessor.
+        /// \return The number of vertex slots, including those that have been removed.
+        [[nodiscard]] auto vertexCount() const
+        {
+            return static_cast<uint32_t>(m_positions.size());
+        }
+
+        /// Find the vertices within a capsule, e.g., those that a stroke may have moved. Nearby runs are merged, as reading a few
+        /// vertices more is cheaper than another copy.
+        /// \param from The centre of one end of the capsule.
+        /// \param to The centre of the other end of the capsule.
+        /// \param radius The radius of the capsule.
+        /// \return The runs of vertices, as the first and the count of each, in order.
+        [[nodiscard]] auto vertexRuns(glm::vec3 const& from, glm::vec3 const& to, float const radius) const -> std::vector<glm::uvec2>;
+
+    private:
+        /// An edge that is a candidate for a split or a collapse.
+        struct Edge final
+        {
+            uint32_t a          = 0; ///< The lower vertex.
+            uint32_t b          = 0; ///< The higher vertex.
+            float    lengthSqrd = 0; ///< The squared length.
+        };
+
+    private:
+        auto               addTriangle(glm::uvec3 const& triangle) -> uint32_t;
+        auto               addVertex(glm::vec3 const& position, uint32_t const colour) -> uint32_t;
+        auto               collapse(uint32_t const a, uint32_t const b) -> bool;
+        [[nodiscard]] auto edges(glm::vec3 const& centre, float const radius, float const minLengthSqrd, float const maxLengthSqrd) const -> std::vector<Edge>;
+        [[nodiscard]] auto edgeTriangles(uint32_t const a, uint32_t const b) const -> std::vector<uint32_t>;
+        [[nodiscard]] auto isBoundary(uint32_t const vertex) const -> bool;
+        [[nodiscard]] auto neighbours(uint32_t const vertex) const -> std::vector<uint32_t>;
+        void               placeVertex(uint32_t const vertex);
+        void               removeTriangle(uint32_t const triangle);
+        void               setTriangle(uint32_t const triangle, glm::uvec3 const& corners);
+        void               split(uint32_t const a, uint32_t const b);
+        [[nodiscard]] auto verticesNear(glm::vec3 const& from, glm::vec3 const& to, float const radius) const -> std::vector<uint32_t>;
+
+    private:
+        std::vector<glm::vec3>             m_positions;
+        std::vector<uint32_t>              m_colours;
+        std::vector<glm::uvec3>            m_triangles;
+        std::vector<std::vector<uint32_t>> m_vertexTriangles;
+        std::vector<uint32_t>              m_freeVertices;
+        std::vector<uint32_t>              m_freeTriangles;
+        std::vector<uint32_t>              m_dirtyVertices;
+        std::vector<uint32_t>              m_dirtyTriangles;
+
+        std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+        std::vector<uint64_t>                               m_vertexCells;
+        float                                               m_cellSize = 1.0f;
+    };
+} // namespace com::scene
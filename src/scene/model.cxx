@@ -6,12 +6,12 @@
 
 namespace com::scene
 {
-    Model::Model(std::unique_ptr<rhi::Mesh> mesh) : m_mesh(std::move(mesh)), m_transform(1.0f)
+    Model::Model(std::unique_ptr<rhi::Mesh> mesh, glm::mat4 const& transform) : m_mesh(std::move(mesh)), m_transform(transform)
     {
     }
 
     void Model::render(vk::CommandBuffer const& commandBuffer) const
     {
-        m_mesh->render(commandBuffer);
+        mesh()->render(commandBuffer);
     }
 } // namespace com::scene
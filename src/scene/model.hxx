@@ -6,7 +6,14 @@
 
 #include "rhi/mesh.hxx"
 #include "rhi/pipeline.hxx"
+#include "scene/brush-grid.hxx"
+#include "scene/bvh.hxx"
 #include "scene/camera.hxx"
+#include "scene/device-bvh.hxx"
+#include "scene/dynamic-topology.hxx"
+#include "scene/multires.hxx"
+
+#include <utility>
 
 namespace com::scene
 {
@@ -16,7 +23,15 @@ namespace com::scene
     public:
         /// Constructor.
         /// \param mesh The model's mesh,
-        explicit Model(std::unique_ptr<rhi::Mesh> mesh);
+        /// \param transform The model's transform.
+        explicit Model(std::unique_ptr<rhi::Mesh> mesh, glm::mat4 const& transform = glm::mat4(1.0f));
+
+        /// Accessor.
+        /// \return The grid that culls brush dispatches, if one has been built.
+        [[nodiscard]] auto brushGrid() const
+        {
+            return m_brushGrid.get();
+        }
 
         /// Get the bounding box of this mesh.
         /// \return A valid bounding box.
@@ -25,10 +40,85 @@ namespace com::scene
             return m_mesh ? m_mesh->bounds() : AABB();
         }
 
+        /// Accessor.
+        /// \return The hierarchy that picks the model on the device, if one has been uploaded.
+        [[nodiscard]] auto deviceBvh() const
+        {
+            return m_deviceBvh.get();
+        }
+
+        /// Accessor.
+        /// \return The topology that strokes adapt, if dynamic topology has been used on the model.
+        [[nodiscard]] auto dynamicTopology() const
+        {
+            return m_dynamicTopology.get();
+        }
+
+        /// Get the mesh that is sculpted, which is the sculpted multiresolution level if the model has been subdivided.
+        /// \param levelsDropped The number of multiresolution levels below the sculpted one to take the mesh from instead.
+        /// \return A valid pointer.
+        [[nodiscard]] auto mesh(uint32_t const levelsDropped = 0) const -> rhi::Mesh*
+        {
+            if (!m_multires)
+                return m_mesh.get();
+
+            return m_multires->mesh(m_multires->level() - std::min(levelsDropped, m_multires->level()));
+        }
+
+        /// Accessor.
+        /// \return The multiresolution levels, if the model has been subdivided.
+        [[nodiscard]] auto multires() const
+        {
+            return m_multires.get();
+        }
+
+        /// Accessor.
+        /// \return The hierarchy that picks the model on the CPU, if one has been built.
+        [[nodiscard]] auto bvh() const
+        {
+            return m_bvh.get();
+        }
+
         /// Render the model.
         /// \param commandBuffer The command buffer to write instructions to.
         void render(vk::CommandBuffer const& commandBuffer) const;
 
+        /// Set the grid that culls brush dispatches.
+        /// \param grid The grid.
+        /// \return The previous grid, which strokes in flight may still be using.
+        auto setBrushGrid(std::unique_ptr<BrushGrid> grid) -> std::unique_ptr<BrushGrid>
+        {
+            return std::exchange(m_brushGrid, std::move(grid));
+        }
+
+        /// Set the hierarchy that picks the model on the CPU.
+        /// \param bvh The hierarchy.
+        void setBvh(std::unique_ptr<Bvh> bvh)
+        {
+            m_bvh = std::move(bvh);
+        }
+
+        /// Set the hierarchy that picks the model on the device.
+        /// \param bvh The hierarchy.
+        void setDeviceBvh(std::unique_ptr<DeviceBvh> bvh)
+        {
+            m_deviceBvh = std::move(bvh);
+        }
+
+        /// Set the topology that strokes adapt.
+        /// \param topology The topology.
+        void setDynamicTopology(std::unique_ptr<DynamicTopology> topology)
+        {
+            m_dynamicTopology = std::move(topology);
+        }
+
+        /// Set the multiresolution levels, which must have been built over the model's mesh.
+        /// \param multires The levels.
+        void setMultires(std::unique_ptr<Multires> multires)
+        {
+            m_multires = std::move(multires);
+        }
+
         /// Accessor.
         /// \return A valid matrix.
         [[nodiscard]] auto transform() const
@@ -37,7 +127,12 @@ namespace com::scene
         }
 
     private:
-        std::unique_ptr<rhi::Mesh> m_mesh;
-        glm::mat4                  m_transform;
+        std::unique_ptr<rhi::Mesh>       m_mesh;
+        glm::mat4                        m_transform;
+        std::unique_ptr<BrushGrid>       m_brushGrid;
+        std::unique_ptr<Bvh>             m_bvh;
+        std::unique_ptr<DeviceBvh>       m_deviceBvh;
+        std::unique_ptr<DynamicTopology> m_dynamicTopology;
+        std::unique_ptr<Multires>        m_multires;
     };
 } // namespace com::scene
@@ -0,0 +1,95 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "scene/multires.hxx"
+#include "rhi/context.hxx"
+
+#include <algorithm>
+#include <set>
+
+namespace com::scene
+{
+    /// Pack an edge into a key that sorts by its lower vertex, then its higher one.
+    [[nodiscard]] static auto edgeKey(uint32_t const a, uint32_t const b)
+    {
+        return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+    }
+
+    Multires::Multires(rhi::Context* context, rhi::Mesh* base) : m_context(context), m_base(base)
+    {
+    }
+
+    auto Multires::subdivide(std::span<uint32_t const> const indices) -> std::vector<uint32_t>
+    {
+        auto const* highest     = mesh(levelCount() - 1);
+        auto const  vertexCount = highest->vertexCount();
+
+        // Triangles that dynamic topology removed have equal corners and are dropped.
+        std::vector<uint64_t> edges;
+        edges.reserve(indices.size());
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            if (indices[i] == indices[i + 1])
+                continue;
+
+            edges.emplace_back(edgeKey(indices[i + 0], indices[i + 1]));
+            edges.emplace_back(edgeKey(indices[i + 1], indices[i + 2]));
+            edges.emplace_back(edgeKey(indices[i + 2], indices[i + 0]));
+        }
+
+        std::ranges::sort(edges);
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        std::vector<glm::uvec2> parents(vertexCount + edges.size());
+        for (auto vertex = 0u; vertex < vertexCount; ++vertex)
+            parents[vertex] = glm::uvec2(vertex);
+
+        for (size_t edge = 0; edge < edges.size(); ++edge)
+            parents[vertexCount + edge] = glm::uvec2(static_cast<uint32_t>(edges[edge] >> 32), static_cast<uint32_t>(edges[edge]));
+
+        auto const midpoint = [&](uint32_t const a, uint32_t const b)
+        { return vertexCount + static_cast<uint32_t>(std::distance(edges.begin(), std::ranges::lower_bound(edges, edgeKey(a, b)))); };
+
+        // Each triangle becomes a triangle at each corner and one in the middle, all wound as it was.
+        std::vector<uint32_t> subdivided;
+        subdivided.reserve(4 * indices.size());
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            auto const a = indices[i + 0];
+            auto const b = indices[i + 1];
+            auto const c = indices[i + 2];
+            if (a == b)
+                continue;
+
+            auto const ab = midpoint(a, b);
+            auto const bc = midpoint(b, c);
+            auto const ca = midpoint(c, a);
+
+            subdivided.insert(subdivided.end(), { a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca });
+        }
+
+        // The displacements are written on the compute queue, after the parents have been uploaded on the transfer queue.
+        std::set<uint32_t>    queueSet = { m_context->queueIndex(rhi::QueueIndex::eCompute), m_context->queueIndex(rhi::QueueIndex::eTransfer) };
+        std::vector<uint32_t> sharedQueues;
+        if (queueSet.size() > 1)
+            sharedQueues.assign(queueSet.begin(), queueSet.end());
+
+        auto const usage  = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eTransferDst;
+        auto const memory = vk::MemoryPropertyFlagBits::eDeviceLocal;
+
+        // Strokes leave the bounds of the base cage as they were, so the levels are culled by them too.
+        Level level;
+        level.mesh = std::make_unique<rhi::Mesh>(m_context, static_cast<uint32_t>(parents.size()), static_cast<uint32_t>(subdivided.size()), m_base->bounds());
+        level.mesh->buffer(rhi::Mesh::BufferTypeIndex)->upload(subdivided);
+
+        level.buffers[BufferTypeParent] = std::make_unique<rhi::Buffer>(m_context, sizeof(glm::uvec2) * parents.size(), usage, memory, sharedQueues);
+        level.buffers[BufferTypeParent]->upload(parents);
+
+        level.buffers[BufferTypeDisplacement] = std::make_unique<rhi::Buffer>(m_context, sizeof(glm::vec3) * parents.size(), usage, memory, sharedQueues);
+
+        m_levels.emplace_back(std::move(level));
+
+        return subdivided;
+    }
+} // namespace com::scene
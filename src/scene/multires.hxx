@@ -0,0 +1,114 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include "rhi/mesh.hxx"
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+namespace com::scene
+{
+    /// A stack of subdivision levels over a model's mesh, which serves as the base cage, with what is sculpted on each level
+    /// kept as displacements.
+    ///
+    /// Each level splits every edge of the level below at its midpoint, so its first vertices are those of the level below,
+    /// in the same order, followed by one vertex per edge. Each vertex records the two vertices of the level below that it is
+    /// interpolated from, which are the same vertex for those carried over, and its displacement from that interpolation. The
+    /// brush engine keeps the levels consistent on the device after each stroke: the sculpted level is copied down and its
+    /// displacements stored, and the levels above it are rebuilt from theirs.
+    class Multires final
+    {
+    public:
+        /// Specifies the type of level buffer.
+        enum BufferType
+        {
+            BufferTypeParent,       ///< The two vertices of the level below that each vertex is interpolated from.
+            BufferTypeDisplacement, ///< The displacement of each vertex from the interpolation of its parents.
+            BufferTypeCount         ///< The number of buffers.
+        };
+
+    public:
+        /// Constructor.
+        /// \param context The RHI context.
+        /// \param base The mesh that serves as the base cage, which must outlive this.
+        explicit Multires(rhi::Context* context, rhi::Mesh* base);
+
+        /// Accessor.
+        /// \param level A level above the base cage.
+        /// \param type The type of buffer.
+        /// \return A valid pointer.
+        [[nodiscard]] auto buffer(uint32_t const level, BufferType const type) const
+        {
+            return m_levels[level - 1].buffers[type].get();
+        }
+
+        /// Determines if a level's displacements are yet to be cleared, which the brush engine does before it first reads them.
+        /// \param level A level above the base cage.
+        /// \return true if the displacements hold nothing yet; false otherwise.
+        [[nodiscard]] auto isCleared(uint32_t const level) const
+        {
+            return m_levels[level - 1].isCleared;
+        }
+
+        /// Accessor.
+        /// \return The level that is sculpted, where zero is the base cage.
+        [[nodiscard]] auto level() const
+        {
+            return m_level;
+        }
+
+        /// Get the number of levels, including the base cage.
+        /// \return A valid integer.
+        [[nodiscard]] auto levelCount() const
+        {
+            return static_cast<uint32_t>(m_levels.size()) + 1;
+        }
+
+        /// Accessor.
+        /// \param level The level, where zero is the base cage.
+        /// \return A valid pointer.
+        [[nodiscard]] auto mesh(uint32_t const level) const -> rhi::Mesh*
+        {
+            return level == 0 ? m_base : m_levels[level - 1].mesh.get();
+        }
+
+        /// Flag a level's displacements as cleared.
+        /// \param level A level above the base cage.
+        void setCleared(uint32_t const level)
+        {
+            m_levels[level - 1].isCleared = true;
+        }
+
+        /// Set the level that is sculpted.
+        /// \param level The level, which is clamped to those that exist.
+        void setLevel(uint32_t const level)
+        {
+            m_level = std::min(level, levelCount() - 1);
+        }
+
+        /// Add a level above the highest. Its topology is built on the CPU, and its vertices are left for the brush engine to
+        /// interpolate on the device.
+        /// \param indices The indices of the highest level, three per triangle.
+        /// \return The indices of the new level, from which a further level may be added without reading them back.
+        auto subdivide(std::span<uint32_t const> const indices) -> std::vector<uint32_t>;
+
+    private:
+        /// A subdivision level above the base cage.
+        struct Level final
+        {
+            std::unique_ptr<rhi::Mesh>                                mesh;              ///< The mesh.
+            std::array<std::unique_ptr<rhi::Buffer>, BufferTypeCount> buffers;           ///< The level's buffers.
+            bool                                                      isCleared = false; ///< Whether the displacements are zeroed.
+        };
+
+    private:
+        rhi::Context*      m_context = nullptr;
+        rhi::Mesh*         m_base    = nullptr;
+        std::vector<Level> m_levels;
+        uint32_t           m_level = 0;
+    };
+} // namespace com::scene
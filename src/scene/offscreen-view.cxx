@@ -0,0 +1,139 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "scene/offscreen-view.hxx"
+#include "rhi/per-frame-data.hxx"
+
+namespace com::scene
+{
+    /// The colour and depth clear values.
+    static std::array<vk::ClearValue, 2> const s_clearValues = { vk::ClearColorValue(0.2f, 0.2f, 0.2f, 1.0f), vk::ClearDepthStencilValue(0.0f, 0) };
+
+    OffscreenView::OffscreenView(rhi::Context* context, vk::Extent2D const& extent, uint32_t const framesInFlight) : m_context(context)
+    {
+        m_target = std::make_unique<rhi::RenderTarget>(m_context, extent);
+        m_camera = std::make_unique<Camera>(extent.width, extent.height);
+
+        m_context->allocatePerFrameData(std::max(framesInFlight, 1u));
+    }
+
+    OffscreenView::~OffscreenView()
+    {
+        // Frames in flight may still be rendering into the target.
+        m_context->waitForIdle();
+    }
+
+    auto OffscreenView::capture(Document* document) -> std::vector<uint32_t>
+    {
+        auto readback = std::make_unique<rhi::Buffer>(m_context, m_target->size(), vk::BufferUsageFlagBits::eTransferDst);
+        auto fence    = m_context->frameData()->fence();
+
+        renderFrame(document, readback.get());
+
+        m_context->waitForFences(fence);
+        readback->invalidate();
+
+        auto const* pixels = static_cast<uint32_t const*>(readback->data());
+        return { pixels, pixels + m_target->size() / sizeof(uint32_t) };
+    }
+
+    void OffscreenView::render(Document* document)
+    {
+        renderFrame(document, nullptr);
+    }
+
+    auto OffscreenView::stroke(Document* document, std::span<QPoint const> const points) -> uint32_t
+    {
+        auto hits = 0u;
+        for (auto const& point : points)
+        {
+            m_camera->setMode(CameraMode::Pick, point);
+            m_camera->track(point);
+
+            hits += document->placeCursor(m_camera.get(), point);
+            renderFrame(document, nullptr);
+        }
+
+        // A frame out of the pick mode ends the stroke.
+        m_camera->setMode(CameraMode::None);
+        renderFrame(document, nullptr);
+
+        return hits;
+    }
+
+    void OffscreenView::renderFrame(Document* document, rhi::Buffer* readback)
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        // The slot's previous frame must have completed before its command buffer and buffers are reused.
+        auto* frameData = m_context->frameData();
+        m_context->waitForFences(frameData->fence());
+        device.resetFences(frameData->fence());
+        frameData->commandPool()->reset();
+
+        auto       commandBuffer = frameData->commandBuffer();
+        auto const extent        = m_target->extent();
+
+        commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+        commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f));
+        commandBuffer.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), extent));
+
+        // Uploads recorded since the last frame are submitted before any work that reads them.
+        auto* stagingRing = m_context->stagingRing();
+        stagingRing->submit();
+
+        std::vector<rhi::WaitSemaphore> waitSemaphores;
+        if (document)
+        {
+            document->uploadUniforms(m_camera.get());
+            document->cull(m_camera.get());
+            document->updateHitTestQuery(m_camera.get(), m_target->rect());
+            waitSemaphores = document->updateBrush(m_camera.get());
+        }
+
+        // The cull pass reads uploaded records in a compute shader, ahead of any vertex input.
+        auto const uploadStages = vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eComputeShader;
+        waitSemaphores.emplace_back(stagingRing->waitSemaphore(uploadStages));
+
+        // The target's previous contents are never needed, as both attachments are cleared.
+        m_target->colour()->setUsage(rhi::Image::Usage::eUndefined);
+        m_target->depthStencil()->setUsage(rhi::Image::Usage::eUndefined);
+        m_target->colour()->transition(rhi::Image::Usage::eAttachmentReadWrite, commandBuffer);
+        m_target->depthStencil()->transition(rhi::Image::Usage::eAttachmentReadWrite, commandBuffer);
+
+        auto colourAttachment = m_target->colour()->asRenderingAttachmentInfo();
+        colourAttachment.setClearValue(s_clearValues[0]);
+
+        auto depthAttachment = m_target->depthStencil()->asRenderingAttachmentInfo();
+        depthAttachment.setClearValue(s_clearValues[1]);
+
+        vk::RenderingInfo renderInfo({}, m_target->rect(), 1u, 0, colourAttachment, &depthAttachment);
+        commandBuffer.beginRendering(renderInfo);
+
+        if (document)
+        {
+            document->render(commandBuffer);
+        }
+
+        commandBuffer.endRendering();
+
+        if (readback)
+        {
+            m_target->copyColour(commandBuffer, readback);
+
+            auto const barrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eTransfer,
+                                                    vk::AccessFlagBits2::eTransferWrite,
+                                                    vk::PipelineStageFlagBits2::eHost,
+                                                    vk::AccessFlagBits2::eHostRead);
+            commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, barrier, {}, {}));
+        }
+
+        commandBuffer.end();
+
+        m_context->queue(rhi::QueueIndex::eGraphics)->submit(commandBuffer, frameData, waitSemaphores, m_context->nextFrameSignal());
+        m_context->advanceNextFrame();
+    }
+
+} // namespace com::scene
@@ -0,0 +1,64 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include "rhi/render-target.hxx"
+#include "scene/camera.hxx"
+#include "scene/document.hxx"
+
+namespace com::scene
+{
+    /// Renders a document into an offscreen target, for use with a headless context, e.g., by benchmarks and batch jobs.
+    class OffscreenView final
+    {
+    public:
+        /// Constructor.
+        /// \param context The RHI context.
+        /// \param extent The physical extent of the view, which must match that of the documents rendered.
+        /// \param framesInFlight The number of frames the CPU may record ahead of the GPU.
+        explicit OffscreenView(rhi::Context* context, vk::Extent2D const& extent, uint32_t const framesInFlight = 2);
+
+        /// Destructor.
+        ~OffscreenView();
+
+        /// Accessor.
+        /// \return A valid pointer.
+        [[nodiscard]] auto camera() const
+        {
+            return m_camera.get();
+        }
+
+        /// Render a frame and read back its colour image.
+        /// \param document The document.
+        /// \return The pixels of the frame, in the context's colour format.
+        [[nodiscard]] auto capture(Document* document) -> std::vector<uint32_t>;
+
+        /// Render a frame. The frame is submitted, but may still be in flight when this returns.
+        /// \param document The document.
+        void render(Document* document);
+
+        /// Apply a stroke through a sequence of points, rendering a frame for each. The cursor is placed by picking on the CPU
+        /// rather than by the hit-test pass, so each point is sculpted by its own frame.
+        /// \param document The document.
+        /// \param points The points in the view.
+        /// \return The number of points that were over a model.
+        auto stroke(Document* document, std::span<QPoint const> const points) -> uint32_t;
+
+        /// Accessor.
+        /// \return A valid pointer.
+        [[nodiscard]] auto target() const
+        {
+            return m_target.get();
+        }
+
+    private:
+        void renderFrame(Document* document, rhi::Buffer* readback);
+
+    private:
+        rhi::Context*                      m_context = nullptr;
+        std::unique_ptr<rhi::RenderTarget> m_target;
+        std::unique_ptr<Camera>            m_camera;
+    };
+} // namespace com::scene
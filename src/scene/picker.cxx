@@ -0,0 +1,183 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#include "scene/picker.hxx"
+#include "rhi/shaders/picking.hxx"
+#include "rhi/utilities.hxx"
+
+namespace com::scene
+{
+    Picker::Picker(rhi::Context* context) : m_context(context)
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        m_commandPool = std::make_unique<rhi::CommandPool>(m_context->device(), m_context->queueIndex(rhi::QueueIndex::eCompute));
+        m_fence       = device.createFence(vk::FenceCreateInfo());
+
+        // The trees, rays and results are addressed directly, so the pipeline has no descriptor sets.
+        auto const pushConstants = vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(PickUniform));
+        m_pipelineLayout         = device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, {}, pushConstants));
+
+        m_shader   = rhi::createShader(device, "pick.comp");
+        m_pipeline = rhi::createComputePipeline(m_context, m_shader, m_pipelineLayout);
+
+        // Refit; the tree and the vertices are addressed directly too.
+        auto const refitPushConstants = vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(BvhRefitUniform));
+        m_refitPipelineLayout         = device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, {}, refitPushConstants));
+
+        m_refitShader   = rhi::createShader(device, "bvh-refit.comp");
+        m_refitPipeline = rhi::createComputePipeline(m_context, m_refitShader, m_refitPipelineLayout);
+    }
+
+    Picker::~Picker()
+    {
+        auto const& device = m_context->device()->logicalDevice();
+
+        m_rays.reset();
+        m_results.reset();
+
+        device.destroyPipeline(m_refitPipeline);
+        device.destroyShaderModule(m_refitShader);
+        device.destroyPipelineLayout(m_refitPipelineLayout);
+
+        device.destroyPipeline(m_pipeline);
+        device.destroyShaderModule(m_shader);
+        device.destroyPipelineLayout(m_pipelineLayout);
+        device.destroyFence(m_fence);
+
+        m_commandPool.reset();
+    }
+
+    auto Picker::pick(std::vector<std::unique_ptr<Model>> const& models, std::span<Ray const> const rays) -> std::vector<std::optional<PickHit>>
+    {
+        std::vector<std::optional<PickHit>> hits(rays.size());
+        if (rays.empty())
+            return hits;
+
+        reserve(rays.size());
+
+        // The rays and results are host-visible, so they are written and read in place.
+        auto* pickRays    = static_cast<PickRay*>(m_rays->data());
+        auto* pickResults = static_cast<PickResult*>(m_results->data());
+        for (size_t i = 0; i < rays.size(); ++i)
+        {
+            pickRays[i]             = { rays[i].origin, std::numeric_limits<float>::max(), rays[i].direction, 0.0f };
+            pickResults[i]          = {};
+            pickResults[i].triangle = PICK_NO_HIT;
+        }
+
+        m_rays->flush();
+        m_results->flush();
+
+        m_commandPool->reset();
+
+        auto const& commandBuffer = m_commandPool->commandBuffer();
+        commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+        // Strokes are submitted to the same queue, so this makes the vertices they have moved visible to the refits and the traversal.
+        auto const strokeBarrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eComputeShader,
+                                                      vk::AccessFlagBits2::eShaderStorageWrite,
+                                                      vk::PipelineStageFlagBits2::eComputeShader,
+                                                      vk::AccessFlagBits2::eShaderStorageRead);
+        commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, strokeBarrier, {}, {}));
+
+        for (auto const& model : models)
+        {
+            if (auto* bvh = model->deviceBvh(); bvh && bvh->mesh() == model->mesh() && bvh->isStale())
+                refit(commandBuffer, bvh);
+        }
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+
+        PickUniform constants = {};
+        constants.rays        = m_rays->deviceAddress();
+        constants.results     = m_results->deviceAddress();
+        constants.ray_count   = static_cast<uint32_t>(rays.size());
+
+        for (size_t i = 0; i < models.size(); ++i)
+        {
+            auto const* bvh = models[i]->deviceBvh();
+            if (!bvh || bvh->mesh() != models[i]->mesh() || bvh->levels().empty())
+                continue;
+
+            constants.to_object = glm::inverse(models[i]->transform());
+            constants.nodes     = bvh->buffer(DeviceBvh::BufferTypeNode)->deviceAddress();
+            constants.triangles = bvh->buffer(DeviceBvh::BufferTypeTriangle)->deviceAddress();
+            constants.order     = bvh->buffer(DeviceBvh::BufferTypeOrder)->deviceAddress();
+            constants.positions = bvh->mesh()->buffer(rhi::Mesh::BufferTypeEditVertex)->deviceAddress();
+            constants.model     = static_cast<uint32_t>(i);
+
+            // Each model reads the results of the previous one, and only replaces those that it hits nearer.
+            commandBuffer.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PickUniform), &constants);
+            commandBuffer.dispatch((constants.ray_count + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+            auto const barrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eComputeShader,
+                                                    vk::AccessFlagBits2::eShaderStorageWrite,
+                                                    vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eHost,
+                                                    vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eHostRead);
+            commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, barrier, {}, {}));
+        }
+
+        commandBuffer.end();
+
+        // The trees may have been uploaded by the staging ring.
+        auto const uploads = m_context->stagingRing()->waitSemaphore(vk::PipelineStageFlagBits::eComputeShader);
+
+        m_context->queue(rhi::QueueIndex::eCompute)->submit(commandBuffer, vk::Semaphore(), m_fence, { uploads });
+        m_context->waitForFences(m_fence);
+        m_context->device()->logicalDevice().resetFences(m_fence);
+
+        m_results->invalidate();
+
+        for (size_t i = 0; i < rays.size(); ++i)
+        {
+            auto const& result = pickResults[i];
+            if (result.triangle != PICK_NO_HIT)
+                hits[i] = PickHit{ result.position, result.normal, result.triangle, result.model };
+        }
+
+        return hits;
+    }
+
+    void Picker::refit(vk::CommandBuffer const& commandBuffer, DeviceBvh* bvh)
+    {
+        BvhRefitUniform constants = {};
+        constants.nodes           = bvh->buffer(DeviceBvh::BufferTypeNode)->deviceAddress();
+        constants.triangles       = bvh->buffer(DeviceBvh::BufferTypeTriangle)->deviceAddress();
+        constants.positions       = bvh->mesh()->buffer(rhi::Mesh::BufferTypeEditVertex)->deviceAddress();
+        constants.level_nodes     = bvh->buffer(DeviceBvh::BufferTypeLevelNode)->deviceAddress();
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_refitPipeline);
+
+        // Each level reads the bounds of the level below it, and the traversal reads the root.
+        for (auto const& level : bvh->levels())
+        {
+            constants.first = level.x;
+            constants.count = level.y;
+
+            commandBuffer.pushConstants(m_refitPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(BvhRefitUniform), &constants);
+            commandBuffer.dispatch((level.y + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+            auto const barrier = vk::MemoryBarrier2(vk::PipelineStageFlagBits2::eComputeShader,
+                                                    vk::AccessFlagBits2::eShaderStorageWrite,
+                                                    vk::PipelineStageFlagBits2::eComputeShader,
+                                                    vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite);
+            commandBuffer.pipelineBarrier2KHR(vk::DependencyInfo({}, barrier, {}, {}));
+        }
+
+        bvh->setStale(false);
+    }
+
+    void Picker::reserve(size_t const count)
+    {
+        if (count <= m_capacity)
+            return;
+
+        m_capacity = std::max(count, 2 * m_capacity);
+
+        auto const usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+        m_rays           = std::make_unique<rhi::Buffer>(m_context, sizeof(PickRay) * m_capacity, usage);
+        m_results        = std::make_unique<rhi::Buffer>(m_context, sizeof(PickResult) * m_capacity, usage);
+    }
+} // namespace com::scene
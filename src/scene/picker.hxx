@@ -0,0 +1,61 @@
+//
+// Copyright(c) 2024 Jamie Kenyon. All Rights Reserved.
+//
+
+#pragma once
+
+#include "rhi/command-pool.hxx"
+#include "scene/model.hxx"
+
+#include <optional>
+
+namespace com::scene
+{
+    /// Where a ray cast on the device hits a model.
+    struct PickHit final
+    {
+        glm::vec3 point;        ///< The world-space position.
+        glm::vec3 normal;       ///< The world-space unit normal, which faces the ray.
+        uint32_t  triangle = 0; ///< The index of the triangle in the model's mesh.
+        uint32_t  model    = 0; ///< The index of the model.
+    };
+
+    /// Casts rays into models on the device, by traversing their device BVHs in a compute shader. This is an alternative to
+    /// rendering a hit-test pass: it needs no attachments, any number of rays may be cast at once, and only the results are
+    /// read back. Trees that strokes have left stale are refit in the same submission, before they are traversed.
+    class Picker final
+    {
+    public:
+        /// Constructor.
+        /// \param context The RHI context.
+        explicit Picker(rhi::Context* context);
+
+        /// Destructor.
+        ~Picker();
+
+        /// Cast rays into the models that have a device BVH, and wait for the results. This must not be called whilst a
+        /// stroke is being recorded, as it is submitted to the same queue.
+        /// \param models The models.
+        /// \param rays The world-space rays.
+        /// \return The nearest hit of each ray, if it hit anything.
+        [[nodiscard]] auto pick(std::vector<std::unique_ptr<Model>> const& models, std::span<Ray const> const rays) -> std::vector<std::optional<PickHit>>;
+
+    private:
+        void refit(vk::CommandBuffer const& commandBuffer, DeviceBvh* bvh);
+        void reserve(size_t const count);
+
+    private:
+        rhi::Context*                     m_context = nullptr;
+        std::unique_ptr<rhi::CommandPool> m_commandPool;
+        vk::Fence                         m_fence;
+        vk::PipelineLayout                m_pipelineLayout;
+        vk::ShaderModule                  m_shader;
+        vk::Pipeline                      m_pipeline;
+        vk::PipelineLayout                m_refitPipelineLayout;
+        vk::ShaderModule                  m_refitShader;
+        vk::Pipeline                      m_refitPipeline;
+        std::unique_ptr<rhi::Buffer>      m_rays;
+        std::unique_ptr<rhi::Buffer>      m_results;
+        size_t                            m_capacity = 0;
+    };
+} // namespace com::scene
@@ -15,6 +15,9 @@
 
 namespace com::ui
 {
+    /// The time a transient status message is shown for, in milliseconds.
+    static constexpr int s_statusTimeout = 3000;
+
     MainWindow::MainWindow(std::string const& appName, uint32_t const appVersion, QWidget* parent, Qt::WindowFlags flags) : QMainWindow(parent, flags)
     {
         m_ui = std::make_unique<Ui::MainWindow>();
@@ -58,6 +61,23 @@ namespace com::ui
         m_ui->m_fileMenuClose->setEnabled(enabled);
         m_ui->m_fileMenuSave->setEnabled(enabled);
         m_ui->m_fileMenuSaveAs->setEnabled(enabled);
+        updateSculptActions();
+
+        if (document)
+        {
+            connect(document,
+                    &scene::Document::saveProgress,
+                    this,
+                    [this](int percent) { m_ui->m_statusBar->showMessage(tr("SavingDocument").arg(percent)); });
+            connect(document,
+                    &scene::Document::saveFinished,
+                    this,
+                    [this](bool isSuccess)
+                    {
+                        m_ui->m_statusBar->showMessage(isSuccess ? tr("DocumentSaved") : tr("DocumentSaveFailed"), s_statusTimeout);
+                        updateWindowTitle();
+                    });
+        }
     }
 
     void MainWindow::onFileClose()
@@ -123,6 +143,25 @@ namespace com::ui
         dialog->show();
     }
 
+    void MainWindow::onSculptLevelDown()
+    {
+        m_document->setMultiresLevel(m_document->multiresLevel() - 1);
+        showMultiresLevel();
+    }
+
+    void MainWindow::onSculptLevelUp()
+    {
+        m_document->setMultiresLevel(m_document->multiresLevel() + 1);
+        showMultiresLevel();
+    }
+
+    void MainWindow::onSculptSubdivide()
+    {
+        m_document->subdivide();
+        showMultiresLevel();
+        updateWindowTitle();
+    }
+
     void MainWindow::createDocks()
     {
         // Create the first panel.
@@ -156,6 +195,16 @@ namespace com::ui
 
     void MainWindow::fileOpen(QString const& path)
     {
+        if (!fileSave())
+            return;
+
+        auto document = scene::Document::open(m_viewport->context(), m_viewport->extent(), path);
+        if (!document)
+            return;
+
+        m_document = std::move(document);
+        emit documentReplaced(m_document.get());
+
         updateRecentFileActions(path);
         updateWindowTitle();
     }
@@ -218,6 +267,23 @@ namespace com::ui
         }
     }
 
+    void MainWindow::showMultiresLevel()
+    {
+        updateSculptActions();
+        m_ui->m_statusBar->showMessage(tr("MultiresLevel").arg(m_document->multiresLevel()).arg(m_document->multiresLevelCount() - 1), s_statusTimeout);
+        m_viewport->requestUpdate();
+    }
+
+    void MainWindow::updateSculptActions()
+    {
+        auto const level = m_document ? m_document->multiresLevel() : 0u;
+        auto const count = m_document ? m_document->multiresLevelCount() : 1u;
+
+        m_ui->m_sculptMenuSubdivide->setEnabled(m_document != nullptr);
+        m_ui->m_sculptMenuLevelUp->setEnabled(level + 1 < count);
+        m_ui->m_sculptMenuLevelDown->setEnabled(level > 0);
+    }
+
     void MainWindow::updateWindowTitle()
     {
         QString title = QCoreApplication::applicationName();
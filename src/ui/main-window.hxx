@@ -57,6 +57,9 @@ namespace com::ui
         void onFileSaveAs();
         void onHelpErrorLog();
         void onHelpAbout();
+        void onSculptLevelDown();
+        void onSculptLevelUp();
+        void onSculptSubdivide();
 
     private:
         void               createDocks();
@@ -66,7 +69,9 @@ namespace com::ui
         void               fileSaveAs(QString const& path);
         void               readSettings();
         void               updateRecentFileActions(QString const& path = {});
+        void               updateSculptActions();
         [[nodiscard]] auto save() -> bool;
+        void               showMultiresLevel();
         void               updateWindowTitle();
         void               writeSettings();
 
@@ -3,6 +3,7 @@
 //
 
 #include "ui/viewport.hxx"
+#include "base/preferences.hxx"
 #include "rhi/utilities.hxx"
 #include "ui/main-window.hxx"
 
@@ -51,6 +52,12 @@ namespace com::ui
 
         description.deviceFeatures.samplerAnisotropy = VK_TRUE;
 
+        // The draw list packs each meshlet's record into its first instance, draws every meshlet from one indirect count, and
+        // the shaders address the vertex streams with 64-bit pointers.
+        description.deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+        description.deviceFeatures.multiDrawIndirect         = VK_TRUE;
+        description.deviceFeatures.shaderInt64               = VK_TRUE;
+
 #if defined(Q_OS_DARWIN)
         description.windowHandle = makeViewMetalCompatible(winId());
 #else
@@ -169,6 +176,8 @@ namespace com::ui
 
             if (m_context)
             {
+                // Frames in flight may still be using the swap chain's images.
+                m_context->waitForIdle();
                 m_swapChain.reset();
 
                 vk::Extent2D const extent(m_size.width(), m_size.height());
@@ -179,8 +188,7 @@ namespace com::ui
                     m_document->resize(extent);
                 }
 
-                m_context->allocatePerFrameData(m_swapChain->numImages());
-
+                allocatePerFrameData();
                 render();
             }
         }
@@ -210,8 +218,26 @@ namespace com::ui
         requestUpdate();
     }
 
+    void Viewport::allocatePerFrameData()
+    {
+        auto const framesInFlight = base::Preferences::read(base::PreferenceType::FramesInFlight).toUInt();
+        auto const frameCount     = std::clamp(framesInFlight, 1u, m_swapChain->numImages());
+        if (frameCount == m_context->frameCount())
+            return;
+
+        m_context->allocatePerFrameData(frameCount);
+
+        // The document's descriptor sets are written per frame.
+        if (m_document)
+        {
+            m_document->resize(m_swapChain->extent());
+        }
+    }
+
     void Viewport::frameStart()
     {
+        // The slot's previous frame must have completed before its command buffer and buffers are reused.
+        m_context->waitForFences(m_context->frameData()->fence());
         m_swapChain->acquireNextFrame(m_context->frameData());
 
         auto*      frameData     = m_context->frameData();
@@ -224,11 +250,22 @@ namespace com::ui
         commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f));
         commandBuffer.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), extent));
 
+        // Uploads recorded since the last frame are submitted before any work that reads them.
+        auto* stagingRing = m_context->stagingRing();
+        stagingRing->submit();
+
         if (m_document)
         {
+            m_document->uploadUniforms(m_camera.get());
+            m_document->cull(m_camera.get());
             m_document->updateHitTestQuery(m_camera.get(), m_swapChain->rect());
+            m_waitSemaphores = m_document->updateBrush(m_camera.get());
         }
 
+        // The cull pass reads uploaded records in a compute shader, ahead of any vertex input.
+        auto const uploadStages = vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eComputeShader;
+        m_waitSemaphores.emplace_back(stagingRing->waitSemaphore(uploadStages));
+
         m_swapChain->image(frameData->imageIndex())->transition(rhi::Image::Usage::eAttachmentReadWrite, commandBuffer);
         m_swapChain->depthStencil()->transition(rhi::Image::Usage::eAttachmentReadWrite, commandBuffer);
     }
@@ -253,7 +290,7 @@ namespace com::ui
 
         if (m_document)
         {
-            m_document->render(m_camera.get(), commandBuffer);
+            m_document->render(commandBuffer);
         }
 
         commandBuffer.endRendering();
@@ -262,9 +299,8 @@ namespace com::ui
 
         commandBuffer.end();
 
-        m_context->queue(rhi::QueueIndex::eGraphics)->submit(commandBuffer, frameData);
-
-        m_context->waitForFences(frameData->fence());
+        m_context->queue(rhi::QueueIndex::eGraphics)->submit(commandBuffer, frameData, m_waitSemaphores, m_context->nextFrameSignal());
+        m_waitSemaphores.clear();
     }
 
     void Viewport::frameEnd()
@@ -277,11 +313,18 @@ namespace com::ui
     {
         if (m_swapChain)
         {
+            // The preference may have changed since the last frame.
+            allocatePerFrameData();
+
             frameStart();
             frameRender();
             frameEnd();
         }
 
+        // Hits are read back a frame or more after they are requested, so rendering continues until they have arrived.
+        if (m_document && m_document->isHitPending())
+            requestUpdate();
+
         if (!m_convergence)
         {
             // When a new documented is opened, the scene renders but doesn't display anything. I
@@ -70,6 +70,7 @@ namespace com::ui
         void onDocumentReplaced(scene::Document* document);
 
     private:
+        void               allocatePerFrameData();
         void               frameStart();
         void               frameRender();
         void               frameEnd();
@@ -82,7 +83,8 @@ namespace com::ui
         std::unique_ptr<rhi::SwapChain> m_swapChain;
         std::unique_ptr<scene::Camera>  m_camera;
 
-        bool             m_convergence = false;
-        scene::Document* m_document    = nullptr;
+        bool                            m_convergence = false;
+        scene::Document*                m_document    = nullptr;
+        std::vector<rhi::WaitSemaphore> m_waitSemaphores;
     };
 } // namespace com::ui